@@ -16,7 +16,8 @@ public:
 	virtual void handleInput(const sf::Event &event) = 0;
 	//Processes the state logic to move the state forward a tick.
 	//	deltaTime : The amount of time that has passed since the last update.
-	virtual void update(const sf::Time &deltaTime) = 0;
+	//Returns whether the tick ran; false if the state is waiting on something outside the game, i.e. the peer in lockstep.
+	virtual bool update(const sf::Time &deltaTime) = 0;
 
 	//Update the state's view, i.e. fix the GUI, and other elements, from a window resize.
 	virtual void updateView() = 0;
@@ -0,0 +1,36 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * A command given to a battle by a player; whether from the local input, or received over the network.
+ * Commands are stamped with the tick they are for, and applied by the simulation at the start of that tick;
+ * so a command never changes the battle part way through a tick, whichever thread it arrived on.
+ */
+#pragma once
+
+#include <cstdint> //For the tick stamp.
+#include <vector> //For the turrets of a created ship.
+
+#include "Turret.hpp" //For the turrets of a created ship.
+
+//What a command orders the battle to do.
+enum class CommandType : std::uint8_t
+{
+	CREATE_SHIP,
+	MOVE,
+	FIRE
+};
+
+//An order given to the battle, to be applied at the start of a tick.
+struct BattleCommand
+{
+	CommandType type = CommandType::MOVE; //What the command orders the battle to do.
+	std::uint32_t tick = 0; //The tick the command is applied at the start of; applied at the next tick if that has already passed.
+
+	unsigned int shipLayer = 0; //The layer of the ship being ordered, or created; i.e. which team.
+	unsigned int shipID = 0; //The ID of the ship in the team being ordered; unused when creating a ship.
+	sf::Vector2f position; //Where to move to, or shoot at; or where a created ship starts.
+
+	unsigned int targetLayer = 0; //The layer to shoot on; only used by fire commands.
+	float angle = 0; //The rotation a created ship starts at; only used when creating a ship.
+	std::vector<TurretInfo> turrets; //The turrets a created ship starts with; only used when creating a ship.
+};
@@ -0,0 +1,138 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Runs the ticks of a BattleSimulation, with the commands for each, and networks them with the peer; everything of a battle but the window.
+ * Used by BattleState, and by tools that run networked battles without one.
+ * Commands from the local player, and from the network thread, are queued on lock-free queues stamped with their tick;
+ * they are applied at the start of the tick they are for, so nothing changes the simulation while it is being updated.
+ * In a networked battle, the messages for the peer given during each tick are closed into a frame stamped with the tick, once it runs.
+ * In a lockstep battle, a tick is only run once the peer has sent the frame that marks it done; until then, the battle waits on the peer.
+ * Each peer also sends the hash of its battle every so often; on the first hash that differs from the peer's, both peers dump their battle
+ * to a file at the same tick, for diffing.
+ */
+#pragma once
+
+#include <atomic> //For the tick read by the network thread.
+#include <deque> //For the hashes sent to the peer.
+
+#include "BattleSimulation.hpp" //For the simulation being run.
+#include "SpscQueue.hpp" //For handing commands to the simulation.
+
+class NetworkManager; //Declaration of NetworkManager for declaration of BattleSession.
+
+//Runs a battle's ticks, and networks them with the peer.
+class BattleSession
+{
+public:
+	//Basic BattleSession constructor.
+	//	simulation : The simulation being run; must outlive the session.
+	//	network : Networks the battle with the peer; null for a battle on one machine.
+	BattleSession(BattleSimulation &simulation, NetworkManager *network = nullptr);
+
+	//Creates the local player's ship where the network manager starts it; only for a networked battle, before the network thread starts.
+	//In lockstep, the ship is created at the first tick; otherwise, at once.
+	//	turrets : The turrets the ship starts with.
+	void createLocalShip(const std::vector<TurretInfo> &turrets);
+
+	//Runs the next tick, after applying the commands for it; unless, in lockstep, the peer has not marked it done yet.
+	//	deltaTime : The amount of time the tick lasts.
+	//Returns whether the tick was run.
+	bool update(const sf::Time &deltaTime);
+
+	//Queues a command from the local player for their ship, to be applied at the start of the next tick; or after the input delay in lockstep.
+	//The command is also sent to the peer in a networked battle, if it was queued. Only call from the thread running the battle.
+	//	type : What the command orders the ship to do.
+	//	position : Where to move to, or shoot at.
+	//	targetLayer : The layer to shoot on; only used by fire commands.
+	//Returns whether there was room for the command.
+	bool queueLocalCommand(CommandType type, const sf::Vector2f &position, unsigned int targetLayer = 0);
+	//Queues a command received from the peer, to be applied at the start of the tick it is stamped with; only call from the network thread.
+	//	command : The command received; left unchanged if the queue is full.
+	//Returns whether there was room for the command.
+	bool queueRemoteCommand(BattleCommand &&command);
+	//Queues the hash of the peer's battle at the end of a tick, to be checked against our own; only call from the network thread.
+	//	tick : The tick the hash is of.
+	//	hash : The hash of the peer's battle at the end of the tick.
+	//Returns whether there was room for the hash; a hash that is dropped is simply not checked.
+	bool queueRemoteHash(std::uint32_t tick, std::uint64_t hash);
+
+	//Marks every command the peer gives for the tick, and those before it, as received; only call from the network thread.
+	//	tick : The tick the peer has sent every command for.
+	void confirmRemoteTick(std::uint32_t tick);
+
+	//Returns the tick the simulation runs next; safe to call from any thread.
+	std::uint32_t getTick() const;
+	//Returns the layer the local player's ship is on.
+	unsigned int getLocalLayer() const;
+	//Returns how many move, and fire, commands have been applied to the local player's ship, and to the peer's ship; for measuring latency.
+	//	isRemote : Whether to count the peer's ship.
+	std::uint64_t getOrdersApplied(bool isRemote) const;
+	//Returns whether a hash from the peer has differed from ours.
+	bool isDesynced() const;
+private:
+	//The hash of a battle's state at the end of a tick.
+	struct TickHash
+	{
+		std::uint32_t tick; //The tick the hash is of.
+		std::uint64_t hash; //The hash of the battle's state at the end of the tick.
+	};
+
+	static constexpr std::size_t COMMAND_CAPACITY = 1024; //How many commands each queue holds before the sender has to wait.
+	static constexpr std::uint32_t HASH_INTERVAL = 30; //How many ticks pass between each hash sent to the peer; only in lockstep.
+	static constexpr std::size_t HASH_HISTORY = 16; //How many of the hashes sent to the peer are kept, to check the peer's hashes against.
+
+	BattleSimulation &m_simulation; //The simulation being run.
+	NetworkManager *m_network; //Networks the battle with the peer; null for a battle on one machine.
+
+	SpscQueue<BattleCommand> m_localCommands{COMMAND_CAPACITY}; //Commands from the local player's input.
+	SpscQueue<BattleCommand> m_remoteCommands{COMMAND_CAPACITY}; //Commands received from the peer by the network thread.
+	std::vector<BattleCommand> m_pendingCommands; //Commands taken from the queues that are stamped for a later tick.
+	std::atomic<std::uint32_t> m_tick{0}; //The tick the simulation runs next; published for the network thread to stamp commands with.
+
+	bool m_isLockstep = false; //Whether the battle is networked in lockstep; ticks wait on the peer, and commands are delayed.
+	unsigned int m_inputDelay = 0; //How many ticks after a local command is given it is carried out; only used in lockstep.
+	unsigned int m_localLayer = 0; //The layer the local player's ship is on.
+	//The last tick the peer has sent every command for; -1 before the peer has marked any.
+	std::atomic<std::int64_t> m_remoteConfirmedTick{-1};
+	std::uint64_t m_ordersApplied[2] = {0, 0}; //How many move, and fire, commands have been applied; to the local player's ship, then the peer's.
+
+	SpscQueue<TickHash> m_remoteHashes{HASH_HISTORY}; //Hashes received from the peer by the network thread.
+	std::vector<TickHash> m_pendingRemoteHashes; //Hashes from the peer of ticks we have not run yet.
+	std::deque<TickHash> m_localHashes; //The last hashes sent to the peer; oldest first.
+	bool m_isDesynced = false; //Whether a hash from the peer has differed from ours.
+	bool m_isDesyncDumped = false; //Whether the battle has been dumped since it desynced.
+	TickHash m_desync; //The first of our hashes that differed from the peer's.
+	std::uint64_t m_desyncRemoteHash = 0; //The peer's hash for the tick of m_desync.
+	std::uint32_t m_desyncDumpTick = 0; //The tick the battle is dumped at the start of; the same for both peers.
+
+	//Applies every queued command that is stamped for this tick, or an earlier one; called at the start of each tick.
+	void applyCommands();
+	//Checks the peer's hashes of the ticks we have run against our own, and dumps the battle once it reaches the dump tick of a mismatch.
+	//Called at the start of each tick in lockstep.
+	void checkStateHashes();
+};
+
+//Returns the tick the simulation runs next; safe to call from any thread.
+inline std::uint32_t BattleSession::getTick() const
+{
+	return m_tick.load(std::memory_order_relaxed);
+}
+
+//Returns the layer the local player's ship is on.
+inline unsigned int BattleSession::getLocalLayer() const
+{
+	return m_localLayer;
+}
+
+//Returns how many move, and fire, commands have been applied to the local player's ship, and to the peer's ship; for measuring latency.
+//	isRemote : Whether to count the peer's ship.
+inline std::uint64_t BattleSession::getOrdersApplied(bool isRemote) const
+{
+	return m_ordersApplied[isRemote ? 1 : 0];
+}
+
+//Returns whether a hash from the peer has differed from ours.
+inline bool BattleSession::isDesynced() const
+{
+	return m_isDesynced;
+}
@@ -0,0 +1,215 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * The window-free simulation of a battle; owns the ships and projectiles, and advances them a tick at a time.
+ * Never touches the window or the GPU itself, so it may be run headless; i.e. on a build server for balancing and regression runs.
+ * The presentation layer (BattleState) is handed a render snapshot of each tick instead; so drawing never reads, or locks, the simulation.
+ *
+ * Given a JobSystem, a tick is spread over its workers; the ships are updated in parallel, and the projectiles moved, and tested for hits, in parallel.
+ * Hits are then applied in the same order as the serial tick, re-testing any ship already hit that tick; so the result is bit-identical to it.
+ * Turrets push their shots onto the battle's lock-free shot queue from whichever worker updates them; it is drained in fire order next tick.
+ * The state of the battle is hashed at the end of every tick; two battles given the same commands must have the same hash every tick.
+ */
+#pragma once
+
+#include <iosfwd> //For dumping the battle's state.
+#include <memory> //For smart pointers.
+#include <vector> //For the ship and projectile lists.
+
+#include "BattleCommand.hpp" //For the commands given by the players.
+#include "Ship.hpp" //For the ships that fight in the battle.
+#include "ShipGrid.hpp" //For the broad-phase of projectile collision.
+#include "JobSystem.hpp" //For spreading a tick over several threads.
+#include "ShotQueue.hpp" //For the shots fired by the turrets.
+
+//Counts of the projectile-ship pairs considered for collision during a tick.
+struct CollisionStats
+{
+	std::size_t bruteForcePairs = 0; //Pairs that would be tested without the grid; every projectile against every ship on its layer.
+	std::size_t candidatePairs = 0; //Pairs the grid passed on to be tested; ships in the cells the projectile overlaps.
+};
+
+//Simulates a battle between two layers of ships; creates and resolves projectiles, and processes each game tick.
+class BattleSimulation
+{
+public:
+	//Basic BattleSimulation constructor.
+	//	hullKey : Pristine collision key of the hull every ship is built from; shared by the ships, so it must outlive the battle.
+	//	jobs : Workers to spread each tick over; nullptr to run every tick on the calling thread. Must outlive the battle.
+	BattleSimulation(const DamageMask &hullKey, JobSystem *jobs = nullptr);
+
+	//Processes the battle to move it forward a tick.
+	//	deltaTime : The amount of time that has passed since the last update.
+	void update(const sf::Time &deltaTime);
+	//Copies how the battle looks as of this tick into the snapshot; reuses the snapshot's memory where it can.
+	//Only call from the thread updating the battle.
+	//	snapshot : The snapshot to fill.
+	void fillSnapshot(RenderSnapshot &snapshot) const;
+
+	//Creates a ship with the passed information.
+	//	team : The team the ship belongs to.
+	//	position : Where the ship should start on creation.
+	//	angle : The rotation of the ship on creation.
+	//	turretBuildList : The turrets the ship should start with.
+	void createShip(unsigned int team, const sf::Vector2f &position, float angle, const std::vector<TurretInfo> &turretBuildList = std::vector<TurretInfo>());
+
+	//Writes the state of the battle as text, with exact floats; so the dumps of two diverged battles may be diffed.
+	//Only call from the thread updating the battle.
+	//	stream : The stream to write to.
+	void dumpState(std::ostream &stream) const;
+
+	//Carries out the command on the battle; commands to ships that no longer exist are ignored.
+	//Only call between ticks, from the thread updating the battle.
+	//	command : The command to carry out.
+	void applyCommand(const BattleCommand &command);
+
+	//Passes a move command to the specified ship.
+	//	shipLayer : The layer the ship is on; i.e. which team.
+	//	shipID : The ID of the ship in the team.
+	//	destination : Where the ship is being told to head to.
+	void issueMoveCommand(unsigned int shipLayer, unsigned int shipID, const sf::Vector2f &destination);
+	//Passes a fire command to the specified ship.
+	//	shipLayer : The layer the ship is on; i.e. which team.
+	//	shipID : The ID of the ship in the team.
+	//	target : Where the ship is being told to shoot at.
+	//	targetLayer : Which layer the ship is being told to shoot on.
+	void issueFireCommand(unsigned int shipLayer, unsigned int shipID, const sf::Vector2f &target, unsigned int targetLayer);
+
+	//Returns how many ticks have been run; i.e. the tick the next update runs.
+	std::uint32_t getTick() const;
+	//Returns the hash of the state of the battle at the end of the last tick; its ships, their damage and turrets, and the projectiles.
+	std::uint64_t getStateHash() const;
+	//Returns whether the battle is finished; i.e. either team has no ships.
+	bool isFinished() const;
+	//Returns the area of the battlefield; projectiles that leave it are removed.
+	const sf::FloatRect& getBounds() const;
+	//Returns how many projectile-ship pairs were considered for collision during the last tick.
+	const CollisionStats& getCollisionStats() const;
+
+	//Returns the list of ships on the passed layer; only read it from the thread updating the battle.
+	//	layer : The layer the ships are on; i.e. which team.
+	const std::vector<std::unique_ptr<Ship>>& getShips(unsigned int layer) const;
+	//Returns the pool of all active projectiles; only read it from the thread updating the battle.
+	const ProjectilePool& getProjectiles() const;
+private:
+	//A ship a projectile may be hitting, and the cell it hit; tested by a worker before any hit of the tick is applied.
+	struct CandidateTest
+	{
+		Ship *ship; //The ship that may be hit.
+		sf::Vector2i pixelHit; //The cell of the ship hit, or {-1, -1} if it was missed.
+		bool isTested; //Whether the ship was tested; ships after the first hit are not, as the projectile stops there.
+	};
+
+	//Where the tests of a projectile's candidates were stored.
+	struct ProjectileTests
+	{
+		unsigned int worker; //The worker that tested the projectile; its buffer holds the tests.
+		std::size_t first; //Index of the first test in the worker's buffer.
+		std::size_t count; //How many candidates the projectile had.
+	};
+
+	static constexpr std::size_t PROJECTILE_GRAIN = 128; //How many projectiles a worker moves, or tests, as one chunk.
+
+	const DamageMask &m_hullKey; //Pristine collision key of the hull the ships are built from.
+	JobSystem *m_jobs; //Workers each tick is spread over; nullptr if it runs on the calling thread.
+
+	std::uint32_t m_tick = 0; //How many ticks have been run.
+	std::uint64_t m_stateHash = 0; //Hash of the state of the battle at the end of the last tick.
+	bool m_isFinished = false; //Whether the battle is finished.
+
+	sf::FloatRect m_bounds; //The area of the battlefield.
+	CollisionStats m_collisionStats; //Pairs considered for collision during the last tick.
+
+	ProjectilePool m_projPool; //Pool of all active projectiles.
+	ShotQueue m_shotQueue; //Shots fired by the turrets last tick; drained into the pool at the start of the tick.
+	std::vector<ShotInfo> m_readyToFire; //Shots drained from the queue this tick; kept to reuse its memory.
+	std::vector<std::unique_ptr<Ship>> m_shipList[2]; //List of all active ships; the array is a reference to the layer the ship is located on.
+
+	ShipGrid m_shipGrid[2]; //Grid of the ships on each layer; used to find which ships a projectile may be hitting.
+	std::vector<Ship*> m_candidates; //Ships a projectile may be hitting; reused for every projectile.
+	unsigned int m_shipsCreated = 0; //How many ships have been created; gives each ship its order in the grid.
+
+	std::vector<Ship*> m_hitShips; //Ships hit so far this tick; their tests from before the hits are out of date.
+	std::vector<Ship*> m_removedShips; //Ships destroyed so far this tick; they are skipped, as they have left the grid.
+
+	std::vector<std::vector<Ship*>> m_workerCandidates; //Candidates found by each worker; reused for every projectile.
+	std::vector<std::vector<CandidateTest>> m_workerTests; //Hit buffer of each worker; the candidate tests of the projectiles it tested.
+	std::vector<ProjectileTests> m_projectileTests; //Where each projectile's tests are; by the projectile's index at the start of the tick.
+	std::vector<std::size_t> m_projectileOrigins; //Index at the start of the tick of each projectile in the pool; follows removals.
+	std::vector<Ship*> m_updateList; //Every ship, in update order; split between the workers.
+
+	sf::Mutex m_shipMutex; //Controls access to the ship lists; for owners that create ships outside of applyCommand.
+
+	//Processes a single tick for all projectiles.
+	//	deltaTime : The amount of time that has passed since the last update.
+	void resolveProjectiles(const sf::Time &deltaTime);
+	//Processes a single tick for all projectiles, spread over the workers; the result is the same as resolveProjectiles.
+	//	deltaTime : The amount of time that has passed since the last update.
+	void resolveProjectilesParallel(const sf::Time &deltaTime);
+	//Processes a single tick for every ship, spread over the workers; the result is the same as updating them in order.
+	//	deltaTime : The amount of time that has passed since the last update.
+	void updateShipsParallel(const sf::Time &deltaTime);
+
+	//Determines if the projectile collided with anything.
+	//	index : Index of the projectile in the pool we are checking collisions for.
+	//	projBounds : Global bounds of the projectile.
+	//	deltaTime : The amount of time that has passed since the last update.
+	//Returns whether a collision occurred.
+	bool collide(std::size_t index, const sf::FloatRect &projBounds, const sf::Time &deltaTime);
+	//Determines if the projectile collided with anything, from the tests the workers made of its candidates.
+	//	index : Index of the projectile in the pool we are checking collisions for.
+	//	tests : Where the tests of the projectile's candidates are.
+	//	deltaTime : The amount of time that has passed since the last update.
+	//Returns whether a collision occurred.
+	bool collideTested(std::size_t index, const ProjectileTests &tests, const sf::Time &deltaTime);
+	//Hashes the state of the battle; called at the end of each tick.
+	//Returns the hash of the battle's state.
+	std::uint64_t hashState() const;
+	//Removes the ship from the battle if the hit destroyed it.
+	//	ship : The ship that was hit.
+	//	layer : The layer the ship is on.
+	void removeIfDestroyed(Ship *ship, unsigned int layer);
+};
+
+//Returns how many ticks have been run; i.e. the tick the next update runs.
+inline std::uint32_t BattleSimulation::getTick() const
+{
+	return m_tick;
+}
+
+//Returns the hash of the state of the battle at the end of the last tick; its ships, their damage and turrets, and the projectiles.
+inline std::uint64_t BattleSimulation::getStateHash() const
+{
+	return m_stateHash;
+}
+
+//Returns whether the battle is finished; i.e. either team has no ships.
+inline bool BattleSimulation::isFinished() const
+{
+	return m_isFinished;
+}
+
+//Returns the area of the battlefield; projectiles that leave it are removed.
+inline const sf::FloatRect& BattleSimulation::getBounds() const
+{
+	return m_bounds;
+}
+
+//Returns how many projectile-ship pairs were considered for collision during the last tick.
+inline const CollisionStats& BattleSimulation::getCollisionStats() const
+{
+	return m_collisionStats;
+}
+
+//Returns the list of ships on the passed layer; only read it from the thread updating the battle.
+//	layer : The layer the ships are on; i.e. which team.
+inline const std::vector<std::unique_ptr<Ship>>& BattleSimulation::getShips(unsigned int layer) const
+{
+	return m_shipList[layer];
+}
+
+//Returns the pool of all active projectiles; only read it from the thread updating the battle.
+inline const ProjectilePool& BattleSimulation::getProjectiles() const
+{
+	return m_projPool;
+}
@@ -2,7 +2,9 @@
  * Author: George Mostyn-Parry
  *
  * Game state for managing battles; the main game state.
- * Allows for ships, and projectiles to be created; handles collisions, and processes the battle each tick.
+ * Presents a BattleSimulation to the player; handles input, networking, and drawing, while the simulation processes each tick.
+ * Each tick's render snapshot is published through a triple buffer; so the rendering thread never waits on, or locks, the simulation.
+ * The ticks, their commands, and the networking of them, are run by a BattleSession; see BattleSession.hpp.
  */
 #pragma once
 
@@ -10,9 +12,13 @@
 
 #include "AbstractGameState.hpp" //Base class.
 #include "GameManager.hpp" //For high-level information, and state changing.
-#include "Ship.hpp" //For the ships that fight in the battle state.
+#include "BattleSession.hpp" //For running the ticks of the battle.
+#include "BattleSimulation.hpp" //For the simulation of the battle being presented.
+#include "ProjectileRenderer.hpp" //For drawing the battle's projectiles.
+#include "ShipRenderer.hpp" //For drawing the battle's ships.
+#include "TripleBuffer.hpp" //For handing render snapshots to the rendering thread.
 
-//Manages a battle; adds ships, creates and resolves projectiles, and processes each game tick.
+//Presents a battle; passes player input to the simulation, and draws its ships and projectiles.
 class BattleState : public AbstractGameState
 {
 public:
@@ -28,7 +34,8 @@ public:
 	virtual void handleInput(const sf::Event &event);
 	//Processes the state logic to move the state forward a tick.
 	//	deltaTime : The amount of time that has passed since the last update.
-	virtual void update(const sf::Time &deltaTime);
+	//Returns whether the tick ran; false if the state is waiting on something outside the game, i.e. the peer in lockstep.
+	virtual bool update(const sf::Time &deltaTime);
 	//Draws all renderable elements of the state to the screen.
 	//	target : What we will be drawing onto.
 	//	states : Visual manipulations to the elements that are being drawn.
@@ -37,32 +44,22 @@ public:
 	//Update the state's view, i.e. fix the GUI, and other elements, from a window resize.
 	virtual void updateView();
 
+	//Returns how many bytes were uploaded to the ships' key textures during the last frame.
+	std::size_t getKeyUploadBytes() const;
+
 	//Creates a ship with the passed information.
 	//	team : The team the ship belongs to.
 	//	position : Where the ship should start on creation.
 	//	angle : The rotation of the ship on creation.
 	//	turretBuildList : The turrets the ship should start with.
 	void createShip(unsigned int team, const sf::Vector2f &position, float angle, const std::vector<TurretInfo> &turretBuildList = std::vector<TurretInfo>());
-
-	//Passes a move command to the specified ship.
-	//	shipLayer : The layer the ship is on; i.e. which team.
-	//	shipID : The ID of the ship in the team.
-	//	destination : Where the ship is being told to head to.
-	void issueMoveCommand(unsigned int shipLayer, unsigned int shipID, const sf::Vector2f &destination);
-	//Passes a fire command to the specified ship.
-	//	shipLayer : The layer the ship is on; i.e. which team.
-	//	shipID : The ID of the ship in the team.
-	//	target : Where the ship is being told to shoot at.
-	//	targetLayer : Which layer the ship is being told to shoot on.
-	void issueFireCommand(unsigned int shipLayer, unsigned int shipID, const sf::Vector2f &target, unsigned int targetLayer);
 private:
 	GameManager &m_game; //The game manager; for changing state, and other high-level information.
 
-	bool m_isFinished = false; //Whether the battle is finished, and ready to head to the next state.
+	JobSystem m_jobs; //Workers each tick of the simulation is spread over.
+	BattleSimulation m_simulation; //The simulation of the battle; owns the ships and projectiles.
 
-	std::vector<std::unique_ptr<Projectile>> m_projList; //List of all active projectiles.
-	std::vector<std::unique_ptr<Ship>>m_shipList[2]; //List of all active ships; the array is a reference to the layer the ship is located on.
-	std::vector<ShotInfo> m_readyToFire; //List of shots ready to be fired/created.
+	BattleSession m_session; //Runs the ticks of the battle, and networks them with the peer.
 
 	sf::Thread m_networkThread; //Thread responsible for networking.
 
@@ -70,20 +67,18 @@ private:
 	sf::FloatRect m_viewBounds; //Where the battle's view should constrain itself to.
 	
 	sf::RectangleShape areaBorder; //Visual representation of the view bounds.
-	
-	//Creates a projectile with the passed information.
-	//	info : The information used to create the projectile.
-	void createProjectile(const ShotInfo &info);
 
-	//Processes a single tick for all projectiles.
-	//	deltaTime : The amount of time that has passed since the last update.
-	void resolveProjectiles(const sf::Time &deltaTime);
-	//Determines if the projectile collided with anything.
-	//	proj : The projectile we are checking collisions for.
-	//	deltaTime : The amount of time that has passed since the last update.
-	//Returns whether a collision occurred.
-	bool collide(const std::unique_ptr<Projectile> &proj, const sf::Time &deltaTime);
+	mutable TripleBuffer<RenderSnapshot> m_snapshots; //Snapshots of the battle; published every tick, and taken every frame.
+	mutable ShipRenderer m_shipRenderer; //Draws the ships from the snapshot; updated in the const draw function.
+	mutable ProjectileRenderer m_projRenderer; //Batches the projectiles into one draw call; rebuilt in the const draw function.
 
 	//Ends the battle state, and proceeds to the build state.
 	void changeToBuildState();
-};
\ No newline at end of file
+};
+
+//Returns how many bytes were uploaded to the ships' key textures during the last frame.
+inline std::size_t BattleState::getKeyUploadBytes() const
+{
+	return m_shipRenderer.getKeyUploadBytes();
+}
+
@@ -15,6 +15,7 @@
 #include "GameManager.hpp" //For changing state, and other high-level information.
 #include "ResourceManager.hpp" //So we can load in resources for the state.
 #include "Ship.hpp" //So we can show the ship we are building.
+#include "ShipRenderer.hpp" //For drawing the hull.
 #include "Button.hpp" //For GUI buttons.
 
  //Manages the construction of a ship; allows turrets to be added to the ship.
@@ -30,7 +31,8 @@ public:
 	virtual void handleInput(const sf::Event &event);
 	//Processes the state logic to move the state forward a tick.
 	//	deltaTime : The amount of time that has passed since the last update.
-	virtual void update(const sf::Time &deltaTime);
+	//Returns whether the tick ran; false if the state is waiting on something outside the game, i.e. the peer in lockstep.
+	virtual bool update(const sf::Time &deltaTime);
 	//Draws all renderable elements of the state to the screen.
 	//	target : What we will be drawing onto.
 	//	states : Visual manipulations to the elements that are being drawn.
@@ -45,7 +47,10 @@ private:
 	GameManager &m_game; //The game manager; for changing state, and other high-level information.
 
 	Ship m_hull; //The hull of the ship we are building/modifying.
+	mutable std::vector<ShipSnapshot> m_hullSnapshot; //Snapshot the hull is drawn from; refilled in the const draw function.
+	mutable ShipRenderer m_hullRenderer; //Draws the hull from its snapshot.
 	std::vector<std::unique_ptr<Turret>> m_turretList; //List of all of the turrets attached to the construction.
+	mutable sf::Mutex m_turretMutex; //Controls access to the turret list, for multithreaded rendering.
 
 	ProjectileType m_turretProjType; //The projectile type of the turret we are adding.
 	Turret m_buildPreview; //Preview of the turret to be placed.		
@@ -57,6 +62,7 @@ private:
 	Button m_missileButton; //Button that changes the projectile type to missile.
 	Button m_plasmaButton; //Button that changes the projectile type to plasma.
 	sf::Text m_turretTypeText; //Text that displays the current turret type.
+	mutable sf::Mutex m_turretTypeMutex; //Controls access to the turret type label.
 
 	//Changes the projectile type of the turret to be added to the projectile type passed.
 	//	projType : The new projectile type of the turret to be added.
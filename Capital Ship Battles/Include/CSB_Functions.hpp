@@ -5,6 +5,9 @@
  */
 #pragma once
 
+#include <algorithm> //For std::max.
+#include <cmath> //For trigonometric functions, and abs.
+
 #include <SFML/Graphics.hpp> //For sf::Transformable, and other SFML classes.
 
 //Constants and functions that are used by the Capital Ship Battles program.
@@ -12,6 +15,15 @@ namespace CSB
 {
 	constexpr float PI = 3.14159265359f; //PI, the mathematical constant; declared as a float as most operations are with floats.
 	constexpr unsigned int DEGREES_PER_SECOND = 45; //How many degrees an entity turns per second.
+	constexpr unsigned int DEFAULT_TICK_RATE = 60; //How many ticks the game runs per second, unless told otherwise.
+
+	//Find how long each tick lasts at the passed tick rate; every tick length is found this way, so the same rate always gives the same length.
+	//	ticksPerSecond : How many ticks are run per second; a rate of zero is taken as one.
+	//Returns how much time each tick moves the game forward.
+	inline sf::Time tickLength(unsigned int ticksPerSecond)
+	{
+		return sf::seconds(1.f / std::max(ticksPerSecond, 1u));
+	}
 
 	//Find the angle of the passed vector.
 	//	vector : Vector we are finding the angle of.
@@ -22,6 +34,19 @@ namespace CSB
 		return fmod(atan2(vector.y, vector.x) * (180.f / PI) + 360.f, 360.f);
 	}
 
+	//Find the angle a fraction of the way from one angle to another, turning the shorter way around.
+	//	from : The angle at a fraction of 0.
+	//	to : The angle at a fraction of 1.
+	//	fraction : How far from the first angle to the second to go.
+	//Returns the angle between them as a positive angle value, as that is what SFML uses.
+	inline float lerpAngle(float from, float to, float fraction)
+	{
+		//Difference between the angles, wrapped to the shorter turn; between -180 and 180.
+		const float difference = fmod(to - from + 540.f, 360.f) - 180.f;
+
+		return fmod(from + difference * fraction + 360.f, 360.f);
+	}
+
 	//Find the angle between the source and the target.
 	//	source : The point we are finding the angle from.
 	//	target : The point we are finding the angle to.
@@ -0,0 +1,81 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Connects to the peer over datagrams, with the reliability layer of UdpChannel; the base of the UDP, and loopback, transports.
+ * The handshake is sent on the reliable stream, and each flush of frames on the redundant stream; so a lost datagram only delays
+ * the frames in it until the next datagram. The peer is taken to have left if nothing arrives from them for five seconds.
+ * Derived classes only carry the datagrams.
+ */
+#pragma once
+
+#include <atomic> //For disconnecting from another thread.
+
+#include "Transport.hpp" //Base class.
+#include "UdpChannel.hpp" //The reliability layer.
+
+//Connects to the peer over datagrams, with the reliability layer of UdpChannel.
+class ChannelTransport : public Transport
+{
+public:
+	//Stops the transport; the network thread closes whatever it is carried over, once it notices. Safe to call from any thread.
+	virtual void disconnect();
+	//Returns whether the peer is still connected.
+	virtual bool isConnected() const;
+
+	//Queues the handshake on the reliable stream.
+	//	handshake : The bytes of the handshake.
+	virtual void sendHandshake(std::vector<std::uint8_t> handshake);
+	//Queues a flush of frames on the redundant stream.
+	//	frames : The bytes of the frames.
+	virtual void sendFrames(std::vector<std::uint8_t> frames);
+	//Sends a datagram, if the reliability layer has anything due; only call from the network thread.
+	virtual void flush();
+
+	//Waits, at most the timeout, for datagrams from the peer, and reads every one that arrived; only call from the network thread.
+	//	timeout : The longest to wait.
+	//Returns whether the peer is still connected; i.e. the transport is open, and the peer has sent something recently.
+	virtual bool wait(const sf::Time &timeout);
+	//Takes the next message from the peer; the handshake, then each flush of frames. Only call from the network thread.
+	//	message : Set to the bytes of the message.
+	//Returns whether there was a message.
+	virtual bool receive(std::vector<std::uint8_t> &message);
+protected:
+	UdpChannel m_channel; //The reliability layer; only used by the thread connecting, then the network thread.
+	std::atomic<bool> m_isOpen{false}; //Whether the transport is connecting, or connected; cleared to stop it from another thread.
+
+	//Sends a datagram to the peer.
+	//	datagram : The bytes of the datagram.
+	virtual void sendDatagram(std::vector<std::uint8_t> datagram) = 0;
+	//Waits, at most the timeout, for a datagram from the peer to arrive.
+	//	timeout : The longest to wait.
+	//Returns whether a datagram arrived.
+	virtual bool waitForDatagram(const sf::Time &timeout) = 0;
+	//Takes the next datagram from the peer, without waiting.
+	//	datagram : Set to the bytes of the datagram.
+	//Returns whether there was a datagram.
+	virtual bool receiveDatagram(std::vector<std::uint8_t> &datagram) = 0;
+
+	//Starts a new connection; forgetting everything about the last peer.
+	void open();
+	//Reads a datagram received from the peer into the reliability layer.
+	//	data : The bytes of the datagram.
+	//	size : How many bytes there are.
+	//Returns whether the datagram was well-formed.
+	bool readDatagram(const void *data, std::size_t size);
+	//Sends a datagram, if the reliability layer has anything due.
+	//	isForced : Whether to send a datagram even if nothing is due; i.e. to greet the peer.
+	void sendDue(bool isForced = false);
+
+	//Returns the time given to the reliability layer.
+	sf::Time getTime() const;
+private:
+	sf::Clock m_clock; //The time given to the reliability layer.
+	sf::Time m_lastReceived; //When a well-formed datagram last arrived from the peer.
+	bool m_hasHandshake = false; //Whether the peer's handshake has been taken; frames are left on the channel until it has been.
+};
+
+//Returns the time given to the reliability layer.
+inline sf::Time ChannelTransport::getTime() const
+{
+	return m_clock.getElapsedTime();
+}
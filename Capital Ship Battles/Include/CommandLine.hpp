@@ -0,0 +1,74 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Parses the values given to command line options, i.e. "--fps=144"; shared by the game, and the tools that take options.
+ * A value that is not a number, is negative, or is out of range is reported and ignored, rather than ending the program,
+ * or being wrapped around into a huge value.
+ */
+#pragma once
+
+#include <cctype> //For checking the value starts with a digit.
+#include <iostream> //For reporting an invalid value.
+#include <limits> //For the largest value of each type.
+#include <stdexcept> //For the exceptions thrown by a number too large to parse.
+#include <string> //For the options.
+#include <type_traits> //For telling whole numbers from floating point values.
+
+//Constants and functions that are used by the Capital Ship Battles program.
+namespace CSB
+{
+	//Parses the value of an option of the form "--name=value"; an invalid value is reported, and the value left as it was.
+	//The value must be a number of the value's type, from zero to the maximum; with nothing before, or after, it.
+	//	option : The whole option, as given.
+	//	nameLength : The length of the option's name, including the '='.
+	//	value : Set to the option's value; if it is valid.
+	//	max : The largest value accepted.
+	//Returns whether the value was valid.
+	template<typename T>
+	bool parseOption(const std::string &option, std::size_t nameLength, T &value, T max = std::numeric_limits<T>::max())
+	{
+		//The text of the value.
+		const std::string text = option.substr(nameLength);
+		//How many characters of the text were parsed; the whole text must be the number.
+		std::size_t parsedLength = 0;
+		//Whether the value is in range.
+		bool isInRange = false;
+		//The parsed value; only kept if it is valid.
+		T parsed = T();
+
+		//The standard parsers skip whitespace, and take a sign; a negative whole number would wrap around into a huge one.
+		if(!text.empty() && std::isdigit(static_cast<unsigned char>(text.front())))
+		{
+			try
+			{
+				if constexpr(std::is_floating_point<T>::value)
+				{
+					const long double number = std::stold(text, &parsedLength);
+
+					isInRange = number <= max;
+					parsed = static_cast<T>(number);
+				}
+				else
+				{
+					const unsigned long long number = std::stoull(text, &parsedLength);
+
+					isInRange = number <= max;
+					parsed = static_cast<T>(number);
+				}
+			}
+			//The number is too large for even the parser.
+			catch(const std::out_of_range&)
+			{}
+		}
+
+		if(!isInRange || parsedLength != text.size())
+		{
+			std::cerr << "Invalid value for option: " << option << std::endl;
+			return false;
+		}
+
+		value = parsed;
+
+		return true;
+	}
+}
@@ -26,7 +26,8 @@ public:
 	virtual void handleInput(const sf::Event &event);
 	//Processes the state logic to move the state forward a tick.
 	//	deltaTime : The amount of time that has passed since the last update.
-	virtual void update(const sf::Time &deltaTime);
+	//Returns whether the tick ran; false if the state is waiting on something outside the game, i.e. the peer in lockstep.
+	virtual bool update(const sf::Time &deltaTime);
 	//Draws all renderable elements of the state to the screen.
 	//	target : What we will be drawing onto.
 	//	states : Visual manipulations to the elements that are being drawn.
@@ -0,0 +1,127 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * A two-dimensional bitset recording which cells of a ship's hull are still intact; one bit per cell, packed into 64-bit words.
+ * The authoritative collision structure of a ship; the key texture fed to the damage shader is only derived from it.
+ * Rows are padded to a whole number of words, so a run of cells on a row may be tested a word at a time.
+ */
+#pragma once
+
+#include <cstdint> //For fixed width words.
+#include <vector> //For the words, and the pixel buffer.
+
+#include <SFML/Graphics.hpp> //For rectangles, and pixel data.
+
+//Bitset of intact hull cells; set bits are intact, and may be collided with.
+class DamageMask
+{
+public:
+	//Creates an empty mask; call create before using it.
+	DamageMask() = default;
+
+	//Resizes the mask, and marks every cell as destroyed.
+	//	width : How many cells wide the mask is.
+	//	height : How many cells tall the mask is.
+	void create(unsigned int width, unsigned int height);
+
+	//Returns whether the cell is intact; the cell must be inside the mask.
+	//	x : Column of the cell.
+	//	y : Row of the cell.
+	bool isSet(unsigned int x, unsigned int y) const;
+	//Marks the cell as intact; the cell must be inside the mask.
+	//	x : Column of the cell.
+	//	y : Row of the cell.
+	void set(unsigned int x, unsigned int y);
+	//Marks the cell as destroyed; the cell must be inside the mask.
+	//	x : Column of the cell.
+	//	y : Row of the cell.
+	void reset(unsigned int x, unsigned int y);
+
+	//Returns whether the cell co-ordinates are inside the mask.
+	//	x : Column of the cell.
+	//	y : Row of the cell.
+	bool contains(int x, int y) const;
+	//Returns the width and height of the mask, in cells.
+	const sf::Vector2u& getSize() const;
+	//Returns the words the bits of the mask are stored in, row by row; each row is padded to a whole number of words.
+	const std::vector<std::uint64_t>& getWords() const;
+
+	//Finds the first intact cell on a row, walking from one column towards another; testing a word at a time.
+	//Columns outside of the mask are skipped.
+	//	y : Row to search along.
+	//	first : Column the walk starts at; inclusive.
+	//	last : Column the walk ends at; exclusive. May be less than first, to walk backwards.
+	//Returns the column of the first intact cell found, or -1 if there is none.
+	int findFirstSet(int y, int first, int last) const;
+
+	//Returns the smallest area containing every cell that differs from another mask; compared a word at a time.
+	//The whole mask is returned if the sizes differ, and an empty area if the masks match.
+	//	other : The mask to compare against.
+	sf::IntRect getChangedArea(const DamageMask &other) const;
+
+	//Expands an area of the mask to RGBA pixels; opaque white for intact cells, and transparent for destroyed cells.
+	//	area : The area of the mask to expand, in cells; must be inside the mask.
+	//	pixels : Filled with the pixels of the area, row by row.
+	void getPixels(const sf::IntRect &area, std::vector<sf::Uint8> &pixels) const;
+private:
+	static constexpr unsigned int WORD_BITS = 64; //How many cells are stored in each word.
+
+	sf::Vector2u m_size; //Width and height of the mask, in cells.
+	unsigned int m_wordsPerRow = 0; //How many words each row is stored in.
+	std::vector<std::uint64_t> m_words; //The bits of the mask; stored row by row.
+
+	//Returns the lowest intact column in the range of a row, or -1 if there is none.
+	//	y : Row to search along.
+	//	begin : First column of the range; inclusive.
+	//	end : Last column of the range; exclusive.
+	int findLowestSet(unsigned int y, unsigned int begin, unsigned int end) const;
+	//Returns the highest intact column in the range of a row, or -1 if there is none.
+	//	y : Row to search along.
+	//	begin : First column of the range; inclusive.
+	//	end : Last column of the range; exclusive.
+	int findHighestSet(unsigned int y, unsigned int begin, unsigned int end) const;
+};
+
+//Returns whether the cell is intact; the cell must be inside the mask.
+//	x : Column of the cell.
+//	y : Row of the cell.
+inline bool DamageMask::isSet(unsigned int x, unsigned int y) const
+{
+	return (m_words[y * m_wordsPerRow + x / WORD_BITS] >> (x % WORD_BITS)) & 1;
+}
+
+//Marks the cell as intact; the cell must be inside the mask.
+//	x : Column of the cell.
+//	y : Row of the cell.
+inline void DamageMask::set(unsigned int x, unsigned int y)
+{
+	m_words[y * m_wordsPerRow + x / WORD_BITS] |= std::uint64_t(1) << (x % WORD_BITS);
+}
+
+//Marks the cell as destroyed; the cell must be inside the mask.
+//	x : Column of the cell.
+//	y : Row of the cell.
+inline void DamageMask::reset(unsigned int x, unsigned int y)
+{
+	m_words[y * m_wordsPerRow + x / WORD_BITS] &= ~(std::uint64_t(1) << (x % WORD_BITS));
+}
+
+//Returns whether the cell co-ordinates are inside the mask.
+//	x : Column of the cell.
+//	y : Row of the cell.
+inline bool DamageMask::contains(int x, int y) const
+{
+	return x >= 0 && y >= 0 && static_cast<unsigned int>(x) < m_size.x && static_cast<unsigned int>(y) < m_size.y;
+}
+
+//Returns the width and height of the mask, in cells.
+inline const sf::Vector2u& DamageMask::getSize() const
+{
+	return m_size;
+}
+
+//Returns the words the bits of the mask are stored in, row by row; each row is padded to a whole number of words.
+inline const std::vector<std::uint64_t>& DamageMask::getWords() const
+{
+	return m_words;
+}
@@ -2,15 +2,52 @@
  * Author: George Mostyn-Parry
  *
  * Manager class for the handling of states, and execution of the game. 
+ * The rendering thread paces the frames it presents by the chosen FramePacing; in ON_CHANGE it sleeps until a state requests a redraw,
+ * so a static GUI state costs almost nothing. The main loop sleeps out the rest of each tick, unless the pacing is UNLIMITED.
+ * The game ticks at a fixed rate, independent of the frame rate; states draw a tick behind, interpolating by how far the game clock is into the next tick.
+ * A cycle of the main loop runs at most a set number of ticks; a backlog beyond that is dropped, rather than growing until the game freezes.
+ * With time dilation, the game also slows itself down while it cannot keep up, and speeds back up once it can.
  */
 #pragma once
 
+#include <atomic> //For the flag ending the rendering thread.
+#include <condition_variable> //For waking the rendering thread when a redraw is requested.
+#include <mutex> //For the redraw condition.
+
 #include <SFML/Graphics.hpp> //For RenderWindow, and other SFML classes and functions.
 
 #include "AbstractGameState.hpp" //For changing, and processing, game states.
+#include "CSB_Functions.hpp" //For the default tick rate.
 #include "ResourceManager.hpp" //For controlling life-time of resources.
 #include "NetworkManager.hpp" //For networking battles between two users.
 
+//How the rendering thread paces the frames it presents.
+enum class FramePacing
+{
+	UNLIMITED, //Present frames as fast as possible; uses a whole core.
+	VSYNC, //Present frames in time with the display's refresh.
+	FIXED_CAP, //Present at most the frame rate cap's frames per second.
+	ON_CHANGE //Present a frame only when a redraw has been requested; i.e. on input, a new tick of a battle, or a state change.
+};
+
+//Timing of the frames presented by the rendering thread over a reporting period.
+struct FrameStats
+{
+	unsigned long frames = 0; //How many frames were presented.
+	sf::Time frameTime; //Total time between presenting frames.
+	sf::Time worstFrameTime; //The longest time between presenting two frames.
+	sf::Time drawTime; //Total time spent drawing, and presenting, frames; the rendering thread was idle for the rest.
+};
+
+//Counts of the ticks run by the main loop over a reporting period.
+struct TickStats
+{
+	unsigned long ticks = 0; //How many ticks were run.
+	unsigned long lateTicks = 0; //Ticks run more than a whole tick after they were due.
+	unsigned long droppedTicks = 0; //Ticks never run, as the backlog was more than a cycle is allowed to catch up on.
+	unsigned long stalledTicks = 0; //How often a due tick could not run yet, as the state was waiting on something outside the game; i.e. the peer.
+};
+
 //State and execution manager for the game.
 class GameManager
 {
@@ -27,16 +64,66 @@ public:
 	//	newState : The state that will become the current state.
 	void setState(std::unique_ptr<AbstractGameState> newState);
 
+	//Sets how many ticks the game runs per second; only call before the game loop starts.
+	//	ticksPerSecond : How many ticks are run per second; interpolated drawing keeps a low tick rate smooth.
+	void setTickRate(unsigned int ticksPerSecond);
+	//Sets how the main loop catches up when ticks take longer than the tick length; only call before the game loop starts.
+	//	maxTicksPerCycle : The most ticks run by a cycle of the main loop; any backlog beyond them is dropped.
+	//	isTimeDilated : Whether the game slows down while it cannot keep up, so fewer ticks are dropped.
+	void setCatchUp(unsigned int maxTicksPerCycle, bool isTimeDilated);
+	//Sets whether the main loop prints counts of its ticks every second; only call before the game loop starts.
+	//	isEnabled : Whether the tick counts are printed.
+	void setTickStatsEnabled(bool isEnabled);
+	//Sets how the rendering thread paces the frames it presents; only call before the game loop starts.
+	//	pacing : How frames are paced.
+	//	frameRateCap : The most frames presented per second; only used by FIXED_CAP.
+	void setFramePacing(FramePacing pacing, unsigned int frameRateCap = 60);
+	//Sets whether the rendering thread prints the timing of its frames every second; only call before the game loop starts.
+	//	isEnabled : Whether the frame timing is printed.
+	void setFrameStatsEnabled(bool isEnabled);
+	//Requests the rendering thread to present a new frame; only needed by the ON_CHANGE pacing. Safe to call from any thread.
+	void requestRedraw();
+
 	//Returns a reference to the resource manager.
 	ResourceManager& getResourceManager();
 	//Returns a reference to the network manager.
 	NetworkManager& getNetworkManager();
 	//Returns a const reference to the window we are drawing to.
 	const sf::RenderWindow& getWindow() const;
+
+	//Returns how much time each tick moves the game forward.
+	const sf::Time& getTickLength() const;
+	//Returns when the tick being run was due on the game clock; only call from a state's update.
+	const sf::Time& getTickTime() const;
+	//Returns the time on the game clock between ticks; longer than the tick length while the game is dilated. Only call from a state's update.
+	sf::Time getTickInterval() const;
+	//Returns the time on the game clock; safe to call from any thread.
+	sf::Time getGameTime() const;
 private:
-	const sf::Time FIXED_UPDATES_PER_SECOND = sf::seconds(1.f / 60.f); //How fast to update the game/physics process.
+	sf::Time m_tickLength = CSB::tickLength(CSB::DEFAULT_TICK_RATE); //How much time each tick moves the game forward; fixed, however fast frames are drawn.
+	sf::Clock m_gameClock; //Time since the game started; never restarted, so any thread may read it.
+	sf::Time m_tickTime; //When the tick being run was due on the game clock.
+
+	const float TIME_SCALE_DROP = 0.8f; //How much the time scale is multiplied by when a cycle could not catch up.
+	const float TIME_SCALE_RECOVERY = 1.01f; //How much the time scale is multiplied by when a cycle caught up; until it is back to 1.
+	const float MIN_TIME_SCALE = 0.1f; //The slowest the game is dilated to.
+
+	unsigned int m_maxTicksPerCycle = 5; //The most ticks run by a cycle of the main loop.
+	bool m_isTimeDilated = false; //Whether the game slows down while it cannot keep up.
+	float m_timeScale = 1; //How fast game time passes, relative to real time; below 1 only while the game is dilated.
+	bool m_isTickStatsEnabled = false; //Whether the main loop prints counts of its ticks.
+	TickStats m_tickStats; //Counts of the ticks run since the last report.
+	const sf::Time FRAME_STATS_PERIOD = sf::seconds(1); //How often the frame timing is printed.
+
+	std::atomic<bool> m_isWaitingForRenderingEnd{false}; //Whether the main thread is waiting for the rendering thread to end.
 
-	bool m_isWaitingForRenderingEnd = false; //Whether the main thread is waiting for the rendering thread to end.
+	FramePacing m_framePacing = FramePacing::VSYNC; //How the rendering thread paces the frames it presents.
+	unsigned int m_frameRateCap = 60; //The most frames presented per second with FIXED_CAP.
+	bool m_isFrameStatsEnabled = false; //Whether the rendering thread prints the timing of its frames.
+
+	std::mutex m_redrawMutex; //Controls access to the redraw request.
+	std::condition_variable m_redrawCondition; //Wakes the rendering thread when a redraw is requested, or it should end.
+	bool m_isRedrawRequested = true; //Whether a new frame should be presented; only used by ON_CHANGE.
 
 	std::unique_ptr<AbstractGameState> m_currentGameState; //The state the game is currently in.
 	ResourceManager m_resourceManager; //The object that manages the resources used by the game.
@@ -51,9 +138,24 @@ private:
 	//Updates view on the window's size being changed.
 	void updateView();
 
+	//Runs the ticks that are due, up to the most allowed in a cycle, and drops any backlog beyond them.
+	//	timeSinceLastTick : Game time accumulated since the last tick; reduced by each tick run, and each tick dropped.
+	void runTicks(sf::Time &timeSinceLastTick);
+	//Prints the counts of the ticks run over the last period.
+	//	stats : Counts of the ticks.
+	//	period : How long the period lasted.
+	void printTickStats(const TickStats &stats, const sf::Time &period) const;
+
 	//Draw the state elements to the window.
 	//Placed on a seperate thread as we don't want the amount of draw calls to slow down the main thread.
 	void draw();
+	//Waits until a frame should be presented; for a redraw request with ON_CHANGE, or only until the rendering thread should end.
+	//Returns whether a frame should be presented.
+	bool waitForRedraw();
+	//Prints the timing of the frames presented over the last period.
+	//	stats : Timing of the frames.
+	//	period : How long the period lasted.
+	void printFrameStats(const FrameStats &stats, const sf::Time &period) const;
 	//Safely starts drawing on the rendering thread.
 	void startRenderThread();
 	//Causes the rendering thread to safely close; useful for safely closing, or recreating the window.
@@ -76,4 +178,28 @@ inline NetworkManager& GameManager::getNetworkManager()
 inline const sf::RenderWindow& GameManager::getWindow() const
 {
 	return m_window;
-}
\ No newline at end of file
+}
+
+//Returns how much time each tick moves the game forward.
+inline const sf::Time& GameManager::getTickLength() const
+{
+	return m_tickLength;
+}
+
+//Returns when the tick being run was due on the game clock; only call from a state's update.
+inline const sf::Time& GameManager::getTickTime() const
+{
+	return m_tickTime;
+}
+
+//Returns the time on the game clock between ticks; longer than the tick length while the game is dilated. Only call from a state's update.
+inline sf::Time GameManager::getTickInterval() const
+{
+	return m_tickLength / m_timeScale;
+}
+
+//Returns the time on the game clock; safe to call from any thread.
+inline sf::Time GameManager::getGameTime() const
+{
+	return m_gameClock.getElapsedTime();
+}
@@ -0,0 +1,113 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * A fixed pool of worker threads that run parallel loops, with work stealing between the workers.
+ * A loop is split into chunks, and each worker is given an equal, contiguous share of them;
+ * a worker that finishes its share steals chunks from the back of the other workers' shares, so an uneven loop still finishes together.
+ * The calling thread works as worker 0 while it waits, so a pool of one worker runs every loop inline without any threads.
+ *
+ * Which worker runs a chunk is not deterministic; anything the loop body writes must go to a slot of its index, or a buffer of its worker,
+ * and be merged in index order afterwards, if the result has to be the same on every run.
+ */
+#pragma once
+
+#include <atomic> //For the chunk ranges each worker takes from.
+#include <condition_variable> //For waking the workers, and waiting for them to finish.
+#include <cstdint> //For packing the chunk ranges.
+#include <memory> //For smart pointers.
+#include <mutex> //For the condition variables.
+#include <thread> //For the worker threads.
+#include <type_traits> //For calling the loop body through a plain pointer.
+#include <vector> //For the worker threads.
+
+//Pool of worker threads that run parallel loops, stealing work from each other when they run out.
+class JobSystem
+{
+public:
+	//Basic JobSystem constructor; starts the worker threads.
+	//	workerCount : How many workers run each loop, including the calling thread; at least one.
+	JobSystem(unsigned int workerCount = std::thread::hardware_concurrency());
+	//JobSystem destructor; stops, and joins, the worker threads.
+	~JobSystem();
+
+	//Runs the function over every index in the range, split between the workers; returns once every index has been run.
+	//Only call from one thread at a time.
+	//	count : How many indices there are; the loop runs from 0 to count - 1.
+	//	grainSize : How many indices are run together as a chunk; the smallest amount of work that can be stolen.
+	//	function : Called as function(begin, end, worker) for each chunk; worker is below getWorkerCount(), for per-worker buffers.
+	template<typename Function>
+	void parallelFor(std::size_t count, std::size_t grainSize, Function &&function);
+
+	//Returns how many workers run each loop, including the calling thread.
+	unsigned int getWorkerCount() const;
+private:
+	//Calls the loop body on a chunk of the range.
+	using Invoker = void(*)(void *function, std::size_t begin, std::size_t end, unsigned int worker);
+
+	//The chunks left in a worker's share; kept on its own cache line, as every worker may steal from it.
+	struct alignas(64) WorkerQueue
+	{
+		std::atomic<std::uint64_t> chunks; //The next chunk in the high 32 bits, and the chunk after the last in the low 32 bits.
+	};
+
+	unsigned int m_workerCount; //How many workers run each loop, including the calling thread.
+	std::vector<std::thread> m_threads; //The worker threads; one fewer than the workers, as the calling thread is worker 0.
+	std::unique_ptr<WorkerQueue[]> m_queues; //The chunks left in each worker's share of the loop.
+
+	std::mutex m_mutex; //Controls access to the loop being run, and the worker counts.
+	std::condition_variable m_wakeCondition; //Wakes the workers when a loop starts, or the pool is stopping.
+	std::condition_variable m_doneCondition; //Wakes the calling thread when every worker has finished.
+	unsigned long m_generation = 0; //How many loops have been started; workers compare it to find a new loop.
+	unsigned int m_busyWorkers = 0; //How many worker threads are still running the current loop.
+	bool m_isStopping = false; //Whether the worker threads should exit.
+
+	Invoker m_invoker = nullptr; //Calls the body of the current loop.
+	void *m_function = nullptr; //The body of the current loop.
+	std::size_t m_count = 0; //How many indices the current loop has.
+	std::size_t m_grainSize = 1; //How many indices are in each chunk of the current loop.
+
+	//Splits the loop between the workers, and runs it.
+	//	count : How many indices there are.
+	//	grainSize : How many indices are run together as a chunk.
+	//	invoker : Calls the loop body on a chunk.
+	//	function : The loop body.
+	void run(std::size_t count, std::size_t grainSize, Invoker invoker, void *function);
+	//Waits for loops, and runs them, until the pool is stopping.
+	//	worker : Index of the worker the thread runs as.
+	void workerLoop(unsigned int worker);
+	//Runs chunks from the worker's own share, then steals from the other workers, until every chunk has been taken.
+	//	worker : Index of the worker running the chunks.
+	void work(unsigned int worker);
+
+	//Takes the next chunk from the front of a worker's share.
+	//	queue : The share to take from.
+	//	chunk : Set to the chunk taken.
+	//Returns whether a chunk was taken.
+	static bool popFront(WorkerQueue &queue, std::uint32_t &chunk);
+	//Takes the last chunk from the back of another worker's share.
+	//	queue : The share to steal from.
+	//	chunk : Set to the chunk taken.
+	//Returns whether a chunk was taken.
+	static bool stealBack(WorkerQueue &queue, std::uint32_t &chunk);
+};
+
+//Runs the function over every index in the range, split between the workers; returns once every index has been run.
+//Only call from one thread at a time.
+//	count : How many indices there are; the loop runs from 0 to count - 1.
+//	grainSize : How many indices are run together as a chunk; the smallest amount of work that can be stolen.
+//	function : Called as function(begin, end, worker) for each chunk; worker is below getWorkerCount(), for per-worker buffers.
+template<typename Function>
+inline void JobSystem::parallelFor(std::size_t count, std::size_t grainSize, Function &&function)
+{
+	//The loop body is passed through a plain function pointer, so starting a loop never allocates.
+	run(count, grainSize, [](void *body, std::size_t begin, std::size_t end, unsigned int worker)
+	{
+		(*static_cast<std::remove_reference_t<Function>*>(body))(begin, end, worker);
+	}, const_cast<void*>(static_cast<const void*>(&function)));
+}
+
+//Returns how many workers run each loop, including the calling thread.
+inline unsigned int JobSystem::getWorkerCount() const
+{
+	return m_workerCount;
+}
@@ -0,0 +1,65 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Connects two network managers in the same process, with the reliability layer of ChannelTransport; for testing, and benchmarks.
+ * The two ends share a pipe of two impaired links, one each way; so latency, jitter, loss, reordering, and a cap on bandwidth,
+ * may be injected into what each end sends, without any sockets. A datagram is handed to the receiving end the moment it is due,
+ * so the only timing not from the model is the wake-up of the receiving thread.
+ * The ends are connected as soon as they are created; hosting, and joining, only report whether they still are.
+ */
+#pragma once
+
+#include <condition_variable> //For waking the receiving end.
+#include <memory> //For the pipe shared by the ends.
+#include <mutex> //For the pipe shared by the ends.
+
+#include "ChannelTransport.hpp" //Base class.
+
+//One end of an in-process pair of transports.
+class LoopbackTransport : public ChannelTransport
+{
+public:
+	//Connects two ends to each other; dropping any connection either had.
+	//	first : One end.
+	//	second : The other end.
+	//	impairment : How badly each link drops, and delays, what is sent over it; the same model both ways.
+	//	seed : Seed of the links' random choices; the same seed gives the same losses, and delays.
+	static void connect(LoopbackTransport &first, LoopbackTransport &second, const LinkImpairment &impairment, unsigned int seed = 1);
+
+	//Returns whether the end is connected; it is connected when created, so there is nothing to wait for.
+	//	port : Unused.
+	virtual bool host(unsigned short port);
+	//Returns whether the end is connected; it is connected when created, so there is nothing to reach.
+	//	address : Unused.
+	//	port : Unused.
+	virtual bool join(const sf::IpAddress &address, unsigned short port);
+	//Closes the pipe; both ends notice at once. Safe to call from any thread.
+	virtual void disconnect();
+	//Returns whether the peer is still connected.
+	virtual bool isConnected() const;
+protected:
+	//Sends a datagram over the link to the other end.
+	//	datagram : The bytes of the datagram.
+	virtual void sendDatagram(std::vector<std::uint8_t> datagram);
+	//Waits, at most the timeout, for a datagram from the other end to be due.
+	//	timeout : The longest to wait.
+	//Returns whether a datagram is due.
+	virtual bool waitForDatagram(const sf::Time &timeout);
+	//Takes the next datagram due from the other end, without waiting.
+	//	datagram : Set to the bytes of the datagram.
+	//Returns whether there was a datagram.
+	virtual bool receiveDatagram(std::vector<std::uint8_t> &datagram);
+private:
+	//The links between the two ends.
+	struct Pipe
+	{
+		std::mutex mutex; //Controls access to the pipe; shared by the network threads of both ends.
+		std::condition_variable arrived; //Woken when a datagram is sent, or the pipe is closed.
+		ImpairedLink links[2]; //What each end sends; indexed by the sending end.
+		sf::Clock clock; //The time given to both links.
+		bool isOpen = true; //Whether the pipe is still open.
+	};
+
+	std::shared_ptr<Pipe> m_pipe; //The links shared with the other end; null until connected.
+	unsigned int m_end = 0; //Which end of the pipe this is; the index of the link it sends on.
+};
@@ -0,0 +1,155 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * One battle hosted by a dedicated server, between the two players it paired; see MatchServer.hpp.
+ * The players play in lockstep with each other, as they would if one hosted; the server relays what each sends to the other.
+ * The match also runs the battle itself, from what the players send, so the server knows how it stands without trusting either player;
+ * each tick runs once both players have marked it done, as in BattleSession, and no sooner than its time at the game's 60 Hz pace.
+ * The hashes each player sends are checked against the server's own; a player whose battle differs is reported as out of sync.
+ * What a player sends is held until the match reaches its tick; so a frame stamped further ahead than a player could have run is refused,
+ * rather than held for good.
+ *
+ * A match is run by whichever worker the server hands it to, but never by two at once; it shares nothing with any other match.
+ * Messages are handed to it by the server's thread between runs, and decoded by the next run.
+ */
+#pragma once
+
+#include <cstdint> //For tick stamps.
+#include <vector> //For the messages, and commands, waiting to be handled.
+
+#include "BattleSimulation.hpp" //For the battle being run.
+
+class WireReader; //Declaration of WireReader for declaration of Match.
+
+//A battle between two players paired by a dedicated server.
+class Match
+{
+public:
+	//Basic Match constructor.
+	//	hullKey : Pristine collision key of the hull every ship is built from; must outlive the match.
+	//	inputDelay : How many ticks after a command is given it is carried out; at least one.
+	//	startTime : When the match starts, by the server's clock; its first tick is due then.
+	Match(const DamageMask &hullKey, unsigned int inputDelay, const sf::Time &startTime);
+
+	//Returns the first message sent to a player; the version of the wire format, their seat, the lockstep settings, and the tick length.
+	//	seat : The player's seat; 0 plays as the host, and 1 as the joining player.
+	std::vector<std::uint8_t> createMatchMessage(unsigned int seat) const;
+
+	//Queues a message from a player, to be handled on the next run; only call while the match is not running.
+	//	seat : The seat of the player that sent it.
+	//	message : The bytes of the message; their handshake, then each flush of frames.
+	void queueMessage(unsigned int seat, std::vector<std::uint8_t> message);
+
+	//Handles the queued messages, then runs every tick that is due; at most MAX_TICKS_PER_RUN, so no match holds up the others for long.
+	//	now : The time by the server's clock.
+	//Returns how many ticks were run.
+	unsigned int run(const sf::Time &now);
+
+	//Returns whether the match needs running; it has messages waiting, or a tick is due.
+	//	now : The time by the server's clock.
+	bool isDue(const sf::Time &now) const;
+	//Returns when the next tick is due, if both players have marked it done; otherwise, the match waits on the players.
+	//	time : Set to when the next tick is due.
+	//Returns whether the next tick can run, once it is due.
+	bool getNextTickTime(sf::Time &time) const;
+
+	//Returns the tick the battle runs next.
+	std::uint32_t getTick() const;
+	//Returns how far behind its time the last tick ran; the server is overloaded if this keeps growing.
+	sf::Time getLastLateness() const;
+	//Returns whether the battle is finished.
+	bool isFinished() const;
+	//Returns the seat of the player whose ship survived; only meaningful once the battle is finished.
+	unsigned int getWinner() const;
+	//Returns whether a player sent something the match could not accept; a handshake of another version, or with other settings,
+	//or a malformed message, or a frame stamped too far past the match.
+	//The match cannot go on; the server closes it.
+	bool isRejected() const;
+	//Returns whether a hash sent by the player differed from the server's for the same tick.
+	//	seat : The seat of the player.
+	bool isDesynced(unsigned int seat) const;
+private:
+	//The hash of the battle's state at the end of a tick.
+	struct TickHash
+	{
+		std::uint32_t tick; //The tick the hash is of.
+		std::uint64_t hash; //The hash of the battle's state at the end of the tick.
+	};
+
+	//What the match knows of each player.
+	struct Seat
+	{
+		std::vector<std::vector<std::uint8_t>> inbox; //Messages received, and not yet handled; in order.
+		bool hasHandshake = false; //Whether the player's handshake has been handled; every message after it is a flush of frames.
+		std::int64_t confirmedTick = -1; //The last tick the player has sent every command for; -1 before they have marked any.
+		std::vector<TickHash> pendingHashes; //Hashes from the player of ticks the match has not run yet.
+		bool isDesynced = false; //Whether a hash from the player differed from the server's.
+	};
+
+	static constexpr unsigned int MAX_TICKS_PER_RUN = 5; //The most ticks one run catches up on; as the game's catch-up limit.
+	static constexpr std::size_t HASH_HISTORY = 256; //How many ticks' hashes are kept, to check the players' hashes against.
+	//How many ticks past the match's a player's frame may be stamped; a player only runs ahead while the match catches up.
+	static constexpr std::uint32_t MAX_FRAME_LEAD = 600;
+
+	BattleSimulation m_simulation; //The battle; run on whichever worker runs the match, so never given workers of its own.
+	unsigned int m_inputDelay; //How many ticks after a command is given it is carried out.
+	Seat m_seats[2]; //The two players; the host, then the joining player.
+
+	std::vector<BattleCommand> m_pendingCommands; //Commands received that are stamped for a later tick.
+	std::vector<TickHash> m_hashes = std::vector<TickHash>(HASH_HISTORY, {UINT32_MAX, 0}); //Hash at the end of each recent tick; by tick.
+
+	sf::Time m_nextTickTime; //When the next tick is due.
+	sf::Time m_lastLateness; //How far behind its time the last tick ran.
+	bool m_isWaitingOnPlayers = true; //Whether the next tick was waiting on the players, when the match last ran.
+	bool m_isRejected = false; //Whether a player sent something the match could not accept.
+
+	//Handles the handshake; the first message from a player.
+	//	seat : The seat of the player.
+	//	reader : Reads the message.
+	//Returns whether the handshake was accepted.
+	bool receiveHandshake(unsigned int seat, WireReader &reader);
+	//Handles every frame in a message from a player.
+	//	seat : The seat of the player.
+	//	reader : Reads the message.
+	//Returns whether every frame was well-formed, and stamped within MAX_FRAME_LEAD ticks of the match.
+	bool receiveFrames(unsigned int seat, WireReader &reader);
+	//Returns whether both players have marked the next tick done.
+	bool canTick() const;
+	//Applies the commands for the next tick, runs it, and checks the players' hashes against it.
+	void tick();
+	//Checks the players' hashes of the ticks the match has run against its own.
+	void checkStateHashes();
+};
+
+//Returns the tick the battle runs next.
+inline std::uint32_t Match::getTick() const
+{
+	return m_simulation.getTick();
+}
+
+//Returns how far behind its time the last tick ran; the server is overloaded if this keeps growing.
+inline sf::Time Match::getLastLateness() const
+{
+	return m_lastLateness;
+}
+
+//Returns whether the battle is finished.
+inline bool Match::isFinished() const
+{
+	return m_simulation.isFinished();
+}
+
+//Returns whether a player sent something the match could not accept; a handshake of another version, or with other settings,
+//or a malformed message, or a frame stamped too far past the match.
+//The match cannot go on; the server closes it.
+inline bool Match::isRejected() const
+{
+	return m_isRejected;
+}
+
+//Returns whether a hash sent by the player differed from the server's for the same tick.
+//	seat : The seat of the player.
+inline bool Match::isDesynced(unsigned int seat) const
+{
+	return m_seats[seat].isDesynced;
+}
@@ -0,0 +1,136 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * A dedicated server without a window, that hosts many matches at once; players join it as they would join another player.
+ * One thread owns every socket; it waits on a selector over the listener, and every player's socket, for whatever is ready next,
+ * or until the soonest tick of any match is due. Sockets are non-blocking, so no player can hold up the others.
+ * Players are paired into matches in the order they join; each is sent their seat, and the match's lockstep settings, and the battle starts.
+ * Everything a player sends after that is relayed to the other player at once, and queued on the match; see Match.hpp.
+ *
+ * Every match that is due is run on a pool of workers, one match to a chunk, so many independent battles run at once.
+ * The number of matches is capped at a target per worker; players who join past the cap wait in the lobby until a match ends.
+ * Every so often the server reports how many matches it is running, and how far behind their time their ticks ran;
+ * if the ticks fall further and further behind, the target is too high for the machine.
+ * A match ends when either player leaves; the other player is disconnected too, as their battle cannot go on without them.
+ * A player who lets more than MAX_OUTGOING_BYTES back up unsent is not reading what is sent to them, and is disconnected;
+ * so no player can make the server hold on to everything the other player sends.
+ */
+#pragma once
+
+#include <deque> //For the players waiting in the lobby.
+#include <memory> //For smart pointers.
+#include <vector> //For the players, and the matches.
+
+#include <SFML/Network.hpp> //For the sockets.
+
+#include "JobSystem.hpp" //For running the matches.
+#include "Match.hpp" //For the matches being hosted.
+
+//Dedicated server that pairs players into matches, and runs the matches on a pool of workers.
+class MatchServer
+{
+public:
+	//Basic MatchServer constructor.
+	//	hullKey : Pristine collision key of the hull every ship is built from; must outlive the server.
+	//	workerCount : How many workers run the matches, including the server's thread; at least one.
+	//	matchesPerWorker : How many matches each worker is expected to keep up with; the server hosts at most this many per worker.
+	//	inputDelay : How many ticks after a command is given it is carried out, in every match.
+	MatchServer(const DamageMask &hullKey, unsigned int workerCount, unsigned int matchesPerWorker, unsigned int inputDelay);
+
+	//Starts listening for players on the port.
+	//	port : The port to listen on.
+	//Returns whether the server could listen on the port.
+	bool listen(unsigned short port);
+	//Runs the server; accepting players, pairing them into matches, and running the matches.
+	//	duration : How long to run for; zero to run until the process is stopped.
+	void run(const sf::Time &duration = sf::Time::Zero);
+
+	//Returns the most matches the server hosts at once.
+	std::size_t getMatchCapacity() const;
+private:
+	struct HostedMatch;
+
+	static constexpr std::size_t MAX_OUTGOING_BYTES = 256 * 1024; //The most bytes queued for a player; seconds of a match's traffic.
+
+	//A player connected to the server.
+	struct Player
+	{
+		sf::TcpSocket socket; //The connection to the player.
+		std::deque<sf::Packet> outgoing; //Packets waiting to be sent; the first may have been partly sent.
+		std::size_t outgoingBytes = 0; //How many bytes the packets waiting to be sent hold, in all.
+		HostedMatch *match = nullptr; //The match the player is in; null while they wait in the lobby.
+		unsigned int seat = 0; //The player's seat in their match.
+		bool isClosed = false; //Whether the player has left, or been disconnected.
+	};
+
+	//A match being hosted, and the players in it.
+	struct HostedMatch
+	{
+		std::unique_ptr<Match> match; //The match itself.
+		Player *players[2]; //The players in the match; by seat.
+		std::uint64_t id; //Number of the match; for the log.
+		unsigned int ticksRun = 0; //How many ticks the last run of the match ran.
+		bool isFinishReported = false; //Whether the end of the battle has been logged.
+		bool isDesyncReported[2] = {false, false}; //Whether each player's desync has been logged.
+	};
+
+	//What the server has done since the last report.
+	struct Stats
+	{
+		std::uint64_t ticks = 0; //How many ticks were run, over every match.
+		std::uint64_t batches = 0; //How many times the due matches were run.
+		sf::Time batchTime; //How long the batches took, in all.
+		sf::Time longestBatch; //How long the longest batch took.
+		sf::Time latestTick; //How far behind its time the latest tick ran.
+	};
+
+	const DamageMask &m_hullKey; //Pristine collision key of the hull every ship is built from.
+	unsigned int m_inputDelay; //How many ticks after a command is given it is carried out, in every match.
+	JobSystem m_jobs; //Workers that run the matches.
+	std::size_t m_matchCapacity; //The most matches hosted at once.
+
+	sf::TcpListener m_listener; //Listener for players joining.
+	sf::SocketSelector m_selector; //Wakes the server when a player joins, or sends something.
+	sf::Clock m_clock; //The server's clock; every match is timed by it.
+
+	std::vector<std::unique_ptr<Player>> m_players; //Every player connected.
+	std::deque<Player*> m_lobby; //Players waiting for a match; in the order they joined.
+	std::vector<std::unique_ptr<HostedMatch>> m_matches; //Every match being hosted.
+	std::uint64_t m_nextMatchId = 1; //Number of the next match started.
+
+	std::vector<HostedMatch*> m_dueMatches; //The matches being run by the current batch.
+	Stats m_stats; //What the server has done since the last report.
+	sf::Time m_nextReportTime; //When the next report is due.
+
+	//Accepts every player waiting to join, and puts them in the lobby.
+	void acceptPlayers();
+	//Receives every packet the player has sent; relaying each to the other player in their match, and queuing it on the match.
+	//	player : The player.
+	void receiveFrom(Player &player);
+	//Queues a packet to send to a player, and sends as much of their queue as the socket takes;
+	//a player whose queue would grow past MAX_OUTGOING_BYTES is disconnected instead.
+	//	player : The player to send to.
+	//	packet : The packet to send.
+	void sendTo(Player &player, const sf::Packet &packet);
+	//Sends as much of the player's queued packets as the socket takes, without waiting.
+	//	player : The player to send to.
+	void flush(Player &player);
+
+	//Pairs the players in the lobby into matches, in the order they joined; while there is room for another match.
+	void pairPlayers();
+	//Runs every match that is due on the workers, then logs anything that happened in them.
+	void runMatches();
+	//Ends every match a player has left, or that was rejected; disconnecting both players. Then drops every player that has left.
+	void closeMatches();
+	//Returns how long the server may wait for a socket before a match is due.
+	sf::Time getWaitTime() const;
+	//Reports what the server has done since the last report, if a report is due.
+	//	isForced : Whether to report even if it is not due yet.
+	void report(bool isForced);
+};
+
+//Returns the most matches the server hosts at once.
+inline std::size_t MatchServer::getMatchCapacity() const
+{
+	return m_matchCapacity;
+}
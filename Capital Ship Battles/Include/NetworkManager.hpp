@@ -2,30 +2,60 @@
  * Author: George Mostyn-Parry
  *
  * Networks battles between two players.
- * The players need to be connected together before the battle starts, and the BattleState told to use networking.
- * Uses TCP sockets; the packets are not that regular, as we only send the commands and not constant updates of state.
+ * The players need to be connected together before the battle starts, and the BattleSession told to use networking.
+ * The connection itself is left to a Transport; see Transport.hpp.
+ * Uses TCP sockets by default; the packets are not that regular, as we only send the commands and not constant updates of state.
+ * Over TCP though, one lost segment holds back every command after it until it is retransmitted; so UDP may be used instead.
+ * Loss, and latency, may be injected into what is sent over UDP, for testing on loopback. For testing in one process, the manager may
+ * instead be given one end of a LoopbackTransport pair; which needs no sockets, and may be impaired further.
+ * Packets are encoded in the portable wire format of WireFormat.hpp.
+ * The first packet each way is the handshake; the version of the format, the sender's settings, then the sender's ship.
+ * The settings are whether the sender plays in lockstep, its input delay, and its tick length; a peer whose settings differ is refused,
+ * as its battle would run apart from ours.
+ * After it, messages are not sent as they are given; they are batched into one frame per tick, stamped with the tick, and closed after the tick runs.
+ * The network thread flushes every closed frame as one packet whenever it wakes; at least once per flush latency, as well as on receiving.
+ * So however many commands are given in a tick, or ticks run between flushes, a flush is a single send.
  * 
- * This class does not guarantee the battle will remain in sync. It only ensures all commands are sent between the two players.
+ * By default, this class does not guarantee the battle will remain in sync; commands are carried out by each peer when they arrive.
+ * In lockstep mode, every command is stamped for the tick a fixed input delay after it was given, and carried out at that tick by both peers;
+ * each peer's frame for a tick also marks every command for the tick the delay ahead as sent, and neither runs a tick until the other has marked it.
+ * Both peers then run the same ticks, with the same commands, in the same order; so as long as both run the same build, they stay in sync.
+ * To check they do, each peer periodically sends the hash of its battle's state, which the other compares against its own for the tick.
+ * Lockstep uses a shared layout of the layers; the host's ship is always on layer 0, and the joining player's on layer 1.
+ *
+ * A player may instead join a dedicated server, which pairs the players that join it into matches; see MatchServer.hpp.
+ * The server's first message to each player is the match; the version of the format, the player's seat, the lockstep settings,
+ * and the tick length. The player takes the lockstep settings, but is refused if their tick length differs.
+ * The player in seat 0 then plays as the host; after that, the server relays everything each player sends to the other, unchanged.
  */
 #pragma once
 
+#include <cstdint> //For tick stamps.
+#include <vector> //For the frames waiting to be flushed.
+
 #include <SFML/Network.hpp> //For networking with SFML.
 
-#include "Turret.hpp" //Needed for storing turret build info.
+#include "BattleCommand.hpp" //For handing received commands to the battle.
+#include "CSB_Functions.hpp" //For the default tick length.
+#include "TcpTransport.hpp" //The default transport.
+#include "UdpTransport.hpp" //For connecting over UDP.
+#include "WireFormat.hpp" //For encoding, and decoding, the packets.
 
-class BattleState; //Declaration of BattleState for declaration of NetworkManager.
+class BattleSession; //Declaration of BattleSession for declaration of NetworkManager.
 
-//What type of packet is being sent or received.
+//What type of message is being sent or received; the first byte of every message in a frame, so only add types to the end.
 enum class PacketType : uint8_t
 {
 	CONNECT,
 	DISCONNECT,
 	MOVE,
-	FIRE
+	FIRE,
+	STATE_HASH,
+	MATCH
 };
 
 //Class for connecting two players together, networking a battle between them,
-//and handles the receiving and sending of packets over a TCPSocket.
+//and handles the receiving and sending of packets over a transport.
 class NetworkManager
 {
 public:
@@ -40,42 +70,153 @@ public:
 	//Stops any connections, and any attempts to connect to another user.
 	void closeAllConnections();
 
-	//Handles receiving of packets from the peer; the main loop of the network manager.
+	//Handles receiving of packets from the peer, and flushing closed frames to them; the main loop of the network manager.
 	void receive();
-	//Send a packet to the other user.
-	// packet : The network packet that will be sent.
-	void send(sf::Packet packet);
+	//Adds a move, or fire, command given to the local player's ship to the frame being built.
+	//	command : The command given; stamped with the tick the frame will be closed at, plus the input delay in lockstep.
+	void sendCommand(const BattleCommand &command);
+	//Adds the hash of the battle's state at the end of the tick the frame will be closed at to the frame being built; only used in lockstep.
+	//	hash : The hash of the battle's state.
+	void sendStateHash(std::uint64_t hash);
+	//Closes the frame being built, to be flushed by the network thread; called after each tick runs.
+	//Without lockstep, a frame with no messages is dropped; in lockstep, every frame is sent, as it marks the tick done.
+	//	tick : The tick that just ran; the frame is stamped with it.
+	void closeFrame(std::uint32_t tick);
+
+	//Sets whether battles are networked in lockstep; both players must use the same settings. Only call before a battle starts.
+	//	isLockstep : Whether battles are networked in lockstep.
+	//	inputDelay : How many ticks after a command is given it is carried out; long enough for it to reach the other user.
+	void setLockstep(bool isLockstep, unsigned int inputDelay);
+	//Sets how long each tick lasts; both players must use the same. Only call before a battle starts.
+	//	tickLength : How long each tick lasts.
+	void setTickLength(const sf::Time &tickLength);
+	//Sets how long a closed frame may wait for the network thread to flush it; at least a millisecond. Only call before a battle starts.
+	//	flushLatency : The longest a closed frame waits to be sent.
+	void setFlushLatency(const sf::Time &flushLatency);
+	//Sets whether the operating system may hold back small sends to merge them; off by default, as frames are already batched.
+	//Applied to the next connection.
+	//	isNagleEnabled : Whether Nagle's algorithm is enabled.
+	void setNagleEnabled(bool isNagleEnabled);
+	//Sets whether to connect over UDP, rather than TCP; both players must use the same transport. Only call while not connected.
+	//	isUdpEnabled : Whether to connect over UDP.
+	void setUdpEnabled(bool isUdpEnabled);
+	//Sets how badly what is sent over UDP is dropped, and delayed, before it reaches the socket; for testing. Only call while not connected.
+	//	impairment : The model to impair datagrams by.
+	void setImpairment(const LinkImpairment &impairment);
+	//Uses a transport that is already connected, in place of hosting, or joining; i.e. one end of a LoopbackTransport pair.
+	//Only call while not connected; the transport must outlive the battle.
+	//	transport : The connected transport.
+	//	isHost : Whether the local player is taken as the host.
+	void useTransport(Transport &transport, bool isHost);
+	//Sets whether joining connects to a dedicated server, which pairs the player with another, rather than to another player.
+	//The server decides who plays as the host, and the lockstep settings; so they replace any set here. Only call while not connected.
+	//	isDedicatedServer : Whether joining connects to a dedicated server.
+	void setDedicatedServer(bool isDedicatedServer);
 
 	//Sets the turret list of the ship built by the local player.
 	//	shipTurrets : List of information to build the turrets on the local player's ship.
 	void setTurretList(const std::vector<TurretInfo> &shipTurrets);
 	//Sets the battle to the passed value.
 	//	newBattle : The battle we want the network manager to handle the networking for.
-	void setBattle(BattleState *newBattle);
+	void setBattle(BattleSession *newBattle);
 	//Sends the ship built by the local user to the other user.
 	void sendShip();
 
+	//Returns where the local player's ship starts the battle; the top-left for the host, and the bottom-right for the joining player.
+	sf::Vector2f getStartPosition() const;
+	//Returns the angle the local player's ship starts the battle at; facing the other player's ship.
+	float getStartAngle() const;
+
 	//Returns whether the local player is the host.
 	bool isHost() const;
+	//Returns whether battles are networked in lockstep.
+	bool isLockstep() const;
+	//Returns how many ticks after a command is given it is carried out, in lockstep.
+	unsigned int getInputDelay() const;
+	//Returns the layer of the local player's ship.
+	unsigned int getLocalLayer() const;
+	//Returns the layer of the other user's ship.
+	unsigned int getRemoteLayer() const;
 private:
 	static constexpr unsigned int PORT = 25565; //The port the server is being run on.
 
 	bool m_isHost = false; //Whether the local player is the host.
+	bool m_isDedicatedServer = false; //Whether joining connects to a dedicated server, rather than to another player.
+	bool m_isLockstep = false; //Whether battles are networked in lockstep.
+	unsigned int m_inputDelay = 4; //How many ticks after a command is given it is carried out, in lockstep.
+	sf::Time m_tickLength = CSB::tickLength(CSB::DEFAULT_TICK_RATE); //How long each tick lasts; sent in the handshake, as the peer must use the same.
+	sf::Time m_flushLatency = sf::milliseconds(5); //The longest a closed frame waits for the network thread to flush it.
 
-	sf::TcpSocket m_socket; //Socket that manages the connection to the other player.
-	sf::TcpListener m_listener; //Listener for gaining new clients.
+	TcpTransport m_tcpTransport; //Connects over TCP.
+	UdpTransport m_udpTransport; //Connects over UDP.
+	Transport *m_transport = &m_tcpTransport; //The transport connecting, or connected, to the other player.
 
 	std::vector<TurretInfo> m_shipTurrets; //List of turrets that the local user placed on their ship.
 
-	BattleState *m_battle; //The battle that is being networked.		
+	BattleSession *m_battle; //The battle that is being networked.		
+
+	WireWriter m_openFrame; //Messages of the frame being built; only used by the thread running the battle.
+	std::uint64_t m_openMessageCount = 0; //How many messages are in the frame being built.
+	std::vector<std::uint8_t> m_handshake; //The handshake, waiting to be flushed; sent before any frame.
+	std::vector<std::uint8_t> m_closedFrames; //Frames closed, and waiting to be flushed; one after another.
+	sf::Mutex m_frameMutex; //Controls access to the handshake, and the closed frames; shared by the battle's thread and the network thread.
 	
-	//Unpackages the data of the ship built by the other user, and creates the ship in the battle.
-	//	shipPacket : Network packet containing the data on the ship.
-	void unpackageShip(sf::Packet shipPacket);
+	//Queues a command received from the peer onto the battle; waits for room while the battle catches up, unless the peer disconnects.
+	//	command : The command received.
+	void queueCommand(BattleCommand &&command);
+	//Waits for a dedicated server to pair the local player into a match, and takes the settings of the match from it.
+	//Returns whether the player was put in a match; false if the server is of another version, or tick length, or the connection is closed.
+	bool waitForMatch();
+	//Handles the handshake; the first packet from the peer.
+	//	reader : Reads the packet.
+	//Returns whether the handshake was accepted.
+	bool receiveHandshake(WireReader &reader);
+	//Handles every frame in a packet from the peer.
+	//	reader : Reads the packet.
+	void receiveFrames(WireReader &reader);
+	//Sends the handshake, and every closed frame, to the other user; only call from the network thread.
+	void flush();
 };
 
 //Returns whether the local player is the host.
 inline bool NetworkManager::isHost() const
 {
 	return m_isHost;
-}
\ No newline at end of file
+}
+
+//Returns where the local player's ship starts the battle; the top-left for the host, and the bottom-right for the joining player.
+inline sf::Vector2f NetworkManager::getStartPosition() const
+{
+	return m_isHost ? sf::Vector2f(1800, 1800) : sf::Vector2f(2200, 2200);
+}
+
+//Returns the angle the local player's ship starts the battle at; facing the other player's ship.
+inline float NetworkManager::getStartAngle() const
+{
+	return m_isHost ? 45.f : 225.f;
+}
+
+//Returns whether battles are networked in lockstep.
+inline bool NetworkManager::isLockstep() const
+{
+	return m_isLockstep;
+}
+
+//Returns how many ticks after a command is given it is carried out, in lockstep.
+inline unsigned int NetworkManager::getInputDelay() const
+{
+	return m_inputDelay;
+}
+
+//Returns the layer of the local player's ship.
+inline unsigned int NetworkManager::getLocalLayer() const
+{
+	//Without lockstep, each player sees their own ship on the first layer.
+	return m_isLockstep && !m_isHost ? 1 : 0;
+}
+
+//Returns the layer of the other user's ship.
+inline unsigned int NetworkManager::getRemoteLayer() const
+{
+	return 1 - getLocalLayer();
+}
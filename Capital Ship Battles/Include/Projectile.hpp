@@ -1,7 +1,8 @@
 /*
  * Author: George Mostyn-Parry
  *
- * A class and data types for creating and updating a projectile.
+ * Data types for creating projectiles, and the table of how each projectile type looks and moves.
+ * The projectiles themselves are stored in a ProjectilePool.
  */
 #pragma once
 
@@ -24,53 +25,14 @@ struct ShotInfo
 	sf::Vector2f target; //Where the projectile is heading towards from its spawn position.
 };
 
-//Class on projectiles that will travel across the screen to hit a target.
-class Projectile : public sf::RectangleShape
+//How a type of projectile looks, and moves; shared by every projectile of that type.
+struct ProjectileTypeInfo
 {
-public:
-	//Construct a projectile with the passed ShotInfo.
-	//	info : Information on how to construct the projectile.
-	Projectile(const ShotInfo &info);
-	//Processes the projectile for this tick.
-	//	deltaTime : How much time has passed since the last update.
-	void update(const sf::Time &deltaTime);
-
-	//Returns the projectile's type.
-	ProjectileType getProjectileType() const;
-	//Returns the layer the projectile exists on.
-	unsigned int getLayer() const;
-	//Returns the velocity the projectile is travelling at.
-	const sf::Vector2f& getVelocity() const;
-
-	//Returns whether the projectile has been marked for clean-up.
-	bool requiresCleanup() const;
-private:
-	ProjectileType m_projType; //The projectile's type.
-	unsigned int m_layer; //Which layer the projectile is on; i.e. which team it should hit.
-	sf::Vector2f m_velocity; //Velocity of the projectile.
-	bool m_isFinished = false; //Whether the projectile is finished, and needs cleaning up.
+	sf::Vector2f size; //Size of the projectile's rectangle.
+	sf::Color colour; //Colour the projectile is drawn with.
+	float speed; //How many co-ordinates per second the projectile moves.
 };
 
-//Returns the projectile's type.
-inline ProjectileType Projectile::getProjectileType() const
-{
-	return m_projType;
-}
-
-//Returns the layer the projectile exists on.
-inline unsigned int Projectile::getLayer() const
-{
-	return m_layer;
-}
-
-//Returns the velocity the projectile is travelling at.
-inline const sf::Vector2f& Projectile::getVelocity() const
-{
-	return m_velocity;
-}
-
-//Returns whether the projectile has been marked for clean-up.
-inline bool Projectile::requiresCleanup() const
-{
-	return m_isFinished;
-}
\ No newline at end of file
+//Returns how the passed type of projectile looks, and moves.
+//	projType : The type of projectile we want the information of.
+const ProjectileTypeInfo& getProjectileTypeInfo(ProjectileType projType);
@@ -0,0 +1,112 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * A pool that stores every active projectile in a battle as a structure of arrays.
+ * Each property of the projectiles is kept in its own contiguous array, so a tick walks memory in order,
+ * and creating a projectile reuses a slot freed by an earlier removal rather than allocating on the heap.
+ * Removal swaps the last projectile into the removed slot, so removal is constant time, but does not keep the order of projectiles.
+ */
+#pragma once
+
+#include <vector> //For the property arrays.
+
+#include "Projectile.hpp" //For creating projectiles from shots, and the projectile type table.
+
+//Stores every active projectile as a structure of arrays; projectiles are referred to by their index in the pool.
+class ProjectilePool
+{
+public:
+	//Basic ProjectilePool constructor.
+	//	initialCapacity : How many projectiles the pool can hold before it has to grow.
+	ProjectilePool(std::size_t initialCapacity = 1024);
+
+	//Creates a projectile with the passed information.
+	//	info : Information on how to construct the projectile.
+	void create(const ShotInfo &info);
+	//Creates a projectile for each shot in the list, in order; the pool grows at most once for the whole list.
+	//	shots : Information on how to construct each projectile.
+	void create(const std::vector<ShotInfo> &shots);
+	//Removes the projectile at the index; the last projectile in the pool is moved into its place.
+	//	index : Index of the projectile to remove.
+	void remove(std::size_t index);
+	//Removes every projectile in the pool.
+	void clear();
+
+	//Moves every projectile in the pool by its velocity.
+	//	deltaTime : How much time has passed since the last update.
+	void update(const sf::Time &deltaTime);
+	//Moves a range of projectiles in the pool by their velocity; ranges that do not overlap may be moved from different threads at once.
+	//	deltaTime : How much time has passed since the last update.
+	//	begin : Index of the first projectile to move.
+	//	end : Index after the last projectile to move.
+	void update(const sf::Time &deltaTime, std::size_t begin, std::size_t end);
+
+	//Returns how many projectiles are in the pool.
+	std::size_t size() const;
+
+	//Returns the position of the projectile at the index.
+	//	index : Index of the projectile.
+	const sf::Vector2f& getPosition(std::size_t index) const;
+	//Returns the velocity the projectile at the index is travelling at.
+	//	index : Index of the projectile.
+	const sf::Vector2f& getVelocity(std::size_t index) const;
+	//Returns the layer the projectile at the index exists on.
+	//	index : Index of the projectile.
+	unsigned int getLayer(std::size_t index) const;
+	//Returns the type of the projectile at the index.
+	//	index : Index of the projectile.
+	ProjectileType getProjectileType(std::size_t index) const;
+	//Returns the rotation of the projectile at the index, in degrees.
+	//	index : Index of the projectile.
+	float getRotation(std::size_t index) const;
+	//Returns the bounding rectangle of the projectile at the index, in global co-ordinates.
+	//	index : Index of the projectile.
+	sf::FloatRect getGlobalBounds(std::size_t index) const;
+private:
+	std::vector<sf::Vector2f> m_positions; //Position of each projectile; the centre of its rectangle.
+	std::vector<sf::Vector2f> m_velocities; //Velocity of each projectile.
+	std::vector<unsigned int> m_layers; //Which layer each projectile is on; i.e. which team it should hit.
+	std::vector<ProjectileType> m_types; //The type of each projectile.
+	std::vector<float> m_rotations; //Rotation of each projectile, in degrees.
+};
+
+//Returns how many projectiles are in the pool.
+inline std::size_t ProjectilePool::size() const
+{
+	return m_positions.size();
+}
+
+//Returns the position of the projectile at the index.
+//	index : Index of the projectile.
+inline const sf::Vector2f& ProjectilePool::getPosition(std::size_t index) const
+{
+	return m_positions[index];
+}
+
+//Returns the velocity the projectile at the index is travelling at.
+//	index : Index of the projectile.
+inline const sf::Vector2f& ProjectilePool::getVelocity(std::size_t index) const
+{
+	return m_velocities[index];
+}
+
+//Returns the layer the projectile at the index exists on.
+//	index : Index of the projectile.
+inline unsigned int ProjectilePool::getLayer(std::size_t index) const
+{
+	return m_layers[index];
+}
+
+//Returns the type of the projectile at the index.
+//	index : Index of the projectile.
+inline ProjectileType ProjectilePool::getProjectileType(std::size_t index) const
+{
+	return m_types[index];
+}
+
+//Returns the rotation of the projectile at the index, in degrees.
+//	index : Index of the projectile.
+inline float ProjectilePool::getRotation(std::size_t index) const
+{
+	return m_rotations[index];
+}
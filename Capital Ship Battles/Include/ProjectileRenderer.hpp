@@ -0,0 +1,32 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Draws every projectile in a ProjectilePool with a single draw call.
+ * Each projectile becomes a rotated quad in one vertex array, coloured and sized from the projectile type table;
+ * the vertex array keeps its memory between frames, so rebuilding it does not allocate once it has reached its peak size.
+ */
+#pragma once
+
+#include <SFML/Graphics.hpp> //For the vertex array, and drawing.
+
+#include "ProjectilePool.hpp" //For the projectiles we are drawing.
+
+//Batches every projectile in a pool into one vertex array of quads, so they may be drawn with one draw call.
+class ProjectileRenderer : public sf::Drawable
+{
+public:
+	//Basic ProjectileRenderer constructor.
+	ProjectileRenderer();
+
+	//Rebuilds the quads from the projectiles in the pool; the pool must not be changed while this is running.
+	//	projectiles : The projectiles that will be drawn.
+	//	rewind : How far back along its velocity each projectile is drawn; for drawing a moment before the end of the tick.
+	void update(const ProjectilePool &projectiles, const sf::Time &rewind = sf::Time::Zero);
+
+	//Draws every projectile in the batch with a single draw call.
+	//	target : What we will be drawing onto.
+	//	states : Visual manipulations to the elements that are being drawn.
+	virtual void draw(sf::RenderTarget &target, sf::RenderStates states) const;
+private:
+	sf::VertexArray m_vertices; //Four vertices for every projectile; one quad each.
+};
@@ -0,0 +1,72 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * An immutable copy of everything needed to draw a battle at the end of a tick.
+ * Filled by the simulation thread, and handed to the rendering thread through a TripleBuffer;
+ * so the rendering thread never reads the simulation itself, and never takes any of its locks.
+ * Ships and turrets keep their pose from the tick before as well, so frames drawn between ticks can interpolate between the two.
+ */
+#pragma once
+
+#include <vector> //For the ship and turret lists.
+
+#include "CSB_Functions.hpp" //For interpolating rotations.
+#include "DamageMask.hpp" //For the damage of each ship.
+#include "ProjectilePool.hpp" //For the projectiles.
+
+//How a turret looks at the end of a tick.
+struct TurretSnapshot
+{
+	ProjectileType projType; //The type of projectile the turret fires; picks its sprite.
+	sf::Vector2f localPosition; //Turret's position relative to the ship.
+	float rotation; //Turret's rotation relative to the ship.
+	float previousRotation; //Turret's rotation at the end of the tick before.
+};
+
+//Where a ship is, and which way it faces.
+struct ShipPose
+{
+	sf::Vector2f position; //Global position of the ship's origin.
+	float rotation; //The ship's rotation.
+};
+
+//How a ship looks at the end of a tick.
+struct ShipSnapshot
+{
+	ShipPose pose; //Where the ship is at the end of the tick.
+	ShipPose previousPose; //Where the ship was at the end of the tick before.
+	sf::Vector2f origin; //Point of the hull the ship is positioned, and rotated, around.
+	sf::IntRect textureRect; //Area of the hull texture the ship is drawn with.
+	DamageMask damage; //Which cells of the hull are still intact.
+	std::vector<TurretSnapshot> turrets; //The turrets still mounted on the ship.
+
+	//Returns the ship's transform, from the hull's pixels to global co-ordinates, part of the way from its previous pose to its pose.
+	//	interpolation : How far from the previous pose to place the ship; 1 places it where it is at the end of the tick.
+	sf::Transform getTransform(float interpolation) const;
+};
+
+//Everything needed to draw a battle at the end of a tick.
+struct RenderSnapshot
+{
+	std::vector<ShipSnapshot> ships; //Every ship; layer by layer, in the order they are drawn.
+	ProjectilePool projectiles; //Every active projectile.
+
+	sf::Time tickTime; //When the tick was due on the game clock; a frame drawn a tick later shows the battle as of the end of the tick.
+	sf::Time tickLength; //How much time the tick moved the battle forward.
+	sf::Time tickInterval; //Time on the game clock until the next tick is due; longer than the tick length while the game is dilated.
+};
+
+//Returns the ship's transform, from the hull's pixels to global co-ordinates, part of the way from its previous pose to its pose.
+//	interpolation : How far from the previous pose to place the ship; 1 places it where it is at the end of the tick.
+inline sf::Transform ShipSnapshot::getTransform(float interpolation) const
+{
+	//The ship's position and rotation between the two poses.
+	const sf::Vector2f position = previousPose.position + (pose.position - previousPose.position) * interpolation;
+	const float rotation = CSB::lerpAngle(previousPose.rotation, pose.rotation, interpolation);
+
+	//The same transform as a sprite with the position, rotation, and origin; the ships are never scaled.
+	sf::Transform transform;
+	transform.translate(position).rotate(rotation).translate(-origin);
+
+	return transform;
+}
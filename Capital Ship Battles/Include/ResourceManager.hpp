@@ -1,12 +1,17 @@
 /*
  * Author: George Mostyn-Parry
  *
- * A simple class to manage the access, and lifetime, of resources; such as textures, and fonts.
+ * A simple class to manage the access, and lifetime, of resources; such as textures, fonts, and shaders.
  */
 #pragma once
 
+#include <map> //For the resource tables.
+#include <utility> //For keying shaders by path and stage.
+
 #include <SFML/Graphics.hpp> //For sf::Texture.
 
+#include "DamageMask.hpp" //For the collision keys of hulls.
+
 //A simple class to manage the access, and lifetime, of resources; such as textures, and fonts.
 class ResourceManager
 {
@@ -14,11 +19,27 @@ public:
 	//Returns the texture found at the file path; returns nullptr on a failed load.
 	//	filePath : File path of the texture we want to load into the resource manager, if it is not already loaded.
 	sf::Texture* loadTexture(const std::string &filePath);
+	//Returns the image found at the file path; returns nullptr on a failed load.
+	//Images stay in system memory, so they may be loaded without a graphics context.
+	//	filePath : File path of the image we want to load into the resource manager, if it is not already loaded.
+	sf::Image* loadImage(const std::string &filePath);
+	//Returns the pristine collision key of the hull image found at the file path; returns nullptr on a failed load.
+	//The key is only built the first time, and shared by every ship with the hull.
+	//	filePath : File path of the hull image we want the key of.
+	const DamageMask* loadDamageKey(const std::string &filePath);
+	//Returns the shader found at the file path, compiled for the passed stage; returns nullptr on a failed load.
+	//The shader is only compiled the first time, so every user shares the one program.
+	//	filePath : File path of the shader we want to load into the resource manager, if it is not already loaded.
+	//	type : The stage the shader is compiled for; i.e. vertex, or fragment.
+	sf::Shader* loadShader(const std::string &filePath, sf::Shader::Type type);
 	//Returns the font found at the file path; returns nullptr on a failed load.
 	//	filePath : File path of the font we want to load into the resource manager, if it is not already loaded.
 	sf::Font* loadFont(const std::string &filePath);
 private:
 	std::map<std::string, sf::Texture> m_textureTable; //Table of all of the texures stored in the manager.
+	std::map<std::string, sf::Image> m_imageTable; //Table of all of the images stored in the manager.
+	std::map<std::string, DamageMask> m_damageKeyTable; //Table of all of the hull keys stored in the manager.
 	std::map<std::string, sf::Font> m_fontTable; //Table of all of the fonts stored in the manager.
+	std::map<std::pair<std::string, sf::Shader::Type>, sf::Shader> m_shaderTable; //Table of all of the shaders stored in the manager; keyed by path and stage.
 };
 
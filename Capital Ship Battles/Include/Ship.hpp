@@ -3,17 +3,28 @@
  *
  * A class that represents a ship in the game, and handles the updating of the internal state each update tick.
  * Has a list of turrets, which it defers firing actions to.
- * Takes damage by hiding pixels that have been marked as hit on a destruction key texture, which is fed to a fragment shader.
+ * Takes damage by clearing cells of a bit-packed damage mask; the key texture derived from it is kept by the ShipRenderer.
+ * Ships of the same hull share one pristine key until they are first hit, when the ship takes its own copy; so spawning never builds a key.
  * Employs Bresenham's line algorithm to determine which pixel was struck on the ship.
+ * The ship's transform, and its inverse, are computed once per tick and shared with the turrets, collision, and the render snapshot.
+ * The damage taken is also kept as a hash of the destroyed cells, updated on each hit; so the ship's state is hashed without reading its mask.
  *
  * Does not have movement collision; i.e. it will move through any obstacle.
+ * A ship never touches the GPU, so it may be simulated without a window; it is drawn by a ShipRenderer from the snapshot it fills.
  */
 #pragma once
 
+#include <cstdint> //For the fire order, and the damage hash.
+#include <iosfwd> //For dumping the ship's state.
 #include <vector> //For vector lists.
 #include <memory> //For smart pointers.
+#include <unordered_map> //For finding the turrets mounted on a cell of the hull.
 
 #include "Turret.hpp" //For turrets mounted on the ship.
+#include "ProjectilePool.hpp" //For colliding with projectiles.
+#include "DamageMask.hpp" //For the cells of the hull that are still intact.
+#include "RenderSnapshot.hpp" //For the snapshot the ship is drawn from.
+#include "StateHash.hpp" //For hashing the ship's state.
 
 //A moving ship in the game that can fire its turrets, and taken per-pixel damage on a projectile collision.
 class Ship : public sf::Sprite
@@ -23,17 +34,30 @@ public:
 	//	position : Position the ship starts at.
 	//	angle : Angle the ship starts at.
 	//	turretList : List of turrets the ship starts with.
-	//	hullTexture : Texture of the ship hull.
-	//	turretAtlasTexture : Texture atlas for the turrets.
-	Ship(const sf::Vector2f &position, float angle, const std::vector<TurretInfo> &turretList, const sf::Texture *hullTexture, const sf::Texture *turretAtlasTexture);
+	//	pristineKey : Undamaged key of the ship hull, from createPristineKey; shared by every ship with the hull, so it must outlive the ship.
+	//	shotQueue : Queue the ship's turrets push their shots onto; nullptr for a ship whose turrets never fire, such as the one being built.
+	//	fireOrder : Where the ship's shots are placed in the queue, relative to the other ships; unique to each ship in the battle.
+	Ship(const sf::Vector2f &position, float angle, const std::vector<TurretInfo> &turretList, const DamageMask &pristineKey,
+		ShotQueue *shotQueue = nullptr, std::uint64_t fireOrder = 0);
+
+	//Builds the undamaged key of a hull; a cell is intact if any pixel in its block is opaque.
+	//Slow, as it reads every pixel of the hull; build it once per hull, and share it between ships.
+	//	hullImage : Image of the ship hull.
+	//Returns the key the hull's ships are constructed from.
+	static DamageMask createPristineKey(const sf::Image &hullImage);
 	
 	//Causes the ship to process internal data to update its state for this tick.
 	//	deltaTime : The amount of time that has passed since the last update.
 	void update(const sf::Time &deltaTime);
-	//Draw the ship, and its children, to the render target.
-	//	target : What we will draw the ship onto.
-	//	states : How to manipulate the drawing of the ship.
-	void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+	//Copies how the ship looks as of this tick into the snapshot; reuses the snapshot's memory where it can.
+	//	snapshot : The snapshot to fill.
+	void fillSnapshot(ShipSnapshot &snapshot) const;
+	//Mixes the ship's state into the hash; its pose, movement and destination, damage, and turrets.
+	//	hash : The hash to mix into.
+	void hashState(StateHash &hash) const;
+	//Writes the ship's state as text, with exact floats; so two dumps may be diffed to find where the ships diverged.
+	//	stream : The stream to write to.
+	void dumpState(std::ostream &stream) const;
 
 	//Orders the ship to move to the target position.
 	//	target : The position to move to.
@@ -47,17 +71,37 @@ public:
 	//	globalPosition : The global position to check for a collision against.
 	//Returns whether the collision occurred.
 	bool collide(const sf::Vector2f &globalPosition);
-	//Finds if there was a collision between this ship and the passed projectile.
-	//	proj : Projectile that might have collided with this ship.
+	//Finds if there was a collision between this ship and the passed projectile, and applies the damage if there was.
+	//	projectiles : Pool holding the projectile that might have collided with this ship.
+	//	index : Index of the projectile in the pool.
 	//	deltaTime : The amount of time that passed to move the projectile to this position from the last.
 	//Returns whether the collision occurred.
-	bool collide(const Projectile &proj, const sf::Time &deltaTime);
+	bool collide(const ProjectilePool &projectiles, std::size_t index, const sf::Time &deltaTime);
+	//Finds the cell of the damage mask the projectile first hit, without changing the ship; so it may be called from several threads at once.
+	//	projectiles : Pool holding the projectile that might have collided with this ship.
+	//	index : Index of the projectile in the pool.
+	//	deltaTime : The amount of time that passed to move the projectile to this position from the last.
+	//Returns the cell hit, or a value of {-1, -1} if there was no collision.
+	sf::Vector2i findHit(const ProjectilePool &projectiles, std::size_t index, const sf::Time &deltaTime) const;
+	//Destroys a cell of the damage mask, and the turrets mounted on it.
+	//	cell : The cell hit; from findHit.
+	void applyHit(const sf::Vector2i &cell);
 
 	//Builds, and adds, turrets made from the build info to this ship.
 	//	newTurrets : Build information for the new turrets.
-	//	turretAtlasTexture : Texture atlas to apply to the new turrets.
-	void addTurrets(const std::vector<TurretInfo> &newTurrets, const sf::Texture *turretAtlasTexture);
+	void addTurrets(const std::vector<TurretInfo> &newTurrets);
 
+	//Recomputes the cached transforms, and bounds, from the ship's position; done by update, so only needed when the ship is placed directly.
+	void updateTickTransforms();
+
+	//Returns the ship's transform as of this tick.
+	const sf::Transform& getTickTransform() const;
+	//Returns the inverse of the ship's transform as of this tick; converts global co-ordinates to the ship's pixels.
+	const sf::Transform& getTickInverseTransform() const;
+	//Returns the ship's global bounds as of this tick.
+	const sf::FloatRect& getTickBounds() const;
+	//Returns how many turrets are still attached to the ship.
+	std::size_t getTurretCount() const;
 	//Returns whether the ship has finished all processing, and needs to be cleaned up by the game.
 	bool requiresCleanup() const;
 private:
@@ -68,30 +112,68 @@ private:
 	};
 
 	static constexpr unsigned int KEY_SIZE_FACTOR = 4; //The factor the destruction key is smaller than the actual texture.
+	static constexpr unsigned int UNSUPPORTED_CELL = ~0u; //Cell index for turrets with no intact hull beneath them; they fall off on the next hit.
+	static constexpr unsigned int TURRET_ORDER_BITS = 20; //Low bits of a turret's fire order that number it within the ship; the ship's order is above them.
 
 	MovementState m_movementState = MovementState::IDLE; //The movement state the ship is currently in.
 	float m_speed = 0; //How many global co-ordinates the ship will move per second.
 	float m_acceleration = 20; //How much the velocity will increase per second when accelerating.
 	float m_deceleration = 10; //How much the velocity will decrease per second when decelerating.
 	sf::Vector2f m_destination; //Where the ship is currently travelling to.
+
+	sf::Transform m_tickTransform; //The ship's transform as of this tick; only changes when the ship moves in update.
+	sf::Transform m_tickInverseTransform; //Inverse of the ship's transform as of this tick.
+	sf::FloatRect m_tickBounds; //The ship's global bounds as of this tick.
+	ShipPose m_previousPose; //Where the ship was before its last update; so it can be drawn moving smoothly between updates.
 	
 	std::vector<std::unique_ptr<Turret>> m_turrets; //List of turrets attached to this ship.
+	mutable sf::Mutex m_turretMutex; //Controls access to this ship's turrets; for owners that command the ship from another thread than the one updating it.
+	std::unordered_map<unsigned int, std::vector<const Turret*>> m_turretsByCell; //Turrets mounted on each cell of the damage mask; keyed by the cell's index.
 
-	sf::Image m_keyImage; //The image representing the key of whether a hull pixel is destroyed.
-	sf::Texture m_keyTex; //The texture that holds the information of the key's image.
-	sf::Shader m_damageShader; //Shader that uses the damage key to differentiate between which pixels should be visible.
+	ShotQueue *m_shotQueue; //Queue the ship's turrets push their shots onto.
+	std::uint64_t m_fireOrder; //Where the ship's shots are placed in the queue.
+	std::uint64_t m_turretsAdded = 0; //How many turrets have been added to the ship; numbers each turret's shots within the ship's.
+
+	const DamageMask *m_damageMask; //Which blocks of hull pixels are still intact; the shared pristine key until first hit, then m_ownDamageMask.
+	DamageMask m_ownDamageMask; //The ship's own copy of the key; only taken on the first hit.
+	std::uint64_t m_damageHash = 0; //Hash of the cells destroyed; each destroyed cell's scrambled index combined by xor, so the order of hits does not matter.
 
 	//Converts global co-ordinates to the pixel this corresponds to relative to the ship's texture.
 	//	globalPosition : The global co-ordinates to to transform.
 	//Returns the pixel co-ordinates that the global co-ordinates transformed to.
 	sf::Vector2i getPixelPosition(sf::Vector2f globalPosition) const;
 	//Finds the first pixel hit by the projectile.
-	//	proj : The projectile that might have collided with the ship.
+	//	projectiles : Pool holding the projectile that might have collided with the ship.
+	//	index : Index of the projectile in the pool.
 	//	deltaTime : The amount of time that passed to move the projectile to this position from the last.
 	//Returns the first pixel hit, or a value of {-1, -1} if there was no collision.
-	sf::Vector2i firstPixelHit(const Projectile &proj, const sf::Time &deltaTime) const;
+	sf::Vector2i firstPixelHit(const ProjectilePool &projectiles, std::size_t index, const sf::Time &deltaTime) const;
 };
 
+//Returns the ship's transform as of this tick.
+inline const sf::Transform& Ship::getTickTransform() const
+{
+	return m_tickTransform;
+}
+
+//Returns the inverse of the ship's transform as of this tick; converts global co-ordinates to the ship's pixels.
+inline const sf::Transform& Ship::getTickInverseTransform() const
+{
+	return m_tickInverseTransform;
+}
+
+//Returns the ship's global bounds as of this tick.
+inline const sf::FloatRect& Ship::getTickBounds() const
+{
+	return m_tickBounds;
+}
+
+//Returns how many turrets are still attached to the ship.
+inline std::size_t Ship::getTurretCount() const
+{
+	return m_turrets.size();
+}
+
 //Returns whether the ship has finished all processing, and needs to be cleaned up by the game.
 inline bool Ship::requiresCleanup() const
 {
@@ -0,0 +1,81 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * A uniform grid over the battlefield that records which cells each ship's bounds overlap.
+ * Used as the broad-phase of projectile collision; a projectile is only tested against the ships in the cells it overlaps.
+ * The grid is updated incrementally; a ship is only moved between cells when the range of cells it overlaps changes.
+ * Queries do not change the grid, so several threads may query it at once while it is not being updated.
+ */
+#pragma once
+
+#include <vector> //For the cells, and the tracked ships.
+
+#include <SFML/Graphics.hpp> //For rectangles.
+
+class Ship; //Declaration of Ship for storing pointers in the grid.
+
+//Uniform grid of the ships on a layer; finds which ships may be colliding with an area.
+class ShipGrid
+{
+public:
+	static constexpr float DEFAULT_CELL_SIZE = 256; //Default width and height of a cell; a few times the size of a ship.
+
+	//Basic ShipGrid constructor.
+	//	area : The area the grid covers; ships outside of it are placed in the nearest edge cells.
+	//	cellSize : Width and height of each cell in the grid.
+	ShipGrid(const sf::FloatRect &area, float cellSize = DEFAULT_CELL_SIZE);
+
+	//Adds a ship to the grid.
+	//	ship : The ship to add.
+	//	order : Where the ship is in its list; candidates are returned in this order, so collisions resolve as they would without the grid.
+	void add(Ship *ship, unsigned int order);
+	//Removes a ship from the grid.
+	//	ship : The ship to remove.
+	void remove(Ship *ship);
+
+	//Moves every ship to the cells their bounds now overlap; only touches the cells of ships that changed cells.
+	void update();
+
+	//Finds every ship in the cells the area overlaps.
+	//	area : The area to find ships near, in global co-ordinates.
+	//	candidates : Filled with the ships found, in list order; cleared first.
+	void query(const sf::FloatRect &area, std::vector<Ship*> &candidates) const;
+
+	//Returns how many ships are in the grid.
+	std::size_t size() const;
+private:
+	//A ship stored in a cell.
+	struct CellEntry
+	{
+		Ship *ship; //The ship in the cell.
+		unsigned int order; //Where the ship is in its list.
+	};
+
+	//A ship tracked by the grid, and the range of cells it is currently in.
+	struct TrackedShip
+	{
+		CellEntry entry; //The ship, as it is stored in each cell.
+		sf::IntRect cells; //The range of cells the ship is in; in cell co-ordinates.
+	};
+
+	sf::FloatRect m_area; //The area the grid covers.
+	float m_cellSize; //Width and height of each cell.
+	sf::Vector2i m_gridSize; //How many cells there are along each axis.
+
+	std::vector<std::vector<CellEntry>> m_cells; //The ships in each cell; stored row by row.
+	std::vector<TrackedShip> m_trackedShips; //Every ship in the grid, and the cells it is in.
+
+	//Returns the range of cells the area overlaps, clamped to the grid.
+	//	area : The area in global co-ordinates.
+	sf::IntRect getCellRange(const sf::FloatRect &area) const;
+	//Adds, or removes, the tracked ship to each cell in its range.
+	//	trackedShip : The ship being placed, or removed.
+	//	isAdding : Whether the ship is being added to the cells; otherwise, it is removed.
+	void placeInCells(const TrackedShip &trackedShip, bool isAdding);
+};
+
+//Returns how many ships are in the grid.
+inline std::size_t ShipGrid::size() const
+{
+	return m_trackedShips.size();
+}
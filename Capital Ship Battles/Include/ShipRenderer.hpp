@@ -0,0 +1,69 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Draws ships from their render snapshots; owns every GPU resource the ships are drawn with.
+ * Keeps a key texture for each ship drawn, and only uploads the area of its damage mask that changed since it was last uploaded.
+ * The turrets of each ship are batched into a single draw call, drawn straight after the ship's hull.
+ * Ships, and their turrets, are placed part of the way from their previous pose in the snapshot, so frames between ticks move smoothly.
+ */
+#pragma once
+
+#include <memory> //For smart pointers.
+#include <vector> //For the key textures.
+
+#include "RenderSnapshot.hpp" //For the ships being drawn.
+
+//Draws ships from their render snapshots, with the damage shader and turret atlas.
+class ShipRenderer : public sf::Drawable
+{
+public:
+	//Basic ShipRenderer constructor.
+	//	hullTexture : Texture of the ship hull.
+	//	turretAtlasTexture : Texture atlas for the turrets.
+	//	damageShader : Damage shader shared by every ship; nullptr if shaders are unavailable, in which case damage is not shown.
+	ShipRenderer(const sf::Texture *hullTexture, const sf::Texture *turretAtlasTexture, sf::Shader *damageShader);
+
+	//Uploads each ship's damage, and rebuilds the turrets, from the snapshots; call once per frame before drawing.
+	//	ships : Snapshots of the ships to draw; must stay unchanged until they have been drawn.
+	//	interpolation : How far from their previous poses to draw the ships; 1 draws them where they are at the end of the tick.
+	void update(const std::vector<ShipSnapshot> &ships, float interpolation = 1);
+
+	//Draws every ship, with its turrets drawn over it.
+	//	target : What we will be drawing onto.
+	//	states : Visual manipulations to the ships that are being drawn.
+	virtual void draw(sf::RenderTarget &target, sf::RenderStates states) const;
+
+	//Returns how many bytes were uploaded to the key textures in the last update.
+	std::size_t getKeyUploadBytes() const;
+private:
+	//A ship's key texture, and the damage it last had uploaded.
+	struct KeyTexture
+	{
+		sf::Texture texture; //The key texture fed to the damage shader.
+		DamageMask uploaded; //The damage mask currently held by the texture.
+	};
+
+	const sf::Texture *m_hullTexture; //Texture of the ship hull.
+	const sf::Texture *m_turretAtlasTexture; //Texture atlas for the turrets.
+	sf::Shader *m_damageShader; //Shader that uses the damage key to differentiate between which pixels should be visible.
+
+	const std::vector<ShipSnapshot> *m_ships = nullptr; //The ships being drawn.
+	std::vector<std::unique_ptr<KeyTexture>> m_keyTextures; //Key texture of each ship being drawn; by position in the snapshot list.
+	std::vector<sf::Transform> m_shipTransforms; //Transform each ship is drawn with this frame; by position in the snapshot list.
+	sf::VertexArray m_turretVertices; //Quads of every turret; each ship's turrets are stored together, in the order of the ships.
+	std::vector<std::size_t> m_turretOffsets; //Index of each ship's first turret vertex; with an extra entry for the end.
+
+	std::vector<sf::Uint8> m_keyPixels; //Buffer the damage masks are expanded into for uploading.
+	std::size_t m_keyUploadBytes = 0; //Bytes uploaded to the key textures in the last update.
+
+	//Uploads the area of the ship's damage that changed to its key texture.
+	//	keyTexture : The ship's key texture.
+	//	damage : The ship's current damage mask.
+	void uploadDamage(KeyTexture &keyTexture, const DamageMask &damage);
+};
+
+//Returns how many bytes were uploaded to the key textures in the last update.
+inline std::size_t ShipRenderer::getKeyUploadBytes() const
+{
+	return m_keyUploadBytes;
+}
@@ -0,0 +1,50 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * The queue of shots fired by a battle's turrets during a tick; owned by the battle, and handed to each turret it builds.
+ * Pushing is lock-free, so turrets on any number of workers may fire at once; each push only claims the next slot with an atomic add.
+ * The battle drains every shot at once at the start of the next tick, while nothing is firing.
+ *
+ * Workers fire in whatever order they happen to run, so each shot carries the order of the turret that fired it;
+ * draining sorts by it, so the shots come out in the order the turrets are updated in a serial tick, however the tick was split.
+ */
+#pragma once
+
+#include <atomic> //For claiming slots.
+#include <cstdint> //For the fire order.
+#include <vector> //For the slots, and the drained shots.
+
+#include <SFML/System.hpp> //For the overflow mutex.
+
+#include "Projectile.hpp" //For the shots.
+
+//Lock-free multi-producer queue of the shots fired during a tick; drained in bulk by the battle.
+class ShotQueue
+{
+public:
+	//Basic ShotQueue constructor.
+	//	capacity : How many shots a tick may fire before the queue falls back to a locked overflow list; grown to fit on each drain.
+	ShotQueue(std::size_t capacity = 1024);
+
+	//Queues a shot; may be called from any number of threads at once, but not while the queue is being drained.
+	//	shot : The shot fired.
+	//	fireOrder : Order of the turret that fired it; unique per turret, and the order the turrets are updated in a serial tick.
+	void push(const ShotInfo &shot, std::uint64_t fireOrder);
+
+	//Moves every queued shot to the list, in fire order, and empties the queue; only call while nothing is pushing.
+	//	shots : Filled with the shots; cleared first.
+	void drain(std::vector<ShotInfo> &shots);
+private:
+	//A queued shot, and the order of the turret that fired it.
+	struct Entry
+	{
+		ShotInfo shot; //The shot fired.
+		std::uint64_t fireOrder; //Order of the turret that fired it.
+	};
+
+	std::vector<Entry> m_entries; //The slots shots are written to; claimed in turn by m_size.
+	std::atomic<std::size_t> m_size{0}; //How many slots have been claimed this tick; may pass the capacity, for shots in the overflow.
+
+	std::vector<Entry> m_overflow; //Shots fired after every slot was claimed; rare, as the slots grow to fit the busiest tick.
+	sf::Mutex m_overflowMutex; //Controls access to the overflow.
+};
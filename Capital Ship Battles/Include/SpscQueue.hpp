@@ -0,0 +1,104 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * A lock-free, bounded queue for handing values from one producing thread to one consuming thread.
+ * The values live in a ring of slots sized when the queue is built, so pushing and popping never allocate, or wait on the other side.
+ * Each side keeps its own copy of the other side's position, and only reloads it when the ring looks full or empty;
+ * so the two threads rarely touch the same cache line.
+ */
+#pragma once
+
+#include <atomic> //For the positions shared between the threads.
+#include <utility> //For std::move.
+#include <vector> //For the ring of slots.
+
+//Bounded queue handing values from a single producer to a single consumer, without either side blocking.
+template<typename T>
+class SpscQueue
+{
+public:
+	//Basic SpscQueue constructor.
+	//	capacity : How many values the queue can hold at once; rounded up to a power of two.
+	SpscQueue(std::size_t capacity = 256);
+
+	//Pushes a value onto the back of the queue; only call from the producing thread.
+	//	value : The value to push; left unchanged if the queue is full.
+	//Returns whether there was room for the value.
+	bool tryPush(T &&value);
+	//Pops the value at the front of the queue; only call from the consuming thread.
+	//	value : Set to the value popped.
+	//Returns whether there was a value to pop.
+	bool tryPop(T &value);
+private:
+	std::vector<T> m_slots; //The ring the values are held in.
+	std::size_t m_mask; //Wraps a position to its slot; one less than the number of slots.
+
+	alignas(64) std::atomic<std::size_t> m_head{0}; //Position of the next value to pop; only written by the consumer.
+	std::size_t m_cachedTail = 0; //The consumer's copy of m_tail; reloaded when the queue looks empty.
+
+	alignas(64) std::atomic<std::size_t> m_tail{0}; //Position the next value is pushed to; only written by the producer.
+	std::size_t m_cachedHead = 0; //The producer's copy of m_head; reloaded when the queue looks full.
+};
+
+//Basic SpscQueue constructor.
+//	capacity : How many values the queue can hold at once; rounded up to a power of two.
+template<typename T>
+inline SpscQueue<T>::SpscQueue(std::size_t capacity)
+{
+	//Number of slots in the ring; a power of two, so a position wraps with a mask.
+	std::size_t slotCount = 1;
+
+	while(slotCount < capacity)
+	{
+		slotCount *= 2;
+	}
+
+	m_slots.resize(slotCount);
+	m_mask = slotCount - 1;
+}
+
+//Pushes a value onto the back of the queue; only call from the producing thread.
+//	value : The value to push; left unchanged if the queue is full.
+//Returns whether there was room for the value.
+template<typename T>
+inline bool SpscQueue<T>::tryPush(T &&value)
+{
+	const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+
+	//The ring looks full from the last head we saw; see whether the consumer has popped since.
+	if(tail - m_cachedHead == m_slots.size())
+	{
+		m_cachedHead = m_head.load(std::memory_order_acquire);
+
+		if(tail - m_cachedHead == m_slots.size()) return false;
+	}
+
+	m_slots[tail & m_mask] = std::move(value);
+	//Release the slot to the consumer only once the value is written.
+	m_tail.store(tail + 1, std::memory_order_release);
+
+	return true;
+}
+
+//Pops the value at the front of the queue; only call from the consuming thread.
+//	value : Set to the value popped.
+//Returns whether there was a value to pop.
+template<typename T>
+inline bool SpscQueue<T>::tryPop(T &value)
+{
+	const std::size_t head = m_head.load(std::memory_order_relaxed);
+
+	//The ring looks empty from the last tail we saw; see whether the producer has pushed since.
+	if(head == m_cachedTail)
+	{
+		m_cachedTail = m_tail.load(std::memory_order_acquire);
+
+		if(head == m_cachedTail) return false;
+	}
+
+	value = std::move(m_slots[head & m_mask]);
+	//Hand the slot back to the producer only once the value has been moved out.
+	m_head.store(head + 1, std::memory_order_release);
+
+	return true;
+}
@@ -0,0 +1,71 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * A cheap running hash of the state of a battle; used to tell whether two networked battles have diverged.
+ * Values are mixed in a word at a time, rather than a byte at a time, so hashing every tick costs little next to the tick itself.
+ * Floats are mixed by their bits, so two battles only hash the same if they are bit-identical; which lockstep requires.
+ * Not a cryptographic hash; it only has to make an accidental match between diverged battles unlikely.
+ */
+#pragma once
+
+#include <cstdint> //For the words hashed.
+#include <cstring> //For reading the bits of floats.
+
+//Running hash of the values mixed into it, in order.
+class StateHash
+{
+public:
+	//Mixes a word into the hash.
+	//	value : The word to mix in.
+	void mix(std::uint64_t value);
+	//Mixes the bits of a float into the hash.
+	//	value : The float to mix in.
+	void mixFloat(float value);
+
+	//Returns the hash of every value mixed in so far.
+	std::uint64_t getValue() const;
+
+	//Scrambles a word, so words that differ by a bit give unrelated results; for combining hashes where order does not matter.
+	//	value : The word to scramble.
+	//Returns the scrambled word.
+	static std::uint64_t scramble(std::uint64_t value);
+private:
+	std::uint64_t m_value = 14695981039346656037ull; //The hash so far; starts at the FNV offset basis.
+};
+
+//Mixes a word into the hash.
+//	value : The word to mix in.
+inline void StateHash::mix(std::uint64_t value)
+{
+	//Multiply by the FNV prime, then fold the high bits down; so every bit of the word reaches every bit of the hash.
+	m_value = (m_value ^ value) * 1099511628211ull;
+	m_value ^= m_value >> 29;
+}
+
+//Mixes the bits of a float into the hash.
+//	value : The float to mix in.
+inline void StateHash::mixFloat(float value)
+{
+	std::uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	mix(bits);
+}
+
+//Returns the hash of every value mixed in so far.
+inline std::uint64_t StateHash::getValue() const
+{
+	return m_value;
+}
+
+//Scrambles a word, so words that differ by a bit give unrelated results; for combining hashes where order does not matter.
+//	value : The word to scramble.
+//Returns the scrambled word.
+inline std::uint64_t StateHash::scramble(std::uint64_t value)
+{
+	//The finaliser of SplitMix64.
+	value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+	value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+
+	return value ^ (value >> 31);
+}
@@ -0,0 +1,74 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Connects to the peer over a TCP socket; the default transport.
+ * The handshake, and each flush of frames, is sent as a packet of its own; TCP delivers them in order,
+ * though one lost segment holds back everything after it until it is retransmitted.
+ */
+#pragma once
+
+#include <deque> //For the packets received.
+
+#include "Transport.hpp" //Base class.
+
+//TCP socket that may turn Nagle's algorithm back on; SFML turns it off for every TCP socket, and does not expose the socket's handle.
+class NetworkSocket : public sf::TcpSocket
+{
+public:
+	//Sets whether the operating system may hold back small sends to merge them; only call while connected.
+	//	isNagleEnabled : Whether Nagle's algorithm is enabled.
+	void setNagleEnabled(bool isNagleEnabled);
+};
+
+//Connects to the peer over a TCP socket.
+class TcpTransport : public Transport
+{
+public:
+	//Waits for a peer to connect; stopped by disconnect, from another thread.
+	//	port : The port to wait on.
+	//Returns whether a peer connected.
+	virtual bool host(unsigned short port);
+	//Connects to a peer waiting on the address; with a five second time-out.
+	//	address : The address of the peer.
+	//	port : The port the peer is waiting on.
+	//Returns whether the peer was reached.
+	virtual bool join(const sf::IpAddress &address, unsigned short port);
+	//Closes the connection, or stops connecting; safe to call from any thread.
+	virtual void disconnect();
+	//Returns whether the peer is still connected.
+	virtual bool isConnected() const;
+
+	//Queues the handshake, to be sent on the next flush.
+	//	handshake : The bytes of the handshake.
+	virtual void sendHandshake(std::vector<std::uint8_t> handshake);
+	//Queues a flush of frames, to be sent on the next flush.
+	//	frames : The bytes of the frames.
+	virtual void sendFrames(std::vector<std::uint8_t> frames);
+	//Sends everything queued; only call from the network thread.
+	virtual void flush();
+
+	//Waits, at most the timeout, for a packet to arrive from the peer; only call from the network thread.
+	//	timeout : The longest to wait.
+	//Returns whether the peer is still connected.
+	virtual bool wait(const sf::Time &timeout);
+	//Takes the next packet from the peer; the handshake, then each flush of frames. Only call from the network thread.
+	//	message : Set to the bytes of the packet.
+	//Returns whether there was a packet.
+	virtual bool receive(std::vector<std::uint8_t> &message);
+
+	//Sets whether the operating system may hold back small sends to merge them; off by default, as frames are already batched.
+	//Applied to the next connection.
+	//	isNagleEnabled : Whether Nagle's algorithm is enabled.
+	void setNagleEnabled(bool isNagleEnabled);
+private:
+	NetworkSocket m_socket; //Socket that manages the connection to the peer.
+	sf::TcpListener m_listener; //Listener for gaining new clients.
+	sf::SocketSelector m_selector; //Wakes the network thread when a packet arrives.
+	bool m_isNagleEnabled = false; //Whether the operating system may hold back small sends to merge them.
+
+	std::vector<std::vector<std::uint8_t>> m_outgoing; //Packets queued to be sent on the next flush; in order.
+	std::deque<std::vector<std::uint8_t>> m_incoming; //Packets received, and not yet taken; in order.
+
+	//Sets up the socket once it has connected.
+	void onConnected();
+};
@@ -0,0 +1,55 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * How the network manager reaches its peer; the connection, and the delivery of what is sent over it.
+ * Whatever is underneath, the handshake arrives first, then each flush of frames; each whole, once, and in order.
+ *	TcpTransport : Over a TCP socket.
+ *	UdpTransport : Over a UDP socket, with the reliability layer of UdpChannel.
+ *	LoopbackTransport : Over an in-process pair, with the same reliability layer, and impairment of what is sent; for testing.
+ */
+#pragma once
+
+#include <cstdint> //For the bytes sent.
+#include <vector> //For the bytes sent.
+
+#include <SFML/Network.hpp> //For addresses.
+
+//The connection to a peer; see the top of this file.
+class Transport
+{
+public:
+	//Transport destructor.
+	virtual ~Transport() = default;
+
+	//Waits for a peer to connect; stopped by disconnect, from another thread.
+	//	port : The port to wait on.
+	//Returns whether a peer connected.
+	virtual bool host(unsigned short port) = 0;
+	//Connects to a peer waiting on the address.
+	//	address : The address of the peer.
+	//	port : The port the peer is waiting on.
+	//Returns whether the peer was reached.
+	virtual bool join(const sf::IpAddress &address, unsigned short port) = 0;
+	//Closes the connection, or stops connecting; safe to call from any thread.
+	virtual void disconnect() = 0;
+	//Returns whether the peer is still connected.
+	virtual bool isConnected() const = 0;
+
+	//Queues the handshake, to be sent on the next flush.
+	//	handshake : The bytes of the handshake.
+	virtual void sendHandshake(std::vector<std::uint8_t> handshake) = 0;
+	//Queues a flush of frames, to be sent on the next flush.
+	//	frames : The bytes of the frames.
+	virtual void sendFrames(std::vector<std::uint8_t> frames) = 0;
+	//Sends everything queued, and anything else due; only call from the network thread.
+	virtual void flush() = 0;
+
+	//Waits, at most the timeout, for something to arrive from the peer; only call from the network thread.
+	//	timeout : The longest to wait.
+	//Returns whether the peer is still connected.
+	virtual bool wait(const sf::Time &timeout) = 0;
+	//Takes the next message from the peer; the handshake, then each flush of frames. Only call from the network thread.
+	//	message : Set to the bytes of the message.
+	//Returns whether there was a message.
+	virtual bool receive(std::vector<std::uint8_t> &message) = 0;
+};
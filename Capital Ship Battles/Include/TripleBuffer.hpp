@@ -0,0 +1,62 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * A lock-free triple buffer for handing values from one writing thread to one reading thread.
+ * The writer fills its buffer and publishes it; the reader takes the most recently published buffer.
+ * Neither side ever waits on the other; the reader simply keeps its current buffer until a newer one is published,
+ * and buffers the reader never saw are overwritten by the writer.
+ */
+#pragma once
+
+#include <atomic> //For exchanging buffers between the threads.
+
+//Triple buffer handing values from a single writer to a single reader, without either side blocking.
+template<typename T>
+class TripleBuffer
+{
+public:
+	//Returns the buffer the writer fills; only call from the writing thread.
+	T& getWriteBuffer();
+	//Publishes the write buffer to the reader, and gives the writer a buffer the reader is not using; only call from the writing thread.
+	void publish();
+
+	//Returns the most recently published buffer; only call from the reading thread.
+	//The buffer stays valid, and unchanged, until the next call.
+	const T& getReadBuffer();
+private:
+	static constexpr unsigned int INDEX_MASK = 3; //Bits of the middle slot that hold the index of the buffer.
+	static constexpr unsigned int FRESH_BIT = 4; //Bit of the middle slot set when the buffer has been published, but not read.
+
+	T m_buffers[3]; //The three buffers; at any time, one is being written, one is being read, and one is waiting in the middle.
+	unsigned int m_writeIndex = 0; //Index of the buffer being written.
+	unsigned int m_readIndex = 1; //Index of the buffer being read.
+	std::atomic<unsigned int> m_middle{2}; //Index of the buffer waiting to be read, and whether it is fresh; swapped by both threads.
+};
+
+//Returns the buffer the writer fills; only call from the writing thread.
+template<typename T>
+inline T& TripleBuffer<T>::getWriteBuffer()
+{
+	return m_buffers[m_writeIndex];
+}
+
+//Publishes the write buffer to the reader, and gives the writer a buffer the reader is not using; only call from the writing thread.
+template<typename T>
+inline void TripleBuffer<T>::publish()
+{
+	m_writeIndex = m_middle.exchange(m_writeIndex | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+//Returns the most recently published buffer; only call from the reading thread.
+//The buffer stays valid, and unchanged, until the next call.
+template<typename T>
+inline const T& TripleBuffer<T>::getReadBuffer()
+{
+	//Only swap if something new was published; otherwise, the reader would take back a stale buffer.
+	if(m_middle.load(std::memory_order_acquire) & FRESH_BIT)
+	{
+		m_readIndex = m_middle.exchange(m_readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	return m_buffers[m_readIndex];
+}
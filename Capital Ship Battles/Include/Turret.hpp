@@ -2,12 +2,18 @@
  * Author: George Mostyn-Parry
  *
  * A turret that fires projectiles at a target.
- * The turret will turn to face the target before queueing the shot onto a fire list,
+ * The turret will turn to face the target before queueing the shot onto its battle's shot queue,
  * which should be used to create the projectiles in a way that it appears as though the turret fired the projectile.
  */
 #pragma once
 
+#include <cstdint> //For the fire order.
+#include <iosfwd> //For dumping the turret's state.
+
 #include "Projectile.hpp" //The projectile the turret will shoot.
+#include "StateHash.hpp" //For hashing the turret's state.
+
+class ShotQueue;
 
  //The information local to the turret to allows it to be constructed.
 //Lightweight memory usage compared to storing compies of the turret class.
@@ -21,20 +27,31 @@ struct TurretInfo
 class Turret : public sf::RectangleShape
 {
 public:
-	static std::vector<ShotInfo> *s_fireList; //The list of shots that are to be used to create projectiles.
-
 	//Construct a complete turret from the passed information.
 	//	info : Information defining how the turret should be constructed.
 	//	parentTransform : Transform of the turret's parent; used for transforming the turret to global co-ordinates.
+	//	parentInverseTransform : Inverse of the parent's transform; used for transforming the target to local co-ordinates.
 	//	atlasTexture : Texture that holds all the different sprites the turret can use.
-	Turret(TurretInfo info, const sf::Transform *parentTransform, const sf::Texture *atlasTexture);
+	//	shotQueue : Queue the turret's shots are pushed onto; nullptr for a turret that never fires, such as one being built.
+	//	fireOrder : Where the turret's shots are placed in the queue, relative to the other turrets; unique to each turret in the battle.
+	Turret(TurretInfo info, const sf::Transform *parentTransform, const sf::Transform *parentInverseTransform, const sf::Texture *atlasTexture,
+		ShotQueue *shotQueue = nullptr, std::uint64_t fireOrder = 0);
 
 	//Updates the turret's state since the last update.
 	//	deltaTime : The amount of time that has passed since the turret was last updated.
 	void update(sf::Time deltaTime);
 
+	//Mixes the turret's state into the hash; its type, rotation, target, and reload.
+	//	hash : The hash to mix into.
+	void hashState(StateHash &hash) const;
+	//Writes the turret's state as text, with exact floats, on one line; as part of its ship's dump.
+	//	stream : The stream to write to.
+	void dumpState(std::ostream &stream) const;
+
 	//Returns information on how to construct this turret with the TurretInfo struct.
 	TurretInfo getTurretInfo() const;
+	//Returns the turret's rotation before its last update.
+	float getPreviousRotation() const;
 
 	//Orders the turret to fire at the specified target.
 	//	target : Where the turret should fire at.
@@ -42,17 +59,23 @@ public:
 	void fireCommand(const sf::Vector2f &target, unsigned int layer);
 private:
 	const sf::Transform *m_parentTransform; //The transform that the turret is parented to.
+	const sf::Transform *m_parentInverseTransform; //Inverse of the transform the turret is parented to; cached by the parent.
+
+	ShotQueue *m_shotQueue; //Queue the turret's shots are pushed onto.
+	std::uint64_t m_fireOrder; //Where the turret's shots are placed in the queue.
 
 	ProjectileType m_projType; //The type of projectile the turret fires.
 	
 	sf::Time m_reloadTime; //How long the turret must wait between shots.
 	sf::Time m_timeSinceLastShot; //How long since the turret last fired.
 
+	float m_previousRotation = 0; //The turret's rotation before its last update.
+
 	bool m_isTrackingTarget = false; //Whether the turret is tracking the target position to fire at it.
 	sf::Vector2f m_targetPosition; //Where the turret is firing at.
 	unsigned int m_targetlayer; //What layer the turret should fire on to.
 
-	//Pushes information on a projectile to be created onto the firing list.
+	//Pushes information on a projectile to be created onto the shot queue.
 	void fire();
 };
 
@@ -60,4 +83,10 @@ private:
 inline TurretInfo Turret::getTurretInfo() const
 {
 	return {m_projType, getPosition()};
-}
\ No newline at end of file
+}
+
+//Returns the turret's rotation before its last update.
+inline float Turret::getPreviousRotation() const
+{
+	return m_previousRotation;
+}
@@ -0,0 +1,211 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * A selective reliability layer, for networking battles over UDP; so a lost datagram does not hold back everything sent after it,
+ * as a lost segment does over TCP until it is retransmitted.
+ * Carries two streams of messages between the peers; each delivered whole, once, and in order, however datagrams are lost,
+ * duplicated, or reordered on the way. Every datagram carries a sequence number, the latest sequence number received from the peer,
+ * for measuring the round trip, and how many messages of each stream have been received, which acknowledges them.
+ *	Reliable : Each message is sent once, and only resent if it is not acknowledged within the resend timeout; for the handshake.
+ *	Redundant : Every message not yet acknowledged is resent in every datagram; for frames of input, so a lost datagram only delays
+ *		them until the next datagram, rather than a whole resend timeout. Frames are only a few bytes, so this costs little next to
+ *		the headers of the datagram itself.
+ * A datagram is only written when something is due; a new message, a resend, an acknowledgement the peer is owed, or a heartbeat.
+ * Acknowledgements wait a little for a datagram to ride on, rather than each being sent on its own.
+ *
+ * The channel never touches a socket, and is given the time by its caller; so it may be tested with any link in between.
+ * ImpairedLink is such a link; it drops, and delays, datagrams by a model, so the layer may be tested on loopback.
+ */
+#pragma once
+
+#include <cstdint> //For sequence numbers.
+#include <deque> //For the messages waiting on the peer.
+#include <map> //For messages received ahead of those before them.
+#include <random> //For the impairment model.
+#include <vector> //For the bytes of messages, and datagrams.
+
+#include <SFML/System.hpp> //For the time.
+
+#include "WireFormat.hpp" //For encoding, and decoding, the datagrams.
+
+//Carries two streams of messages between peers over datagrams; see the top of this file.
+class UdpChannel
+{
+public:
+	static constexpr std::size_t MAX_DATAGRAM_SIZE = 1200; //Datagrams are kept under this, so they are never fragmented; unless a single message is bigger.
+
+	//Queues a message on the reliable stream; sent once, then resent if it is not acknowledged within the resend timeout.
+	//	message : The bytes of the message.
+	void sendReliable(std::vector<std::uint8_t> message);
+	//Queues a message on the redundant stream; sent in every datagram until it is acknowledged.
+	//	message : The bytes of the message.
+	void sendRedundant(std::vector<std::uint8_t> message);
+
+	//Writes the next datagram to send to the peer, if anything is due.
+	//	now : The current time.
+	//	datagram : Set to the bytes of the datagram.
+	//	isForced : Whether to write a datagram even if nothing is due; i.e. to greet the peer.
+	//Returns whether a datagram was written.
+	bool writeDatagram(const sf::Time &now, std::vector<std::uint8_t> &datagram, bool isForced = false);
+	//Reads a datagram received from the peer; delivering any messages it completes, and acknowledging any of ours it acknowledges.
+	//	data : The bytes of the datagram.
+	//	size : How many bytes there are.
+	//	now : The current time.
+	//Returns whether the datagram was well-formed; a malformed datagram is ignored whole.
+	bool readDatagram(const void *data, std::size_t size, const sf::Time &now);
+
+	//Takes the next message delivered on the reliable stream.
+	//	message : Set to the bytes of the message.
+	//Returns whether there was a message.
+	bool takeReliable(std::vector<std::uint8_t> &message);
+	//Takes the next message delivered on the redundant stream.
+	//	message : Set to the bytes of the message.
+	//Returns whether there was a message.
+	bool takeRedundant(std::vector<std::uint8_t> &message);
+
+	//Returns whether the peer has acknowledged every message sent.
+	bool isAcknowledged() const;
+	//Returns the smoothed round trip to the peer; zero before it has been measured.
+	sf::Time getRoundTrip() const;
+	//Returns how long a message on the reliable stream waits to be acknowledged before it is resent.
+	sf::Time getResendTimeout() const;
+
+	//Forgets every message, and everything known about the peer; for a new connection.
+	void reset();
+private:
+	static constexpr std::size_t SEND_HISTORY = 64; //How many of the latest datagrams' send times are kept, for measuring the round trip.
+	static constexpr std::uint64_t MAX_EARLY_MESSAGES = 1024; //How far ahead of those before it a message may arrive, and still be kept.
+
+	//A message sent to the peer, waiting for them to acknowledge it.
+	struct OutgoingMessage
+	{
+		std::uint64_t number; //The message's place in its stream.
+		std::vector<std::uint8_t> bytes; //The bytes of the message.
+		bool isSent = false; //Whether the message has been sent at least once.
+		sf::Time lastSent = sf::Time::Zero; //When the message was last sent.
+	};
+
+	//Both ends of one of the streams.
+	struct Stream
+	{
+		std::deque<OutgoingMessage> unacknowledged; //Messages sent to the peer they have not acknowledged; oldest first.
+		std::uint64_t nextNumber = 0; //The number of the next message queued.
+
+		std::uint64_t received = 0; //How many messages from the peer have been delivered; also the number of the next to deliver.
+		std::map<std::uint64_t, std::vector<std::uint8_t>> early; //Messages received ahead of one before them.
+		std::deque<std::vector<std::uint8_t>> delivered; //Messages delivered, and not yet taken.
+	};
+
+	//When a datagram was sent.
+	struct SendTime
+	{
+		std::uint64_t sequence = UINT64_MAX; //The datagram's sequence number.
+		sf::Time time; //When it was sent.
+	};
+
+	Stream m_reliable; //The reliable stream; for the handshake.
+	Stream m_redundant; //The redundant stream; for frames of input.
+
+	std::uint64_t m_nextSequence = 0; //The sequence number of the next datagram written.
+	std::uint64_t m_latestReceived = 0; //The latest sequence number received from the peer, plus one; zero before any.
+	std::uint64_t m_latestEchoed = 0; //The latest of our sequence numbers the peer has echoed back, plus one; zero before any.
+	SendTime m_sendTimes[SEND_HISTORY]; //When the latest datagrams were sent; indexed by sequence number.
+	bool m_isAckOwed = false; //Whether the peer has sent messages since our last datagram that need acknowledging.
+	sf::Time m_ackOwedSince; //When the first message needing acknowledging arrived.
+	sf::Time m_lastSent; //When the last datagram was written.
+
+	sf::Time m_smoothedRoundTrip; //The round trip, averaged over the latest measurements.
+	sf::Time m_roundTripVariation; //How much the round trip varies, averaged over the latest measurements.
+
+	//Returns whether any message in the stream is due to be sent; either new, or unacknowledged past the resend timeout.
+	//	stream : The stream to check.
+	//	now : The current time.
+	bool isStreamDue(const Stream &stream, const sf::Time &now) const;
+	//Writes the messages of the stream that are due into the datagram; every unacknowledged message, on the redundant stream.
+	//	writer : The datagram being written.
+	//	stream : The stream to write.
+	//	now : The current time.
+	//	isRedundant : Whether the stream is the redundant stream.
+	void writeStream(WireWriter &writer, Stream &stream, const sf::Time &now, bool isRedundant);
+	//Removes the messages the peer has acknowledged from the stream.
+	//	stream : The stream acknowledged.
+	//	received : How many messages of the stream the peer has received.
+	static void acknowledge(Stream &stream, std::uint64_t received);
+	//Delivers a message received on the stream; or keeps it until those before it arrive. Duplicates are dropped.
+	//	stream : The stream the message was received on.
+	//	number : The message's place in the stream.
+	//	bytes : The bytes of the message.
+	//Returns whether the message was new; i.e. not a duplicate, nor too far ahead to keep.
+	static bool deliver(Stream &stream, std::uint64_t number, std::vector<std::uint8_t> &&bytes);
+	//Adds a measurement of the round trip to the smoothed round trip.
+	//	roundTrip : The round trip measured.
+	void measureRoundTrip(const sf::Time &roundTrip);
+};
+
+//How badly a link drops, and delays, datagrams.
+struct LinkImpairment
+{
+	float lossRate = 0; //The chance of each datagram being dropped; between 0 and 1.
+	sf::Time latency; //How long every datagram is held back.
+	sf::Time jitter; //The most extra time, picked at random, each datagram is held back; so datagrams may arrive out of order.
+	float reorderRate = 0; //The chance of each datagram being held back a further latency, so those sent after it overtake it; between 0 and 1.
+	unsigned int bandwidth = 0; //How many bytes a second the link carries; datagrams queue behind those before them beyond it. Zero is unlimited.
+};
+
+//Holds datagrams being sent back, and drops some, by an impairment model; so the channel may be tested on loopback.
+//Without impairment, every datagram is due as soon as it is sent.
+class ImpairedLink
+{
+public:
+	//Basic ImpairedLink constructor.
+	//	seed : Seed of the random choices; the same seed gives the same losses, and delays.
+	explicit ImpairedLink(unsigned int seed = 0);
+
+	//Sets how badly the link drops, and delays, datagrams; applied to datagrams sent from now on.
+	//	impairment : The model to impair datagrams by.
+	void setImpairment(const LinkImpairment &impairment);
+
+	//Sends a datagram over the link; it is dropped, or held back until due, by the model.
+	//	datagram : The bytes of the datagram.
+	//	now : The current time.
+	void send(std::vector<std::uint8_t> datagram, const sf::Time &now);
+	//Takes the datagram due soonest, if it is due.
+	//	now : The current time.
+	//	datagram : Set to the bytes of the datagram.
+	//Returns whether a datagram was due.
+	bool takeDue(const sf::Time &now, std::vector<std::uint8_t> &datagram);
+	//Finds when the datagram due soonest is let through.
+	//	due : Set to when the datagram is due.
+	//Returns whether any datagram is being held back.
+	bool getNextDue(sf::Time &due) const;
+
+	//Drops every datagram being held back.
+	void clear();
+private:
+	//A datagram being held back.
+	struct HeldDatagram
+	{
+		sf::Time due; //When the datagram is let through.
+		std::vector<std::uint8_t> bytes; //The bytes of the datagram.
+	};
+
+	LinkImpairment m_impairment; //How badly the link drops, and delays, datagrams.
+	std::mt19937 m_random; //Decides which datagrams are dropped, and how long each is held back.
+	std::vector<HeldDatagram> m_held; //The datagrams being held back; in the order they were sent.
+	sf::Time m_linkFreeAt; //When the link has finished carrying every datagram sent; for the bandwidth.
+
+	//Returns the datagram held back due soonest; the first sent, of those due at the same time.
+	std::vector<HeldDatagram>::const_iterator findSoonest() const;
+};
+
+//Returns whether the peer has acknowledged every message sent.
+inline bool UdpChannel::isAcknowledged() const
+{
+	return m_reliable.unacknowledged.empty() && m_redundant.unacknowledged.empty();
+}
+
+//Returns the smoothed round trip to the peer; zero before it has been measured.
+inline sf::Time UdpChannel::getRoundTrip() const
+{
+	return m_smoothedRoundTrip;
+}
@@ -0,0 +1,63 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Connects to the peer over a UDP socket, with the reliability layer of ChannelTransport.
+ * UDP has no connections; the host takes whoever sends it the first well-formed datagram as the peer,
+ * and the joining player greets the host until it answers. Loss, and latency, may be injected into what is sent, for testing on loopback.
+ */
+#pragma once
+
+#include "ChannelTransport.hpp" //Base class.
+
+//Connects to the peer over a UDP socket.
+class UdpTransport : public ChannelTransport
+{
+public:
+	//Waits for a player to send a datagram; stopped by disconnect, from another thread.
+	//	port : The port to wait on.
+	//Returns whether a player joined.
+	virtual bool host(unsigned short port);
+	//Greets the host until it answers; for at most five seconds.
+	//	address : The address of the host.
+	//	port : The port the host is waiting on.
+	//Returns whether the host answered.
+	virtual bool join(const sf::IpAddress &address, unsigned short port);
+
+	//Sends a datagram, if the reliability layer has anything due, and lets through whatever the link has due; only call from the network thread.
+	virtual void flush();
+	//Waits, at most the timeout, for datagrams from the peer, and reads every one that arrived; only call from the network thread.
+	//Closes the socket once the peer has gone.
+	//	timeout : The longest to wait.
+	//Returns whether the peer is still connected.
+	virtual bool wait(const sf::Time &timeout);
+
+	//Sets how badly what is sent is dropped, and delayed, before it reaches the socket; for testing. Only call while not connected.
+	//	impairment : The model to impair datagrams by.
+	void setImpairment(const LinkImpairment &impairment);
+protected:
+	//Sends a datagram to the peer, through the link.
+	//	datagram : The bytes of the datagram.
+	virtual void sendDatagram(std::vector<std::uint8_t> datagram);
+	//Waits, at most the timeout, for a datagram to arrive on the socket.
+	//	timeout : The longest to wait.
+	//Returns whether a datagram arrived.
+	virtual bool waitForDatagram(const sf::Time &timeout);
+	//Takes the next datagram from the peer, without waiting; ignoring any not from the peer.
+	//	datagram : Set to the bytes of the datagram.
+	//Returns whether there was a datagram.
+	virtual bool receiveDatagram(std::vector<std::uint8_t> &datagram);
+private:
+	sf::UdpSocket m_socket; //Socket that carries the datagrams.
+	sf::SocketSelector m_selector; //Wakes the network thread when a datagram arrives.
+	sf::IpAddress m_peerAddress; //Address of the peer.
+	unsigned short m_peerPort = 0; //Port of the peer.
+	ImpairedLink m_link; //Drops, and delays, what is sent; lets everything through, unless impaired for testing.
+	std::vector<std::uint8_t> m_buffer = std::vector<std::uint8_t>(sf::UdpSocket::MaxDatagramSize); //Receives each datagram.
+
+	//Binds the socket, and starts a new connection.
+	//	port : The port to bind to.
+	//Returns whether the socket was bound.
+	bool bind(unsigned short port);
+	//Lets through whatever the link has due to the peer.
+	void sendHeld();
+};
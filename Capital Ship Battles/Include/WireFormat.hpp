@@ -0,0 +1,158 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * The format packets are sent between peers in; the same bytes on every platform, whatever the width of its types.
+ * Every value has an explicit width and byte order: counts, ticks, and IDs are varints, so small values take one byte;
+ * positions on the battlefield are quantised to a sixteenth of a unit in 16 bits, turret positions on the hull to a quarter of a pixel,
+ * and angles to 65536 steps of a turn.
+ * A peer that connects sends Wire::VERSION first; peers of different versions refuse each other, rather than misreading each other.
+ * After that, messages are sent in frames; one per tick, stamped with the tick, so the messages in it need not carry a tick each.
+ *
+ * Quantising loses precision, so the sender must use the quantised values itself too; otherwise the two battles would not be the same.
+ */
+#pragma once
+
+#include <cstdint> //For fixed width values.
+#include <vector> //For the encoded bytes.
+
+#include "BattleCommand.hpp" //For the commands encoded.
+
+//Constants and functions for the format packets are sent between peers in.
+namespace Wire
+{
+	constexpr std::uint32_t VERSION = 2; //Version of the format; bumped whenever a packet changes.
+	constexpr float FIELD_POSITION_SCALE = 16; //Steps per unit of positions on the battlefield; sent as 16 bits, so up to 4096 units.
+	constexpr float HULL_POSITION_SCALE = 4; //Steps per pixel of turret positions on the hull.
+	constexpr float ANGLE_STEPS = 65536; //Steps an angle is quantised to over a whole turn; sent as 16 bits.
+
+	//Rounds a position on the battlefield to the nearest value the format can carry; clamped to the area it can carry.
+	//	position : The position to quantise.
+	//Returns the position the peer will receive.
+	sf::Vector2f quantiseFieldPosition(const sf::Vector2f &position);
+	//Rounds a turret's position on the hull to the nearest value the format can carry.
+	//	position : The position to quantise.
+	//Returns the position the peer will receive.
+	sf::Vector2f quantiseHullPosition(const sf::Vector2f &position);
+	//Rounds an angle to the nearest value the format can carry; wrapped to between 0 and 360.
+	//	angle : The angle to quantise, in degrees.
+	//Returns the angle the peer will receive.
+	float quantiseAngle(float angle);
+	//Quantises every value in the command the format carries; so the sender carries out the same command the peer receives.
+	//	command : The command to quantise.
+	void quantiseCommand(BattleCommand &command);
+}
+
+//Encodes values into the bytes of a packet.
+class WireWriter
+{
+public:
+	//Writes a single byte.
+	//	value : The byte to write.
+	void writeByte(std::uint8_t value);
+	//Writes an unsigned integer as a varint; seven bits per byte, lowest first, with the top bit set on every byte but the last.
+	//	value : The integer to write.
+	void writeVarint(std::uint64_t value);
+	//Writes a signed integer as a varint; zig-zag encoded first, so small negative values are small too.
+	//	value : The integer to write.
+	void writeSignedVarint(std::int64_t value);
+	//Writes an unsigned 16 bit integer, lowest byte first.
+	//	value : The integer to write.
+	void writeUint16(std::uint16_t value);
+	//Writes an unsigned 64 bit integer, lowest byte first.
+	//	value : The integer to write.
+	void writeUint64(std::uint64_t value);
+	//Writes a run of bytes as they are, after their count as a varint.
+	//	bytes : The bytes to write.
+	void writeBytes(const std::vector<std::uint8_t> &bytes);
+
+	//Writes a position on the battlefield; see Wire::quantiseFieldPosition.
+	//	position : The position to write.
+	void writeFieldPosition(const sf::Vector2f &position);
+	//Writes a turret's position on the hull; see Wire::quantiseHullPosition.
+	//	position : The position to write.
+	void writeHullPosition(const sf::Vector2f &position);
+	//Writes an angle; see Wire::quantiseAngle.
+	//	angle : The angle to write, in degrees.
+	void writeAngle(float angle);
+
+	//Writes a command; the ship, and position, of a move, or fire, command, or the ship a create command builds.
+	//The command type, tick, and layers are not written; the message type, the frame it is in, and who sent it, imply them.
+	//	command : The command to write.
+	void writeCommand(const BattleCommand &command);
+
+	//Returns the bytes written so far.
+	const std::vector<std::uint8_t>& getBytes() const;
+	//Removes every byte written, so the writer may be reused.
+	void clear();
+private:
+	std::vector<std::uint8_t> m_bytes; //The bytes written so far.
+};
+
+//Decodes values from the bytes of a packet; reading past the end invalidates the reader, and gives zero, rather than reading out of bounds.
+class WireReader
+{
+public:
+	//Basic WireReader constructor.
+	//	data : The bytes to read; must outlive the reader.
+	//	size : How many bytes there are.
+	WireReader(const void *data, std::size_t size);
+
+	//Reads a single byte.
+	std::uint8_t readByte();
+	//Reads an unsigned varint; invalidates the reader if it is longer than 64 bits.
+	std::uint64_t readVarint();
+	//Reads a zig-zag encoded signed varint.
+	std::int64_t readSignedVarint();
+	//Reads an unsigned 16 bit integer, lowest byte first.
+	std::uint16_t readUint16();
+	//Reads an unsigned 64 bit integer, lowest byte first.
+	std::uint64_t readUint64();
+	//Reads a run of bytes written by writeBytes; invalidates the reader if the count runs past the end.
+	//	bytes : Set to the bytes read.
+	void readBytes(std::vector<std::uint8_t> &bytes);
+
+	//Reads a position on the battlefield.
+	sf::Vector2f readFieldPosition();
+	//Reads a turret's position on the hull.
+	sf::Vector2f readHullPosition();
+	//Reads an angle, in degrees.
+	float readAngle();
+
+	//Reads a command written by writeCommand.
+	//	command : Its type must be set, as it decides what is read; the values read are set on it.
+	void readCommand(BattleCommand &command);
+
+	//Returns whether every read so far was inside the bytes, and well-formed.
+	bool isValid() const;
+	//Returns whether every byte has been read.
+	bool isAtEnd() const;
+private:
+	const std::uint8_t *m_data; //The bytes being read.
+	std::size_t m_size; //How many bytes there are.
+	std::size_t m_readPosition = 0; //Index of the next byte to read.
+	bool m_isValid = true; //Whether every read so far was inside the bytes, and well-formed.
+};
+
+//Returns the bytes written so far.
+inline const std::vector<std::uint8_t>& WireWriter::getBytes() const
+{
+	return m_bytes;
+}
+
+//Removes every byte written, so the writer may be reused.
+inline void WireWriter::clear()
+{
+	m_bytes.clear();
+}
+
+//Returns whether every read so far was inside the bytes, and well-formed.
+inline bool WireReader::isValid() const
+{
+	return m_isValid;
+}
+
+//Returns whether every byte has been read.
+inline bool WireReader::isAtEnd() const
+{
+	return m_readPosition >= m_size;
+}
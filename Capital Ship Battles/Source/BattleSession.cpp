@@ -0,0 +1,238 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "BattleSession.hpp"
+
+#include <algorithm> //For std::stable_sort, and std::find_if.
+#include <fstream> //For dumping the battle on a desync.
+#include <iostream> //For reporting a desync.
+#include <string> //For naming the dump.
+
+#include "NetworkManager.hpp" //For networking the battle with the peer.
+#include "WireFormat.hpp" //For quantising commands as they are sent.
+
+//Basic BattleSession constructor.
+//	simulation : The simulation being run; must outlive the session.
+//	network : Networks the battle with the peer; null for a battle on one machine.
+BattleSession::BattleSession(BattleSimulation &simulation, NetworkManager *network)
+	:m_simulation(simulation), m_network(network),
+	m_isLockstep(network && network->isLockstep()),
+	m_inputDelay(m_isLockstep ? network->getInputDelay() : 0),
+	m_localLayer(network ? network->getLocalLayer() : 0)
+{}
+
+//Creates the local player's ship where the network manager starts it; only for a networked battle, before the network thread starts.
+//In lockstep, the ship is created at the first tick; otherwise, at once.
+//	turrets : The turrets the ship starts with.
+void BattleSession::createLocalShip(const std::vector<TurretInfo> &turrets)
+{
+	//The local player's ship; in the top-left if they are the host, otherwise in the bottom-right.
+	BattleCommand localShip;
+	localShip.type = CommandType::CREATE_SHIP;
+	localShip.shipLayer = m_localLayer;
+	localShip.position = m_network->getStartPosition();
+	localShip.angle = m_network->getStartAngle();
+	localShip.turrets = turrets;
+	//Build the ship as the peer will receive it; or the two battles would differ by the precision lost on the wire.
+	Wire::quantiseCommand(localShip);
+
+	//In lockstep, both ships are created at the first tick, in layer order; so both peers create them in the same order.
+	if(m_isLockstep)
+	{
+		m_localCommands.tryPush(std::move(localShip));
+	}
+	else
+	{
+		m_simulation.applyCommand(localShip);
+	}
+}
+
+//Runs the next tick, after applying the commands for it; unless, in lockstep, the peer has not marked it done yet.
+//	deltaTime : The amount of time the tick lasts.
+//Returns whether the tick was run.
+bool BattleSession::update(const sf::Time &deltaTime)
+{
+	//The tick being run.
+	const std::uint32_t tick = m_simulation.getTick();
+
+	//In lockstep, wait until the peer has sent every command for this tick; the commands are on the queue before the tick is marked.
+	if(m_isLockstep && m_remoteConfirmedTick.load(std::memory_order_acquire) < tick) return false;
+
+	if(m_isLockstep) checkStateHashes();
+
+	//Carry out the commands for this tick before it runs; the only point at which commands change the battle.
+	applyCommands();
+
+	//Move the battle forward a tick.
+	m_simulation.update(deltaTime);
+	m_tick.store(m_simulation.getTick(), std::memory_order_relaxed);
+
+	if(m_network)
+	{
+		//Every so often in lockstep, send the hash of the battle for the peer to check; and keep it, to check the peer's hash of the tick.
+		if(m_isLockstep && tick % HASH_INTERVAL == 0)
+		{
+			m_localHashes.push_back({tick, m_simulation.getStateHash()});
+			if(m_localHashes.size() > HASH_HISTORY) m_localHashes.pop_front();
+
+			m_network->sendStateHash(m_simulation.getStateHash());
+		}
+
+		//Close the frame of everything given during this tick, for the network thread to flush.
+		//Commands given from now on are stamped for a later tick than this; so in lockstep, the frame marks the tick the delay ahead done.
+		m_network->closeFrame(tick);
+	}
+
+	return true;
+}
+
+//Queues a command from the local player for their ship, to be applied at the start of the next tick; or after the input delay in lockstep.
+//The command is also sent to the peer in a networked battle, if it was queued. Only call from the thread running the battle.
+//	type : What the command orders the ship to do.
+//	position : Where to move to, or shoot at.
+//	targetLayer : The layer to shoot on; only used by fire commands.
+//Returns whether there was room for the command.
+bool BattleSession::queueLocalCommand(CommandType type, const sf::Vector2f &position, unsigned int targetLayer)
+{
+	//The local player's ship is always the first ship on their layer.
+	BattleCommand command;
+	command.type = type;
+	command.tick = m_simulation.getTick() + m_inputDelay;
+	command.shipLayer = m_localLayer;
+	command.position = position;
+	command.targetLayer = targetLayer;
+	//Carry out the command as the peer will receive it; or the two battles would differ by the precision lost on the wire.
+	Wire::quantiseCommand(command);
+
+	//Kept to send, as the queued command is moved from.
+	const BattleCommand sent = command;
+
+	//Only send the command if it was queued; the peer must not carry out a command we dropped.
+	if(!m_localCommands.tryPush(std::move(command))) return false;
+
+	if(m_network) m_network->sendCommand(sent);
+
+	return true;
+}
+
+//Queues a command received from the peer, to be applied at the start of the tick it is stamped with; only call from the network thread.
+//	command : The command received; left unchanged if the queue is full.
+//Returns whether there was room for the command.
+bool BattleSession::queueRemoteCommand(BattleCommand &&command)
+{
+	return m_remoteCommands.tryPush(std::move(command));
+}
+
+//Queues the hash of the peer's battle at the end of a tick, to be checked against our own; only call from the network thread.
+//	tick : The tick the hash is of.
+//	hash : The hash of the peer's battle at the end of the tick.
+//Returns whether there was room for the hash; a hash that is dropped is simply not checked.
+bool BattleSession::queueRemoteHash(std::uint32_t tick, std::uint64_t hash)
+{
+	return m_remoteHashes.tryPush({tick, hash});
+}
+
+//Marks every command the peer gives for the tick, and those before it, as received; only call from the network thread.
+//	tick : The tick the peer has sent every command for.
+void BattleSession::confirmRemoteTick(std::uint32_t tick)
+{
+	//Release, so the commands queued before the tick was marked are seen by the tick that waits on it.
+	m_remoteConfirmedTick.store(tick, std::memory_order_release);
+}
+
+//Applies every queued command that is stamped for this tick, or an earlier one; called at the start of each tick.
+void BattleSession::applyCommands()
+{
+	//The command being taken from a queue.
+	BattleCommand command;
+
+	//Take the local commands first; the order commands for the same tick, and layer, are applied in.
+	while(m_localCommands.tryPop(command))
+	{
+		m_pendingCommands.push_back(std::move(command));
+	}
+
+	while(m_remoteCommands.tryPop(command))
+	{
+		m_pendingCommands.push_back(std::move(command));
+	}
+
+	//Order the commands by tick, then layer, keeping the order they arrived in for the same ship;
+	//so in lockstep both peers apply the same tick's commands in the same order, whichever arrived first.
+	std::stable_sort(m_pendingCommands.begin(), m_pendingCommands.end(), [](const BattleCommand &lhs, const BattleCommand &rhs)
+	{
+		return lhs.tick < rhs.tick || (lhs.tick == rhs.tick && lhs.shipLayer < rhs.shipLayer);
+	});
+
+	//The first command stamped for a later tick; it, and every command after it, waits for its tick.
+	auto due = m_pendingCommands.begin();
+
+	for(; due != m_pendingCommands.end() && due->tick <= m_simulation.getTick(); ++due)
+	{
+		m_simulation.applyCommand(*due);
+
+		if(due->type != CommandType::CREATE_SHIP) ++m_ordersApplied[due->shipLayer == m_localLayer ? 0 : 1];
+	}
+
+	m_pendingCommands.erase(m_pendingCommands.begin(), due);
+}
+
+//Checks the peer's hashes of the ticks we have run against our own, and dumps the battle once it reaches the dump tick of a mismatch.
+//Called at the start of each tick in lockstep.
+void BattleSession::checkStateHashes()
+{
+	//The tick about to be run.
+	const std::uint32_t tick = m_simulation.getTick();
+	//The hash being taken from the queue.
+	TickHash remoteHash;
+
+	while(m_remoteHashes.tryPop(remoteHash))
+	{
+		m_pendingRemoteHashes.push_back(remoteHash);
+	}
+
+	for(auto remote = m_pendingRemoteHashes.begin(); remote != m_pendingRemoteHashes.end();)
+	{
+		//Keep the hashes of ticks we have not run yet, until we have.
+		if(remote->tick >= tick)
+		{
+			++remote;
+			continue;
+		}
+
+		auto local = std::find_if(m_localHashes.begin(), m_localHashes.end(), [&remote](const TickHash &localHash)
+		{
+			return localHash.tick == remote->tick;
+		});
+
+		if(!m_isDesynced && local != m_localHashes.end() && local->hash != remote->hash)
+		{
+			m_isDesynced = true;
+			m_desync = *local;
+			m_desyncRemoteHash = remote->hash;
+			//The peer sends the hash before marking the tick after it done; so both peers find the mismatch by this tick, and dump at it.
+			m_desyncDumpTick = remote->tick + m_inputDelay + 1;
+
+			std::cerr << "Desync at tick " << m_desync.tick << "; local hash " << std::hex << m_desync.hash << ", peer hash "
+				<< m_desyncRemoteHash << std::dec << std::endl;
+		}
+
+		remote = m_pendingRemoteHashes.erase(remote);
+	}
+
+	//Dump the battle before the dump tick runs; both peers are then at the same point, however far apart they found the mismatch.
+	if(m_isDesynced && !m_isDesyncDumped && tick >= m_desyncDumpTick)
+	{
+		m_isDesyncDumped = true;
+
+		const std::string dumpPath = std::string("desync-") + (m_network->isHost() ? "host" : "peer")
+			+ "-tick" + std::to_string(tick) + ".txt";
+		std::ofstream dump(dumpPath);
+
+		dump << "desync tick " << m_desync.tick << " local hash " << std::hex << m_desync.hash << " peer hash " << m_desyncRemoteHash
+			<< std::dec << "\n";
+		m_simulation.dumpState(dump);
+
+		std::cerr << "Battle dumped to " << dumpPath << std::endl;
+	}
+}
@@ -0,0 +1,462 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "BattleSimulation.hpp"
+
+#include <algorithm> //For std::find, and std::find_if.
+#include <numeric> //For std::iota.
+#include <ostream> //For dumping the battle's state.
+
+//Basic BattleSimulation constructor.
+//	hullKey : Pristine collision key of the hull every ship is built from; shared by the ships, so it must outlive the battle.
+//	jobs : Workers to spread each tick over; nullptr to run every tick on the calling thread. Must outlive the battle.
+BattleSimulation::BattleSimulation(const DamageMask &hullKey, JobSystem *jobs)
+	:m_hullKey(hullKey), m_jobs(jobs), m_bounds({0, 0, 4000, 4000}), m_shipGrid{ShipGrid(m_bounds), ShipGrid(m_bounds)}
+{
+	//Each worker keeps its own buffers, so they never write to the same memory.
+	if(m_jobs)
+	{
+		m_workerCandidates.resize(m_jobs->getWorkerCount());
+		m_workerTests.resize(m_jobs->getWorkerCount());
+	}
+}
+
+//Processes the battle to move it forward a tick.
+//	deltaTime : The amount of time that has passed since the last update.
+void BattleSimulation::update(const sf::Time &deltaTime)
+{
+	m_collisionStats = CollisionStats();
+
+	//Create every projectile that was fired last tick; nothing is firing now, so the queue can be drained.
+	m_shotQueue.drain(m_readyToFire);
+	m_projPool.create(m_readyToFire);
+
+	m_removedShips.clear();
+
+	//Process the projectiles this tick.
+	if(m_jobs)
+	{
+		resolveProjectilesParallel(deltaTime);
+	}
+	else
+	{
+		resolveProjectiles(deltaTime);
+	}
+
+	//Lock ship list for write access.
+	m_shipMutex.lock();
+
+	if(m_jobs)
+	{
+		updateShipsParallel(deltaTime);
+	}
+	else
+	{
+		//Process every ship on each layer for this tick.
+		for(const auto &battleLayer : m_shipList)
+		{
+			for(const auto &ship : battleLayer)
+			{
+				ship->update(deltaTime);
+			}
+		}
+	}
+
+	m_shipMutex.unlock();
+
+	m_stateHash = hashState();
+	++m_tick;
+}
+
+//Copies how the battle looks as of this tick into the snapshot; reuses the snapshot's memory where it can.
+//Only call from the thread updating the battle.
+//	snapshot : The snapshot to fill.
+void BattleSimulation::fillSnapshot(RenderSnapshot &snapshot) const
+{
+	//Ships are drawn layer by layer, so the second layer is drawn over the first.
+	snapshot.ships.resize(m_shipList[0].size() + m_shipList[1].size());
+
+	auto shipSnapshot = snapshot.ships.begin(); //Snapshot of the ship being copied.
+
+	for(const auto &battleLayer : m_shipList)
+	{
+		for(const auto &ship : battleLayer)
+		{
+			ship->fillSnapshot(*shipSnapshot++);
+		}
+	}
+
+	snapshot.projectiles = m_projPool;
+}
+
+//Writes the state of the battle as text, with exact floats; so the dumps of two diverged battles may be diffed.
+//Only call from the thread updating the battle.
+//	stream : The stream to write to.
+void BattleSimulation::dumpState(std::ostream &stream) const
+{
+	stream << "tick " << m_tick << " hash " << std::hex << m_stateHash << std::dec << "\n";
+
+	for(unsigned int layer = 0; layer < 2; ++layer)
+	{
+		for(std::size_t i = 0; i < m_shipList[layer].size(); ++i)
+		{
+			stream << "ship " << layer << " " << i << "\n";
+			m_shipList[layer][i]->dumpState(stream);
+		}
+	}
+
+	stream << "projectiles " << m_projPool.size() << "\n" << std::hexfloat;
+
+	for(std::size_t i = 0; i < m_projPool.size(); ++i)
+	{
+		stream << static_cast<int>(m_projPool.getProjectileType(i)) << " " << m_projPool.getLayer(i) << " "
+			<< m_projPool.getPosition(i).x << " " << m_projPool.getPosition(i).y << " "
+			<< m_projPool.getVelocity(i).x << " " << m_projPool.getVelocity(i).y << "\n";
+	}
+
+	stream << std::defaultfloat;
+}
+
+//Creates a ship with the passed information.
+//	team : The team the ship belongs to.
+//	position : Where the ship should start on creation.
+//	angle : The rotation of the ship on creation.
+//	turretBuildList : The turrets the ship should start with.
+void BattleSimulation::createShip(unsigned int team, const sf::Vector2f &position, float angle, const std::vector<TurretInfo> &turretBuildList)
+{
+	//Lock ship list for write access.
+	m_shipMutex.lock();
+
+	//Ships are updated layer by layer, in creation order; so ordering their shots by layer, then creation, matches the serial tick.
+	const std::uint64_t fireOrder = std::uint64_t(team) << 32 | m_shipsCreated;
+
+	//Create a new unique pointer that stores a ship.
+	m_shipList[team].push_back(std::make_unique<Ship>(position, angle, turretBuildList, m_hullKey, &m_shotQueue, fireOrder));
+	//Ships are only ever appended, and removal keeps the order, so creation order is the order in the list.
+	m_shipGrid[team].add(m_shipList[team].back().get(), m_shipsCreated++);
+
+	m_shipMutex.unlock();
+}
+
+//Carries out the command on the battle; commands to ships that no longer exist are ignored.
+//Only call between ticks, from the thread updating the battle.
+//	command : The command to carry out.
+void BattleSimulation::applyCommand(const BattleCommand &command)
+{
+	//Commands from the network are checked, as the sender may not yet know a ship was destroyed.
+	if(command.shipLayer >= 2 || command.targetLayer >= 2) return;
+
+	if(command.type == CommandType::CREATE_SHIP)
+	{
+		createShip(command.shipLayer, command.position, command.angle, command.turrets);
+		return;
+	}
+
+	if(command.shipID >= m_shipList[command.shipLayer].size()) return;
+
+	switch(command.type)
+	{
+		case CommandType::MOVE:
+			issueMoveCommand(command.shipLayer, command.shipID, command.position);
+
+			break;
+		case CommandType::FIRE:
+			issueFireCommand(command.shipLayer, command.shipID, command.position, command.targetLayer);
+
+			break;
+		default:
+			break;
+	}
+}
+
+//Passes a move command to the specified ship.
+//	shipLayer : The layer the ship is on; i.e. which team.
+//	shipID : The ID of the ship in the team.
+//	destination : Where the ship is being told to head to.
+void BattleSimulation::issueMoveCommand(unsigned int shipLayer, unsigned int shipID, const sf::Vector2f &destination)
+{
+	m_shipList[shipLayer][shipID]->moveCommand(destination);
+}
+
+//Passes a fire command to the specified ship.
+//	shipLayer : The layer the ship is on; i.e. which team.
+//	shipID : The ID of the ship in the team.
+//	target : Where the ship is being told to shoot at.
+//	targetLayer : Which layer the ship is being told to shoot on.
+void BattleSimulation::issueFireCommand(unsigned int shipLayer, unsigned int shipID, const sf::Vector2f &target, unsigned int targetLayer)
+{
+	m_shipList[shipLayer][shipID]->fireCommand(target, targetLayer);
+}
+
+//Processes a single tick for all projectiles.
+//	deltaTime : The amount of time that has passed since the last update.
+void BattleSimulation::resolveProjectiles(const sf::Time &deltaTime)
+{
+	//Move every projectile forward a tick.
+	m_projPool.update(deltaTime);
+
+	//Place the ships in the cells they moved to last tick.
+	for(auto &shipGrid : m_shipGrid)
+	{
+		shipGrid.update();
+	}
+
+	//Resolve the current tick for every projectile; removing projectiles that are finished.
+	for(std::size_t i = 0; i < m_projPool.size();)
+	{
+		sf::FloatRect projBounds = m_projPool.getGlobalBounds(i);
+
+		//Remove the projectile if it collided with something, or it is out of bounds.
+		//Removal moves the last projectile into this slot, so the index stays the same to process it next.
+		if(collide(i, projBounds, deltaTime) || !projBounds.intersects(m_bounds))
+		{
+			m_projPool.remove(i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+//Determines if the projectile collided with anything.
+//	index : Index of the projectile in the pool we are checking collisions for.
+//	projBounds : Global bounds of the projectile.
+//	deltaTime : The amount of time that has passed since the last update.
+//Returns whether a collision occurred.
+bool BattleSimulation::collide(std::size_t index, const sf::FloatRect &projBounds, const sf::Time &deltaTime)
+{
+	bool wasCollision = false; //Whether there was a collision.
+	unsigned int projLayer = m_projPool.getLayer(index); //Layer the projectile is on.
+	auto &shipList = m_shipList[projLayer]; //Ships on the projectile's layer.
+
+	//A ship can only be hit if its bounds intersect the projectile's, so only the ships in the same cells need testing.
+	m_shipGrid[projLayer].query(projBounds, m_candidates);
+
+	m_collisionStats.bruteForcePairs += shipList.size();
+	m_collisionStats.candidatePairs += m_candidates.size();
+
+	auto it = m_candidates.begin(); //Iterator through the ships the projectile may be hitting.
+
+	//Determines if there was a collision between the projectile, and any of the ships it may be hitting.
+	//Loops ends when a collision occurs, or there are no more ships to check.
+	while(!wasCollision && it != m_candidates.end())
+	{
+		//Marks there was a collision, and potentially removes ship, if there was a collision.
+		if((*it)->collide(m_projPool, index, deltaTime))
+		{
+			//Removes the ship from the game if it died from the shot.
+			removeIfDestroyed(*it, projLayer);
+
+			wasCollision = true;
+		}
+		else
+		{
+			it++;
+		}
+	}
+
+	return wasCollision;
+}
+
+//Processes a single tick for all projectiles, spread over the workers; the result is the same as resolveProjectiles.
+//	deltaTime : The amount of time that has passed since the last update.
+void BattleSimulation::resolveProjectilesParallel(const sf::Time &deltaTime)
+{
+	//Move every projectile forward a tick; each projectile only moves itself, so any split gives the same positions.
+	m_jobs->parallelFor(m_projPool.size(), PROJECTILE_GRAIN, [this, &deltaTime](std::size_t begin, std::size_t end, unsigned int)
+	{
+		m_projPool.update(deltaTime, begin, end);
+	});
+
+	//Place the ships in the cells they moved to last tick.
+	for(auto &shipGrid : m_shipGrid)
+	{
+		shipGrid.update();
+	}
+
+	for(auto &tests : m_workerTests)
+	{
+		tests.clear();
+	}
+
+	m_projectileTests.resize(m_projPool.size());
+
+	//Find the cell each projectile hits on each of its candidates, as the ships are before any hit this tick; nothing is changed yet.
+	//Testing stops at the first ship hit, as the serial tick does; each worker stores its tests in its own buffer.
+	m_jobs->parallelFor(m_projPool.size(), PROJECTILE_GRAIN, [this, &deltaTime](std::size_t begin, std::size_t end, unsigned int worker)
+	{
+		std::vector<Ship*> &candidates = m_workerCandidates[worker];
+		std::vector<CandidateTest> &tests = m_workerTests[worker];
+
+		for(std::size_t i = begin; i < end; ++i)
+		{
+			m_shipGrid[m_projPool.getLayer(i)].query(m_projPool.getGlobalBounds(i), candidates);
+			m_projectileTests[i] = {worker, tests.size(), candidates.size()};
+
+			//Whether a ship has been hit by the projectile.
+			bool wasHit = false;
+
+			for(Ship *ship : candidates)
+			{
+				const sf::Vector2i pixelHit = wasHit ? sf::Vector2i(-1, -1) : ship->findHit(m_projPool, i, deltaTime);
+
+				tests.push_back({ship, pixelHit, !wasHit});
+				wasHit = pixelHit.x != -1;
+			}
+		}
+	});
+
+	//Where each projectile in the pool was at the start of the tick; so its tests can still be found after removals have moved it.
+	m_projectileOrigins.resize(m_projPool.size());
+	std::iota(m_projectileOrigins.begin(), m_projectileOrigins.end(), 0);
+	m_hitShips.clear();
+
+	//Apply the hits in the same order as resolveProjectiles, removing projectiles that are finished the same way.
+	for(std::size_t i = 0; i < m_projPool.size();)
+	{
+		sf::FloatRect projBounds = m_projPool.getGlobalBounds(i);
+
+		//Remove the projectile if it collided with something, or it is out of bounds.
+		//Removal moves the last projectile into this slot, so the index stays the same to process it next.
+		if(collideTested(i, m_projectileTests[m_projectileOrigins[i]], deltaTime) || !projBounds.intersects(m_bounds))
+		{
+			m_projPool.remove(i);
+
+			m_projectileOrigins[i] = m_projectileOrigins.back();
+			m_projectileOrigins.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+//Processes a single tick for every ship, spread over the workers; the result is the same as updating them in order.
+//	deltaTime : The amount of time that has passed since the last update.
+void BattleSimulation::updateShipsParallel(const sf::Time &deltaTime)
+{
+	m_updateList.clear();
+
+	for(const auto &battleLayer : m_shipList)
+	{
+		for(const auto &ship : battleLayer)
+		{
+			m_updateList.push_back(ship.get());
+		}
+	}
+
+	//Ships only change themselves when they update; the shots they fire go to the shot queue, which orders them when drained.
+	m_jobs->parallelFor(m_updateList.size(), 1, [this, &deltaTime](std::size_t begin, std::size_t end, unsigned int)
+	{
+		for(std::size_t i = begin; i < end; ++i)
+		{
+			m_updateList[i]->update(deltaTime);
+		}
+	});
+}
+
+//Determines if the projectile collided with anything, from the tests the workers made of its candidates.
+//	index : Index of the projectile in the pool we are checking collisions for.
+//	tests : Where the tests of the projectile's candidates are.
+//	deltaTime : The amount of time that has passed since the last update.
+//Returns whether a collision occurred.
+bool BattleSimulation::collideTested(std::size_t index, const ProjectileTests &tests, const sf::Time &deltaTime)
+{
+	bool wasCollision = false; //Whether there was a collision.
+	unsigned int projLayer = m_projPool.getLayer(index); //Layer the projectile is on.
+	const CandidateTest *test = m_workerTests[tests.worker].data() + tests.first; //The test of the candidate being checked.
+
+	m_collisionStats.bruteForcePairs += m_shipList[projLayer].size();
+
+	for(const CandidateTest *end = test + tests.count; test != end; ++test)
+	{
+		//Ships destroyed earlier this tick have left the grid; the serial tick would not have found them.
+		//Their pointers are only compared, never followed, as the ships no longer exist.
+		if(std::find(m_removedShips.begin(), m_removedShips.end(), test->ship) != m_removedShips.end()) continue;
+
+		++m_collisionStats.candidatePairs;
+
+		//The projectile stops at the first ship hit; the remaining candidates are only counted.
+		if(wasCollision) continue;
+
+		//The test is only still correct if the ship has not been hit since it was made; otherwise, test the ship as it is now.
+		const bool isCurrent = test->isTested && std::find(m_hitShips.begin(), m_hitShips.end(), test->ship) == m_hitShips.end();
+		const sf::Vector2i pixelHit = isCurrent ? test->pixelHit : test->ship->findHit(m_projPool, index, deltaTime);
+
+		if(pixelHit.x != -1)
+		{
+			test->ship->applyHit(pixelHit);
+			m_hitShips.push_back(test->ship);
+
+			//Removes the ship from the game if it died from the shot.
+			removeIfDestroyed(test->ship, projLayer);
+
+			wasCollision = true;
+		}
+	}
+
+	return wasCollision;
+}
+
+//Hashes the state of the battle; called at the end of each tick.
+//Returns the hash of the battle's state.
+std::uint64_t BattleSimulation::hashState() const
+{
+	StateHash hash;
+	hash.mix(m_tick);
+
+	for(const auto &battleLayer : m_shipList)
+	{
+		hash.mix(battleLayer.size());
+
+		for(const auto &ship : battleLayer)
+		{
+			ship->hashState(hash);
+		}
+	}
+
+	//Projectiles are never reordered, except by removal, which happens in the same order in every battle given the same commands.
+	hash.mix(m_projPool.size());
+
+	for(std::size_t i = 0; i < m_projPool.size(); ++i)
+	{
+		hash.mixFloat(m_projPool.getPosition(i).x);
+		hash.mixFloat(m_projPool.getPosition(i).y);
+		//The velocity, so a differing course is caught this tick, rather than once it has moved the projectile.
+		hash.mixFloat(m_projPool.getVelocity(i).x);
+		hash.mixFloat(m_projPool.getVelocity(i).y);
+		//The layer, and type, decide which ships the projectile hits, and how much it damages them.
+		hash.mix(m_projPool.getLayer(i));
+		hash.mix(static_cast<std::uint64_t>(m_projPool.getProjectileType(i)));
+	}
+
+	return hash.getValue();
+}
+
+//Removes the ship from the battle if the hit destroyed it.
+//	ship : The ship that was hit.
+//	layer : The layer the ship is on.
+void BattleSimulation::removeIfDestroyed(Ship *ship, unsigned int layer)
+{
+	if(!ship->requiresCleanup()) return;
+
+	auto &shipList = m_shipList[layer]; //Ships on the same layer as the ship.
+
+	m_shipGrid[layer].remove(ship);
+	m_removedShips.push_back(ship);
+
+	m_shipMutex.lock();
+
+	shipList.erase(std::find_if(shipList.begin(), shipList.end(), [ship](const std::unique_ptr<Ship> &listedShip)
+	{
+		return listedShip.get() == ship;
+	}));
+
+	m_shipMutex.unlock();
+
+	//Flag the battle as finished, if the team that lost the ship no longer has any remaining ships.
+	//Never cleared, so a ship lost by the other team later in the same tick does not un-finish the battle.
+	if(shipList.size() == 0) m_isFinished = true;
+}
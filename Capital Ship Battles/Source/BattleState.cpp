@@ -3,54 +3,36 @@
  */
 #include "BattleState.hpp"
 
-#include "BuildState.hpp" //The state we want to change to when the battle ends.
-
-std::vector<ShotInfo> *Turret::s_fireList; //List that turrets use to queue shots.
+#include <algorithm> //For std::clamp.
 
-//Declared in an anonymous namespace to prevent name clashes.
-//These have to be global to allow them to be used in the const draw function.
-namespace
-{
-	sf::Mutex shipMutex; //Controls access to the ship list.
-	sf::Mutex projMutex; //Controls access to the projectile list.
-}
+#include "BuildState.hpp" //The state we want to change to when the battle ends.
 
 //Basic BattleState constructor.
 //	game : The state manager, and holder of high-level information on the game.
 //	isMultiplayer : Whether this battle is being networked.
 BattleState::BattleState(GameManager &game, bool isMultiplayer)
-	:m_game(game), m_networkThread(&NetworkManager::receive, &m_game.getNetworkManager()),
-	m_viewBounds({0, 0, 4000, 4000}), m_gameView(m_game.getWindow().getView()),
-	areaBorder(sf::Vector2f(m_viewBounds.width, m_viewBounds.height))
+	:m_game(game),
+	m_simulation(*m_game.getResourceManager().loadDamageKey("Assets/hull.png"), &m_jobs),
+	m_session(m_simulation, isMultiplayer ? &m_game.getNetworkManager() : nullptr),
+	m_networkThread(&NetworkManager::receive, &m_game.getNetworkManager()),
+	m_gameView(m_game.getWindow().getView()), m_viewBounds(m_simulation.getBounds()),
+	areaBorder(sf::Vector2f(m_viewBounds.width, m_viewBounds.height)),
+	m_shipRenderer(m_game.getResourceManager().loadTexture("Assets/hull.png"), m_game.getResourceManager().loadTexture("Assets/turrets.png"),
+		m_game.getResourceManager().loadShader("Assets/damageShader.frag", sf::Shader::Fragment))
 {
-	//Allow turrets to queue shots directly to the projectile creation list.
-	Turret::s_fireList = &m_readyToFire;
-	
 	//The centre of the playable area.
 	sf::Vector2f centreField = {m_viewBounds.width / 2.f, m_viewBounds.height / 2.f};
 	//How much we are going to offset both ships from the centre.
 	sf::Vector2f shipOffset = {200, 200};
 
-	//Create empty vectors on both indices.
-	m_shipList[0] = std::vector<std::unique_ptr<Ship>>();
-	m_shipList[1] = std::vector<std::unique_ptr<Ship>>();
-
 	//Launch the networking thread, so both players can receive each other's ships; if we are in multiplayer mode.
 	if(isMultiplayer)
 	{
-		//Create the player's ship in the top-left if they are the host.
-		if(m_game.getNetworkManager().isHost())
-		{
-			createShip(0, {1800, 1800}, 45, m_game.turretBuildList);
-		}
-		//Otherwise, create it in the bottom-right.
-		else
-		{
-			createShip(0, {2200, 2200}, 225, m_game.turretBuildList);
-		}
+		//The local player's ship; in the top-left if they are the host, otherwise in the bottom-right.
+		m_session.createLocalShip(m_game.turretBuildList);
 
 		//Set the variables needed by the network manager to network this battle.
-		m_game.getNetworkManager().setBattle(this);
+		m_game.getNetworkManager().setBattle(&m_session);
 		m_game.getNetworkManager().setTurretList(m_game.turretBuildList);
 
 		//Launch the networking thread, so we may receive packets.
@@ -89,7 +71,6 @@ BattleState::~BattleState()
 void BattleState::handleInput(const sf::Event &event)
 {
 	sf::Vector2f mouseGlobalPosition;
-	sf::Packet packet;
 
 	//Handle each type of event.
 	switch(event.type)
@@ -103,30 +84,12 @@ void BattleState::handleInput(const sf::Event &event)
 				
 				//Issue a move command if the right mouse button was pressed.
 				case sf::Mouse::Right:
-					issueMoveCommand(0, 0, mouseGlobalPosition);
-
-					//Package the command to move for transport.
-					packet << std::underlying_type_t<PacketType>(PacketType::MOVE);
-					packet << 0;
-					packet << mouseGlobalPosition.x;
-					packet << mouseGlobalPosition.y;
-
-					//Send the move command over the network.
-					m_game.getNetworkManager().send(packet);
+					m_session.queueLocalCommand(CommandType::MOVE, mouseGlobalPosition);
 
 					break;
-				//Issue an attack command on the left mouse button being pressed.
+				//Issue an attack command, on the other player's layer, on the left mouse button being pressed.
 				case sf::Mouse::Left:
-					issueFireCommand(0, 0, mouseGlobalPosition, 1);
-
-					//Package the command to attack.
-					packet << std::underlying_type_t<PacketType>(PacketType::FIRE);
-					packet << 0;
-					packet << mouseGlobalPosition.x;
-					packet << mouseGlobalPosition.y;
-
-					//Send the attack command.
-					m_game.getNetworkManager().send(packet);
+					m_session.queueLocalCommand(CommandType::FIRE, mouseGlobalPosition, 1 - m_session.getLocalLayer());
 
 					break;
 			}
@@ -195,46 +158,30 @@ void BattleState::handleInput(const sf::Event &event)
 
 //Processes the state logic to move the state forward a tick.
 //	deltaTime : The amount of time that has passed since the last update.
-void BattleState::update(const sf::Time &deltaTime)
+//Returns whether the tick ran; false if the state is waiting on something outside the game, i.e. the peer in lockstep.
+bool BattleState::update(const sf::Time &deltaTime)
 {
-	//Lock projectile list for write access.
-	projMutex.lock();
-
-	//Create every projectile that has been queued.
-	for(const auto &fireInfo : m_readyToFire)
-	{
-		createProjectile(fireInfo);
-	}
-
-	projMutex.unlock();
-
-	//Clear the list, as the projectiles have been created.
-	m_readyToFire.clear();
-
-	//Process the projectiles this tick.
-	resolveProjectiles(deltaTime);
-
-	//Lock ship list for write access.
-	shipMutex.lock();
-
-	//Process every ship on each layer for this tick.
-	for(const auto &battleLayer : m_shipList)
-	{
-		for(const auto &ship : battleLayer)
-		{
-			ship->update(deltaTime);
-		}
-	}
-
-	shipMutex.unlock();
+	//Run the tick; in lockstep, it waits on the peer until they have marked it done.
+	if(!m_session.update(deltaTime)) return false;
+
+	//Hand the state of the battle at the end of this tick to the rendering thread, with when the tick was due, for interpolating.
+	RenderSnapshot &snapshot = m_snapshots.getWriteBuffer();
+	m_simulation.fillSnapshot(snapshot);
+	snapshot.tickTime = m_game.getTickTime();
+	snapshot.tickLength = deltaTime;
+	snapshot.tickInterval = m_game.getTickInterval();
+	m_snapshots.publish();
+	m_game.requestRedraw();
 
 	//Go to the build state if the battle is finished; i.e. either team has no ships.
 	//We can't kill the state during the collision as the stack needs to unwind,
 	//and the update may try to work with corrupt data if we kill the state too soon.
-	if(m_isFinished)
+	if(m_simulation.isFinished())
 	{
 		changeToBuildState();
 	}
+
+	return true;
 }
 
 //Draws all renderable elements of the state to the screen.
@@ -251,31 +198,22 @@ void BattleState::draw(sf::RenderTarget &target, sf::RenderStates states) const
 	//Draw border below everything else.
 	target.draw(areaBorder);
 
-	//Lock ship list for rendering.
-	shipMutex.lock();
+	//The most recent tick the simulation published; it stays unchanged until the next frame takes a newer one.
+	const RenderSnapshot &snapshot = m_snapshots.getReadBuffer();
 
-	//Draw ships, on all layers, onto the render target.
-	for(const auto &battleLayer : m_shipList)
-	{
-		//Draw each ship on the current layer.
-		for(const auto &ship : battleLayer)
-		{
-			target.draw(*ship, states);
-		}
-	}
+	//The battle is drawn a tick behind, moving from the tick before the snapshot to the snapshot's own tick while the next tick runs;
+	//so it moves smoothly however many frames are drawn for each tick.
+	const float interpolation = snapshot.tickInterval == sf::Time::Zero ? 1.f
+		: std::clamp((m_game.getGameTime() - snapshot.tickTime) / snapshot.tickInterval, 0.f, 1.f);
 
-	shipMutex.unlock();
+	//Upload the damage the ships took since the last frame, and draw them, on all layers, onto the render target.
+	m_shipRenderer.update(snapshot.ships, interpolation);
+	target.draw(m_shipRenderer, states);
 
-	//Lock projectile list for rendering.
-	projMutex.lock();
+	m_projRenderer.update(snapshot.projectiles, snapshot.tickLength * (1 - interpolation));
 
-	//Draw every projectile onto the render target.
-	for(const auto &proj : m_projList)
-	{
-		target.draw(*proj, states);
-	}
-
-	projMutex.unlock();
+	//Draw every projectile onto the render target in one draw call.
+	target.draw(m_projRenderer, states);
 
 	//Restore the target's view.
 	target.setView(targetView);
@@ -294,113 +232,7 @@ void BattleState::updateView()
 //	turretBuildList : The turrets the ship should start with.
 void BattleState::createShip(unsigned int team, const sf::Vector2f &position, float angle, const std::vector<TurretInfo> &turretBuildList)
 {
-	//Lock ship list for write access.
-	shipMutex.lock();
-
-	//Create a new unique pointer that stores a ship.
-	m_shipList[team].push_back(std::make_unique<Ship>(position, angle, turretBuildList,
-		m_game.getResourceManager().loadTexture("Assets/hull.png"), m_game.getResourceManager().loadTexture("Assets/turrets.png")));
-
-	shipMutex.unlock();
-}
-
-//Passes a move command to the specified ship.
-//	shipLayer : The layer the ship is on; i.e. which team.
-//	shipID : The ID of the ship in the team.
-//	destination : Where the ship is being told to head to.
-void BattleState::issueMoveCommand(unsigned int shipLayer, unsigned int shipID, const sf::Vector2f &destination)
-{
-	m_shipList[shipLayer][shipID]->moveCommand(destination);
-}
-
-//Passes a fire command to the specified ship.
-//	shipLayer : The layer the ship is on; i.e. which team.
-//	shipID : The ID of the ship in the team.
-//	target : Where the ship is being told to shoot at.
-//	targetLayer : Which layer the ship is being told to shoot on.
-void BattleState::issueFireCommand(unsigned int shipLayer, unsigned int shipID, const sf::Vector2f &target, unsigned int targetLayer)
-{
-	m_shipList[shipLayer][shipID]->fireCommand(target, targetLayer);
-}
-
-//Creates a projectile with the passed information.
-//	info : The information used to create the projectile.
-void BattleState::createProjectile(const ShotInfo &info)
-{
-	projMutex.lock();
-
-	m_projList.push_back(std::make_unique<Projectile>(info));
-
-	projMutex.unlock();
-}
-
-//Processes a single tick for all projectiles.
-//	deltaTime : The amount of time that has passed since the last update.
-void BattleState::resolveProjectiles(const sf::Time &deltaTime)
-{
-	///Too many projectiles can cause the draw thread to starve.
-	//Lock projectile list for write access; necessary here as we might delete the projectile and change the list.
-	projMutex.lock();
-
-	//Iterate through projectiles and resolve the current tick; delete projectiles that are finished.
-	for(auto it = m_projList.begin(); it != m_projList.end();)
-	{
-		//Process a tick for the projectile.
-		(*it)->update(deltaTime);
-
-		//Remove the projectile if it is finished, it collided with something, or it is out of bounds.
-		if((*it)->requiresCleanup() || collide(*it, deltaTime) || !(*it)->getGlobalBounds().intersects(m_viewBounds))
-		{
-			it = m_projList.erase(it);
-		}
-		else
-		{
-			it++;
-		}
-	}
-
-	projMutex.unlock();
-}
-
-//Determines if the projectile collided with anything.
-//	proj : The projectile we are checking collisions for.
-//	deltaTime : The amount of time that has passed since the last update.
-//Returns whether a collision occurred.
-bool BattleState::collide(const std::unique_ptr<Projectile> &proj, const sf::Time &deltaTime)
-{
-	bool wasCollision = false; //Whether there was a collision.
-	unsigned int projLayer = proj->getLayer(); //Layer the projectile is on.
-	auto it = m_shipList[projLayer].begin(); //Iterator through ship list on projectile's layer.
-
-	//Determines if there was a collision between the projectile, and any of the ships on the same layer.
-	//Loops ends when a collision occurs, or there are no more ships to check.
-	while(!wasCollision && it != m_shipList[projLayer].end())
-	{
-		//Marks there was a collision, and potentially removes ship, if there was a collision.
-		if((*it)->collide(*proj, deltaTime))
-		{
-			//Removes the ship from the game if it died from the shot.
-			if((*it)->requiresCleanup())
-			{
-				shipMutex.lock();
-
-				it = m_shipList[projLayer].erase(it);
-
-				shipMutex.unlock();
-
-				//Flag the battle as finished, if the team that lost the ship no longer has any remaining ships.
-				m_isFinished = m_shipList[projLayer].size() == 0;
-			}
-
-			wasCollision = true;
-		}
-		else
-		{
-			it++;
-		}		
-	}
-
-	return wasCollision;
+	m_simulation.createShip(team, position, angle, turretBuildList);
 }
 
 //Ends the battle state, and proceeds to the build state.
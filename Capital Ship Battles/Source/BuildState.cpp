@@ -10,21 +10,15 @@
 const sf::Color BuildState::COLOUR_PLACEABLE(sf::Color(255, 255, 255, 100));
 const sf::Color BuildState::COLOUR_OBSTRUCTED(sf::Color(255, 0, 0, 100));
 
-//Declared in an anonymous namespace to prevent name clashes.
-//These have to be global to allow them to be used in the const draw function.
-namespace
-{
-	sf::Mutex turretMutex; //Controls access to turret list, for multithreaded rendering.
-	sf::Mutex turretTypeMutex; //Controls access to turret type label.
-}
-
 //Basic BuildState constructor.
 //	game : The state manager, and holder of high-level information on the game.
 BuildState::BuildState(GameManager &game)
 	:m_game(game),
-	m_hull({0, 0}, 0, {}, m_game.getResourceManager().loadTexture("Assets/hull.png"), m_game.getResourceManager().loadTexture("Assets/turrets.png")),
+	m_hull({0, 0}, 0, {}, *m_game.getResourceManager().loadDamageKey("Assets/hull.png")), m_hullSnapshot(1),
+	m_hullRenderer(m_game.getResourceManager().loadTexture("Assets/hull.png"), m_game.getResourceManager().loadTexture("Assets/turrets.png"),
+		m_game.getResourceManager().loadShader("Assets/damageShader.frag", sf::Shader::Fragment)),
 	m_turretProjType(ProjectileType::LASER),
-	m_buildPreview({TurretInfo{m_turretProjType, {0, 0}}, nullptr, m_game.getResourceManager().loadTexture("Assets/turrets.png")}),
+	m_buildPreview({TurretInfo{m_turretProjType, {0, 0}}, nullptr, nullptr, m_game.getResourceManager().loadTexture("Assets/turrets.png")}),
 	m_singleplayerButton(std::bind(&BuildState::startSingleplayer, this)),
 	m_multiplayerButton(std::bind(&BuildState::startMultiplayer, this)),
 	m_laserButton(std::bind(&BuildState::setProjectileType, this, ProjectileType::LASER)),
@@ -32,7 +26,7 @@ BuildState::BuildState(GameManager &game)
 	m_plasmaButton(std::bind(&BuildState::setProjectileType, this, ProjectileType::PLASMA))
 {
 	//Load the font used by the GUI elements.
-	const sf::Font &arimoFont = *game.getResourceManager().loadFont("Assets/fonts/Arimo-Regular.ttf");
+	const sf::Font &arimoFont = *game.getResourceManager().loadFont("Assets/Fonts/Arimo-Regular.ttf");
 
 	//Set-up the label that displays the current turret type.
 	m_turretTypeText.setFont(arimoFont);
@@ -56,7 +50,7 @@ BuildState::BuildState(GameManager &game)
 		//and the construction hull has a centered origin.
 		buildInfo.localPosition -= m_hull.getOrigin();
 		//Create a new turret with the corrected information.
-		m_turretList.push_back(std::make_unique<Turret>(buildInfo, nullptr, m_game.getResourceManager().loadTexture("Assets/turrets.png")));
+		m_turretList.push_back(std::make_unique<Turret>(buildInfo, nullptr, nullptr, m_game.getResourceManager().loadTexture("Assets/turrets.png")));
 	}
 }
 
@@ -148,19 +142,24 @@ void BuildState::handleInput(const sf::Event &event)
 
 //Processes the state logic to move the state forward a tick.
 //	deltaTime : The amount of time that has passed since the last update.
-void BuildState::update(const sf::Time &deltaTime)
-{}
+//Returns whether the tick ran; false if the state is waiting on something outside the game, i.e. the peer in lockstep.
+bool BuildState::update(const sf::Time &deltaTime)
+{
+	return true;
+}
 
 //Draws all renderable elements of the state to the screen.
 //	target : What we will be drawing onto.
 //	states : Visual manipulations to the elements that are being drawn.
 void BuildState::draw(sf::RenderTarget &target, sf::RenderStates states) const
 {
-	//Draw the ship hull.
-	target.draw(m_hull, states);
+	//Draw the ship hull, from a snapshot of it taken for this frame.
+	m_hull.fillSnapshot(m_hullSnapshot[0]);
+	m_hullRenderer.update(m_hullSnapshot);
+	target.draw(m_hullRenderer, states);
 
 	//Lock turret list for drawing.
-	turretMutex.lock();
+	m_turretMutex.lock();
 
 	//Draw the turrets.
 	for(const auto &turret : m_turretList)
@@ -168,7 +167,7 @@ void BuildState::draw(sf::RenderTarget &target, sf::RenderStates states) const
 		target.draw(*turret, states);
 	}
 
-	turretMutex.unlock();
+	m_turretMutex.unlock();
 
 	//Draw the preview of the next turret.
 	target.draw(m_buildPreview, states);
@@ -181,11 +180,11 @@ void BuildState::draw(sf::RenderTarget &target, sf::RenderStates states) const
 	target.draw(m_plasmaButton, states);
 
 	//Lock turret type label so it may be drawn to the screen.
-	turretTypeMutex.lock();
+	m_turretTypeMutex.lock();
 
 	target.draw(m_turretTypeText, states);
 
-	turretTypeMutex.unlock();
+	m_turretTypeMutex.unlock();
 }
 
 //Update the state's view, i.e. fix the GUI, and other elements, from a window resize.
@@ -217,6 +216,8 @@ void BuildState::updateView()
 
 	//Place the GUI elements mapped to global co-ordinates.
 	m_hull.setPosition(m_game.getWindow().mapPixelToCoords(sf::Vector2i(hullPosition), m_game.getWindow().getView()));
+	//The hull is drawn, and collided, with its cached transform; so it must be recomputed after placing it.
+	m_hull.updateTickTransforms();
 	m_singleplayerButton.setPosition(m_game.getWindow().mapPixelToCoords(sf::Vector2i(singleplayerButtonPosition)));
 	m_multiplayerButton.setPosition(m_game.getWindow().mapPixelToCoords(sf::Vector2i(multiplayerButtonPosition)));
 	m_laserButton.setPosition(m_game.getWindow().mapPixelToCoords(sf::Vector2i(laserButtonPosition)));
@@ -238,12 +239,12 @@ void BuildState::setProjectileType(ProjectileType projType)
 	sf::Color oldColour = m_buildPreview.getFillColor();
 
 	//Changes preview (ghost) turret to the new projectile type by constructing a new object.
-	m_buildPreview = Turret({projType, m_buildPreview.getPosition()}, nullptr, m_game.getResourceManager().loadTexture("Assets/turrets.png"));
+	m_buildPreview = Turret({projType, m_buildPreview.getPosition()}, nullptr, nullptr, m_game.getResourceManager().loadTexture("Assets/turrets.png"));
 	//Keep the colour of the turret.
 	m_buildPreview.setFillColor(oldColour);
 
 	//Lock turret type label for write access.
-	turretTypeMutex.lock();
+	m_turretTypeMutex.lock();
 
 	switch(projType)
 	{
@@ -267,7 +268,7 @@ void BuildState::setProjectileType(ProjectileType projType)
 			break;
 	}
 
-	turretTypeMutex.unlock();
+	m_turretTypeMutex.unlock();
 }
 
 //Adds a turret to the ship under construction, where the preview is.
@@ -278,12 +279,12 @@ bool BuildState::addTurret()
 	if(isValidPlacement(m_buildPreview))
 	{
 		//Lock turret list for writing.
-		turretMutex.lock();
+		m_turretMutex.lock();
 
 		//Create a new unique pointer to the turret, and store it in the list.
-		m_turretList.push_back(std::make_unique<Turret>(Turret({m_turretProjType, m_buildPreview.getPosition()}, &m_hull.getTransform(), m_game.getResourceManager().loadTexture("Assets/turrets.png"))));
+		m_turretList.push_back(std::make_unique<Turret>(Turret({m_turretProjType, m_buildPreview.getPosition()}, &m_hull.getTickTransform(), &m_hull.getTickInverseTransform(), m_game.getResourceManager().loadTexture("Assets/turrets.png"))));
 
-		turretMutex.unlock();
+		m_turretMutex.unlock();
 
 		//Return that the turret was placed.
 		return true;
@@ -297,7 +298,7 @@ bool BuildState::addTurret()
 void BuildState::clearArea()
 {
 	//Lock turret list for write access.
-	turretMutex.lock();
+	m_turretMutex.lock();
 
 	//Find, and remove, all turrets that intersect with the preview.
 	for(auto it = m_turretList.begin(); it != m_turretList.end();)
@@ -314,7 +315,7 @@ void BuildState::clearArea()
 		}
 	}
 
-	turretMutex.unlock();
+	m_turretMutex.unlock();
 
 	//Show the turret is no longer obstructed.
 	m_buildPreview.setFillColor(COLOUR_PLACEABLE);
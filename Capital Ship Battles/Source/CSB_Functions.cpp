@@ -21,8 +21,8 @@ namespace CSB
 
 		//Invert the direction if the angle difference is negative and less than 180,
 		//or the difference is greater than 180 and the target angle is larger than the current rotation.
-		if((angleDifference < 0 && abs(angleDifference) < 180) ||
-			(abs(angleDifference) >= 180 && angle > entity.getRotation()))
+		if((angleDifference < 0 && std::abs(angleDifference) < 180) ||
+			(std::abs(angleDifference) >= 180 && angle > entity.getRotation()))
 		{
 			direction = -1;
 		}
@@ -30,7 +30,7 @@ namespace CSB
 		//How much the entity should rotate this tick.
 		float turn = direction * deltaTime.asSeconds() * DEGREES_PER_SECOND;
 		//Set the rotation to the target, and return true, if the turn will bring us to the target.
-		if(abs(angleDifference) <= abs(turn))
+		if(std::abs(angleDifference) <= std::abs(turn))
 		{
 			entity.rotate(angleDifference);
 			return true;
@@ -0,0 +1,107 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "ChannelTransport.hpp"
+
+namespace
+{
+	const sf::Time PEER_TIMEOUT = sf::seconds(5); //How long the peer may go without sending a datagram before they are taken to have left.
+}
+
+//Stops the transport; the network thread closes whatever it is carried over, once it notices. Safe to call from any thread.
+void ChannelTransport::disconnect()
+{
+	m_isOpen = false;
+}
+
+//Returns whether the peer is still connected.
+bool ChannelTransport::isConnected() const
+{
+	return m_isOpen;
+}
+
+//Queues the handshake on the reliable stream.
+//	handshake : The bytes of the handshake.
+void ChannelTransport::sendHandshake(std::vector<std::uint8_t> handshake)
+{
+	m_channel.sendReliable(std::move(handshake));
+}
+
+//Queues a flush of frames on the redundant stream.
+//	frames : The bytes of the frames.
+void ChannelTransport::sendFrames(std::vector<std::uint8_t> frames)
+{
+	m_channel.sendRedundant(std::move(frames));
+}
+
+//Sends a datagram, if the reliability layer has anything due; only call from the network thread.
+void ChannelTransport::flush()
+{
+	sendDue();
+}
+
+//Waits, at most the timeout, for datagrams from the peer, and reads every one that arrived; only call from the network thread.
+//	timeout : The longest to wait.
+//Returns whether the peer is still connected; i.e. the transport is open, and the peer has sent something recently.
+bool ChannelTransport::wait(const sf::Time &timeout)
+{
+	std::vector<std::uint8_t> datagram;
+
+	if(waitForDatagram(timeout))
+	{
+		while(receiveDatagram(datagram))
+		{
+			readDatagram(datagram.data(), datagram.size());
+		}
+	}
+
+	if(getTime() - m_lastReceived >= PEER_TIMEOUT) m_isOpen = false;
+
+	return isConnected();
+}
+
+//Takes the next message from the peer; the handshake, then each flush of frames. Only call from the network thread.
+//	message : Set to the bytes of the message.
+//Returns whether there was a message.
+bool ChannelTransport::receive(std::vector<std::uint8_t> &message)
+{
+	//Nothing more is handed on once disconnected; i.e. after the peer says it is leaving.
+	if(!isConnected()) return false;
+
+	//The handshake is the first message on the reliable stream.
+	if(!m_hasHandshake) return m_hasHandshake = m_channel.takeReliable(message);
+
+	//Each message on the redundant stream is a flush of frames.
+	return m_channel.takeRedundant(message);
+}
+
+//Starts a new connection; forgetting everything about the last peer.
+void ChannelTransport::open()
+{
+	m_channel.reset();
+	m_hasHandshake = false;
+	m_lastReceived = getTime();
+	m_isOpen = true;
+}
+
+//Reads a datagram received from the peer into the reliability layer.
+//	data : The bytes of the datagram.
+//	size : How many bytes there are.
+//Returns whether the datagram was well-formed.
+bool ChannelTransport::readDatagram(const void *data, std::size_t size)
+{
+	if(!m_channel.readDatagram(data, size, getTime())) return false;
+
+	m_lastReceived = getTime();
+
+	return true;
+}
+
+//Sends a datagram, if the reliability layer has anything due.
+//	isForced : Whether to send a datagram even if nothing is due; i.e. to greet the peer.
+void ChannelTransport::sendDue(bool isForced)
+{
+	std::vector<std::uint8_t> datagram;
+
+	if(m_channel.writeDatagram(getTime(), datagram, isForced)) sendDatagram(std::move(datagram));
+}
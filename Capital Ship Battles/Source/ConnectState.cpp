@@ -23,7 +23,7 @@ ConnectState::ConnectState(GameManager &game)
 	m_leaveButton(std::bind(&ConnectState::startBuild, this))
 {
 	//Font used by the GUI elements.
-	const sf::Font &arimoFont = *m_game.getResourceManager().loadFont("Assets/fonts/Arimo-Regular.ttf");
+	const sf::Font &arimoFont = *m_game.getResourceManager().loadFont("Assets/Fonts/Arimo-Regular.ttf");
 
 	//Set text and font of the leave button.
 	m_leaveButton.setLabel("Leave", arimoFont);
@@ -123,7 +123,8 @@ void ConnectState::handleInput(const sf::Event &event)
 
 //Processes the state logic to move the state forward a tick.
 //	deltaTime : The amount of time that has passed since the last update.
-void ConnectState::update(const sf::Time &deltaTime)
+//Returns whether the tick ran; false if the state is waiting on something outside the game, i.e. the peer in lockstep.
+bool ConnectState::update(const sf::Time &deltaTime)
 {
 	//Lock access to peer flag, for read access.
 	peerFlagMutex.lock();
@@ -132,6 +133,8 @@ void ConnectState::update(const sf::Time &deltaTime)
 	if(m_hasPeer) startBattle();
 
 	peerFlagMutex.unlock();
+
+	return true;
 }
 
 //Draws all renderable elements of the state to the screen.
@@ -0,0 +1,182 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "DamageMask.hpp"
+
+#include <algorithm> //For std::min, and std::max.
+
+#ifdef _MSC_VER
+#include <intrin.h> //For _BitScanForward64, and _BitScanReverse64.
+#endif
+
+//Declared in an anonymous namespace to prevent name clashes.
+namespace
+{
+	//Returns the index of the lowest set bit; the word must not be zero.
+	//	word : The word to search.
+	unsigned int lowestBit(std::uint64_t word)
+	{
+	#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, word);
+		return index;
+	#else
+		return __builtin_ctzll(word);
+	#endif
+	}
+
+	//Returns the index of the highest set bit; the word must not be zero.
+	//	word : The word to search.
+	unsigned int highestBit(std::uint64_t word)
+	{
+	#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64(&index, word);
+		return index;
+	#else
+		return 63 - __builtin_clzll(word);
+	#endif
+	}
+
+	//Returns a word with only the bits in the range set.
+	//	begin : Lowest bit of the range; inclusive.
+	//	end : Highest bit of the range; exclusive, and greater than begin.
+	std::uint64_t rangeMask(unsigned int begin, unsigned int end)
+	{
+		return (~std::uint64_t(0) << begin) & (~std::uint64_t(0) >> (64 - end));
+	}
+}
+
+//Resizes the mask, and marks every cell as destroyed.
+//	width : How many cells wide the mask is.
+//	height : How many cells tall the mask is.
+void DamageMask::create(unsigned int width, unsigned int height)
+{
+	m_size = {width, height};
+	m_wordsPerRow = (width + WORD_BITS - 1) / WORD_BITS;
+	m_words.assign(m_wordsPerRow * height, 0);
+}
+
+//Finds the first intact cell on a row, walking from one column towards another; testing a word at a time.
+//Columns outside of the mask are skipped.
+//	y : Row to search along.
+//	first : Column the walk starts at; inclusive.
+//	last : Column the walk ends at; exclusive. May be less than first, to walk backwards.
+//Returns the column of the first intact cell found, or -1 if there is none.
+int DamageMask::findFirstSet(int y, int first, int last) const
+{
+	//Rows outside of the mask have nothing to hit.
+	if(y < 0 || static_cast<unsigned int>(y) >= m_size.y) return -1;
+
+	//Walking forwards, the first cell hit is the lowest in the range; walking backwards, the highest.
+	if(first < last)
+	{
+		int begin = std::max(first, 0);
+		int end = std::min(last, static_cast<int>(m_size.x));
+
+		return begin < end ? findLowestSet(y, begin, end) : -1;
+	}
+	else
+	{
+		int begin = std::max(last + 1, 0);
+		int end = std::min(first + 1, static_cast<int>(m_size.x));
+
+		return begin < end ? findHighestSet(y, begin, end) : -1;
+	}
+}
+
+//Returns the smallest area containing every cell that differs from another mask; compared a word at a time.
+//The whole mask is returned if the sizes differ, and an empty area if the masks match.
+//	other : The mask to compare against.
+sf::IntRect DamageMask::getChangedArea(const DamageMask &other) const
+{
+	if(m_size != other.m_size) return {0, 0, static_cast<int>(m_size.x), static_cast<int>(m_size.y)};
+
+	//Bounds of the changed cells; left and top are inclusive, right and bottom are exclusive.
+	int left = m_size.x, top = m_size.y, right = 0, bottom = 0;
+
+	for(unsigned int y = 0; y < m_size.y; ++y)
+	{
+		for(unsigned int word = 0; word < m_wordsPerRow; ++word)
+		{
+			//Bits that differ between the masks.
+			const std::uint64_t changed = m_words[y * m_wordsPerRow + word] ^ other.m_words[y * m_wordsPerRow + word];
+
+			if(changed != 0)
+			{
+				left = std::min(left, static_cast<int>(word * WORD_BITS + lowestBit(changed)));
+				right = std::max(right, static_cast<int>(word * WORD_BITS + highestBit(changed) + 1));
+				top = std::min(top, static_cast<int>(y));
+				bottom = y + 1;
+			}
+		}
+	}
+
+	return right > left ? sf::IntRect(left, top, right - left, bottom - top) : sf::IntRect();
+}
+
+//Expands an area of the mask to RGBA pixels; opaque white for intact cells, and transparent for destroyed cells.
+//	area : The area of the mask to expand, in cells; must be inside the mask.
+//	pixels : Filled with the pixels of the area, row by row.
+void DamageMask::getPixels(const sf::IntRect &area, std::vector<sf::Uint8> &pixels) const
+{
+	pixels.resize(area.width * area.height * 4);
+
+	//Position in the pixel buffer being written to.
+	auto pixel = pixels.begin();
+
+	for(int y = area.top; y < area.top + area.height; ++y)
+	{
+		for(int x = area.left; x < area.left + area.width; ++x)
+		{
+			//Every channel is the same; white and opaque, or black and transparent.
+			const sf::Uint8 value = isSet(x, y) ? 255 : 0;
+
+			pixel = std::fill_n(pixel, 4, value);
+		}
+	}
+}
+
+//Returns the lowest intact column in the range of a row, or -1 if there is none.
+//	y : Row to search along.
+//	begin : First column of the range; inclusive.
+//	end : Last column of the range; exclusive.
+int DamageMask::findLowestSet(unsigned int y, unsigned int begin, unsigned int end) const
+{
+	const std::uint64_t *row = &m_words[y * m_wordsPerRow];
+	const unsigned int lastWord = (end - 1) / WORD_BITS;
+
+	for(unsigned int word = begin / WORD_BITS; word <= lastWord; ++word)
+	{
+		//Only the part of the word inside of the range is tested.
+		const unsigned int wordBegin = word == begin / WORD_BITS ? begin % WORD_BITS : 0;
+		const unsigned int wordEnd = word == lastWord ? (end - 1) % WORD_BITS + 1 : WORD_BITS;
+		const std::uint64_t bits = row[word] & rangeMask(wordBegin, wordEnd);
+
+		if(bits != 0) return word * WORD_BITS + lowestBit(bits);
+	}
+
+	return -1;
+}
+
+//Returns the highest intact column in the range of a row, or -1 if there is none.
+//	y : Row to search along.
+//	begin : First column of the range; inclusive.
+//	end : Last column of the range; exclusive.
+int DamageMask::findHighestSet(unsigned int y, unsigned int begin, unsigned int end) const
+{
+	const std::uint64_t *row = &m_words[y * m_wordsPerRow];
+	const unsigned int firstWord = begin / WORD_BITS;
+
+	for(unsigned int word = (end - 1) / WORD_BITS + 1; word-- > firstWord;)
+	{
+		//Only the part of the word inside of the range is tested.
+		const unsigned int wordBegin = word == firstWord ? begin % WORD_BITS : 0;
+		const unsigned int wordEnd = word == (end - 1) / WORD_BITS ? (end - 1) % WORD_BITS + 1 : WORD_BITS;
+		const std::uint64_t bits = row[word] & rangeMask(wordBegin, wordEnd);
+
+		if(bits != 0) return word * WORD_BITS + highestBit(bits);
+	}
+
+	return -1;
+}
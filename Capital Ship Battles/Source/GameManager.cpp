@@ -3,6 +3,10 @@
  */
 #include "GameManager.hpp"
 
+#include <algorithm> //For std::min, and std::max.
+#include <chrono> //For the timeout of waiting for a redraw.
+#include <iostream> //For printing the frame timing.
+
 #include "ResourceManager.hpp" //For universal storage of textures and fonts.
 
 //Default GameManager constructor.
@@ -23,9 +27,11 @@ void GameManager::gameLoop()
 	startRenderThread();
 
 	//The amount of time accumulated since the last game tick.
-	sf::Time timeSinceLastTick = FIXED_UPDATES_PER_SECOND;
+	sf::Time timeSinceLastTick = m_tickLength;
 	//Keeps track of how much time has passed in the cycle.
-	sf::Clock gameClock;
+	sf::Clock cycleClock;
+	//Time since the tick counts were last printed.
+	sf::Clock statsClock;
 
 	//Keep the game running for as long as the window is open.
 	while(m_window.isOpen())
@@ -96,16 +102,26 @@ void GameManager::gameLoop()
 
 			//Pass the event to the current state.
 			m_currentGameState->handleInput(event);
+
+			//Any event may change what the state shows; i.e. the mouse moving over a button.
+			requestRedraw();
 		}
 
-		//Add the amount of time that occurred since the last tick.
-		timeSinceLastTick += gameClock.restart();
+		//Add the amount of game time that occurred since the last tick; less than the real time while the game is dilated.
+		timeSinceLastTick += cycleClock.restart() * m_timeScale;
+
+		runTicks(timeSinceLastTick);
+
+		if(m_isTickStatsEnabled && statsClock.getElapsedTime() >= FRAME_STATS_PERIOD)
+		{
+			printTickStats(m_tickStats, statsClock.restart());
+			m_tickStats = TickStats();
+		}
 
-		//Update the battle if more time has passed than the update rate per second.
-		while(timeSinceLastTick >= FIXED_UPDATES_PER_SECOND)
+		//Sleep until the next tick is due, rather than spinning on an empty event queue; events wait at most a tick to be handled.
+		if(m_framePacing != FramePacing::UNLIMITED)
 		{
-			m_currentGameState->update(FIXED_UPDATES_PER_SECOND);
-			timeSinceLastTick -= FIXED_UPDATES_PER_SECOND;
+			sf::sleep((m_tickLength - timeSinceLastTick) / m_timeScale - cycleClock.getElapsedTime());
 		}
 	}
 }
@@ -124,6 +140,60 @@ void GameManager::setState(std::unique_ptr<AbstractGameState> newState)
 	m_currentGameState->updateView();
 
 	m_stateChangeMutex.unlock();
+
+	requestRedraw();
+}
+
+//Sets how many ticks the game runs per second; only call before the game loop starts.
+//	ticksPerSecond : How many ticks are run per second; interpolated drawing keeps a low tick rate smooth.
+void GameManager::setTickRate(unsigned int ticksPerSecond)
+{
+	m_tickLength = CSB::tickLength(ticksPerSecond);
+
+	//The peer must run the same ticks; it is told on connecting.
+	m_networkManager.setTickLength(m_tickLength);
+}
+
+//Sets how the main loop catches up when ticks take longer than the tick length; only call before the game loop starts.
+//	maxTicksPerCycle : The most ticks run by a cycle of the main loop; any backlog beyond them is dropped.
+//	isTimeDilated : Whether the game slows down while it cannot keep up, so fewer ticks are dropped.
+void GameManager::setCatchUp(unsigned int maxTicksPerCycle, bool isTimeDilated)
+{
+	m_maxTicksPerCycle = std::max(maxTicksPerCycle, 1u);
+	m_isTimeDilated = isTimeDilated;
+}
+
+//Sets whether the main loop prints counts of its ticks every second; only call before the game loop starts.
+//	isEnabled : Whether the tick counts are printed.
+void GameManager::setTickStatsEnabled(bool isEnabled)
+{
+	m_isTickStatsEnabled = isEnabled;
+}
+
+//Sets how the rendering thread paces the frames it presents; only call before the game loop starts.
+//	pacing : How frames are paced.
+//	frameRateCap : The most frames presented per second; only used by FIXED_CAP.
+void GameManager::setFramePacing(FramePacing pacing, unsigned int frameRateCap)
+{
+	m_framePacing = pacing;
+	m_frameRateCap = std::max(frameRateCap, 1u);
+}
+
+//Sets whether the rendering thread prints the timing of its frames every second; only call before the game loop starts.
+//	isEnabled : Whether the frame timing is printed.
+void GameManager::setFrameStatsEnabled(bool isEnabled)
+{
+	m_isFrameStatsEnabled = isEnabled;
+}
+
+//Requests the rendering thread to present a new frame; only needed by the ON_CHANGE pacing. Safe to call from any thread.
+void GameManager::requestRedraw()
+{
+	m_redrawMutex.lock();
+	m_isRedrawRequested = true;
+	m_redrawMutex.unlock();
+
+	m_redrawCondition.notify_one();
 }
 
 //Updates view on the window's size being changed.
@@ -136,37 +206,179 @@ void GameManager::updateView()
 	//Fix the GUI from the window size change.
 	//This can occur from the window being recreated, which generates no event, so the state manager handles this.
 	m_currentGameState->updateView();
+
+	requestRedraw();
+}
+
+//Runs the ticks that are due, up to the most allowed in a cycle, and drops any backlog beyond them.
+//	timeSinceLastTick : Game time accumulated since the last tick; reduced by each tick run, and each tick dropped.
+void GameManager::runTicks(sf::Time &timeSinceLastTick)
+{
+	//How many ticks have been run this cycle.
+	unsigned int ticksRun = 0;
+
+	//Update the battle if more time has passed than the update rate per second.
+	while(timeSinceLastTick >= m_tickLength && ticksRun < m_maxTicksPerCycle)
+	{
+		//The tick was due when the accumulated time reached a whole tick; the time left over has passed since, at the time scale.
+		m_tickTime = m_gameClock.getElapsedTime() - (timeSinceLastTick - m_tickLength) / m_timeScale;
+
+		//The state is waiting on something outside the game; i.e. the peer in lockstep, who is also waiting, or behind.
+		//The time spent waiting is neither caught up on afterwards, nor taken as the game falling behind; so it is not dropped, or dilated.
+		if(!m_currentGameState->update(m_tickLength))
+		{
+			++m_tickStats.stalledTicks;
+			timeSinceLastTick = sf::microseconds(timeSinceLastTick.asMicroseconds() % m_tickLength.asMicroseconds());
+
+			break;
+		}
+
+		//The tick is late if the next tick was also already due when it started.
+		if(timeSinceLastTick >= m_tickLength * 2.f) ++m_tickStats.lateTicks;
+
+		timeSinceLastTick -= m_tickLength;
+
+		++ticksRun;
+		++m_tickStats.ticks;
+	}
+
+	//The cycle could not catch up; drop the whole ticks left, keeping the part of a tick, so the backlog cannot grow from cycle to cycle.
+	if(timeSinceLastTick >= m_tickLength)
+	{
+		//How many whole ticks are left in the backlog.
+		const sf::Int64 droppedTicks = timeSinceLastTick.asMicroseconds() / m_tickLength.asMicroseconds();
+
+		m_tickStats.droppedTicks += static_cast<unsigned long>(droppedTicks);
+		timeSinceLastTick -= m_tickLength * droppedTicks;
+
+		//Slow the game down, so it has longer to run each tick.
+		if(m_isTimeDilated) m_timeScale = std::max(m_timeScale * TIME_SCALE_DROP, MIN_TIME_SCALE);
+	}
+	//Speed the game back up gradually while it keeps up; a sudden jump would only fall behind again.
+	else if(m_timeScale < 1)
+	{
+		m_timeScale = std::min(m_timeScale * TIME_SCALE_RECOVERY, 1.f);
+	}
+}
+
+//Prints the counts of the ticks run over the last period.
+//	stats : Counts of the ticks.
+//	period : How long the period lasted.
+void GameManager::printTickStats(const TickStats &stats, const sf::Time &period) const
+{
+	std::cout << "Ticks: " << stats.ticks << " in " << period.asSeconds() << " s, late " << stats.lateTicks
+		<< ", dropped " << stats.droppedTicks << ", stalled " << stats.stalledTicks << ", time scale " << m_timeScale << std::endl;
 }
 
 //Draw the state elements to the window.
 //Placed on a seperate thread as we don't want the amount of draw calls to slow down the main thread.
 void GameManager::draw()
 {
+	//Vertical sync is a setting of the window's context, so it is set on the thread that renders with it; the window may have been recreated.
+	m_window.setVerticalSyncEnabled(m_framePacing == FramePacing::VSYNC);
+
+	//Timing of the frames presented since the last report.
+	FrameStats stats;
+	//Time since the last frame was presented.
+	sf::Clock frameClock;
+	//Time since the frame timing was last printed.
+	sf::Clock statsClock;
+
 	//Draw to the window as long as it is still open, and the main thread does not want the draw thread to end.
 	while(m_window.isOpen() && !m_isWaitingForRenderingEnd)
 	{
-		//Clear the window of anything that was drawn to it before.
-		m_window.clear(sf::Color(0, 0, 20));
+		if(waitForRedraw())
+		{
+			//Time spent drawing this frame.
+			sf::Clock drawClock;
+
+			//Clear the window of anything that was drawn to it before.
+			m_window.clear(sf::Color(0, 0, 20));
+
+			//Allows state to be drawn without read violation from changing state.
+			m_stateChangeMutex.lock();
+
+			//Draw the current state to the screen.
+			m_window.draw(*m_currentGameState);
 
-		//Allows state to be drawn without read violation from changing state.
-		m_stateChangeMutex.lock();
+			m_stateChangeMutex.unlock();
 
-		//Draw the current state to the screen.
-		m_window.draw(*m_currentGameState);
+			//Display the newly drawn elements to the screen.
+			m_window.display();
 
-		m_stateChangeMutex.unlock();
+			stats.drawTime += drawClock.getElapsedTime();
 
-		//Display the newly drawn elements to the screen.
-		m_window.display();
+			//Sleep out the rest of the frame, so frames are presented no faster than the cap.
+			if(m_framePacing == FramePacing::FIXED_CAP)
+			{
+				sf::sleep(sf::seconds(1.f / m_frameRateCap) - frameClock.getElapsedTime());
+			}
+
+			//Time since the last frame was presented.
+			const sf::Time frameTime = frameClock.restart();
+
+			++stats.frames;
+			stats.frameTime += frameTime;
+			stats.worstFrameTime = std::max(stats.worstFrameTime, frameTime);
+		}
+
+		if(m_isFrameStatsEnabled && statsClock.getElapsedTime() >= FRAME_STATS_PERIOD)
+		{
+			printFrameStats(stats, statsClock.restart());
+			stats = FrameStats();
+		}
 	}
 
 	//Abandon control of rendering, as draw thread is about to end.
 	m_window.setActive(false);
 }
 
+//Waits until a frame should be presented; for a redraw request with ON_CHANGE, or only until the rendering thread should end.
+//Returns whether a frame should be presented.
+bool GameManager::waitForRedraw()
+{
+	//Every other pacing presents frames continuously.
+	if(m_framePacing != FramePacing::ON_CHANGE) return true;
+
+	std::unique_lock<std::mutex> lock(m_redrawMutex);
+
+	//Wake at least once a period, so the frame timing is still printed while idle.
+	m_redrawCondition.wait_for(lock, std::chrono::microseconds(FRAME_STATS_PERIOD.asMicroseconds()), [this]()
+	{
+		return m_isRedrawRequested || m_isWaitingForRenderingEnd;
+	});
+
+	//Clear the request before drawing; a request made while drawing is then presented by the next frame.
+	const bool isRedrawRequested = m_isRedrawRequested && !m_isWaitingForRenderingEnd;
+	if(isRedrawRequested) m_isRedrawRequested = false;
+
+	return isRedrawRequested;
+}
+
+//Prints the timing of the frames presented over the last period.
+//	stats : Timing of the frames.
+//	period : How long the period lasted.
+void GameManager::printFrameStats(const FrameStats &stats, const sf::Time &period) const
+{
+	std::cout << "Frames: " << stats.frames << " in " << period.asSeconds() << " s";
+
+	if(stats.frames > 0)
+	{
+		std::cout << ", average frame " << stats.frameTime.asMicroseconds() / 1000.0 / stats.frames << " ms"
+			<< ", worst frame " << stats.worstFrameTime.asMicroseconds() / 1000.0 << " ms"
+			<< ", drawing " << stats.drawTime.asMicroseconds() / 1000.0 / stats.frames << " ms/frame";
+	}
+
+	//How much of the period the rendering thread spent drawing; the rest it was idle.
+	std::cout << ", busy " << 100.0 * stats.drawTime.asSeconds() / period.asSeconds() << "%" << std::endl;
+}
+
 //Safely starts drawing on the rendering thread.
 void GameManager::startRenderThread()
 {
+	//Present the first frame of the new window, even if nothing else changes.
+	requestRedraw();
+
 	//Deactivate rendering on the main thread, then launch the rendering thread.
 	m_window.setActive(false);
 	m_renderThread.launch();
@@ -175,7 +387,11 @@ void GameManager::startRenderThread()
 //Causes the draw thread to safely close; useful for safely closing, or recreating the window.
 void GameManager::endRenderThread()
 {
-	//Set the flag and wait for the rendering thread to close.
+	//Set the flag, wake the rendering thread if it is waiting for a redraw, and wait for it to close.
+	m_redrawMutex.lock();
 	m_isWaitingForRenderingEnd = true;
+	m_redrawMutex.unlock();
+
+	m_redrawCondition.notify_one();
 	m_renderThread.wait();
 }
@@ -0,0 +1,182 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "JobSystem.hpp"
+
+#include <algorithm> //For std::min, and std::max.
+
+//Basic JobSystem constructor; starts the worker threads.
+//	workerCount : How many workers run each loop, including the calling thread; at least one.
+JobSystem::JobSystem(unsigned int workerCount)
+	:m_workerCount(std::max(workerCount, 1u)), m_queues(std::make_unique<WorkerQueue[]>(m_workerCount))
+{
+	//The calling thread is worker 0, so only the other workers need threads.
+	for(unsigned int worker = 1; worker < m_workerCount; ++worker)
+	{
+		m_threads.emplace_back(&JobSystem::workerLoop, this, worker);
+	}
+}
+
+//JobSystem destructor; stops, and joins, the worker threads.
+JobSystem::~JobSystem()
+{
+	m_mutex.lock();
+	m_isStopping = true;
+	m_mutex.unlock();
+
+	m_wakeCondition.notify_all();
+
+	for(auto &thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+//Splits the loop between the workers, and runs it.
+//	count : How many indices there are.
+//	grainSize : How many indices are run together as a chunk.
+//	invoker : Calls the loop body on a chunk.
+//	function : The loop body.
+void JobSystem::run(std::size_t count, std::size_t grainSize, Invoker invoker, void *function)
+{
+	if(count == 0) return;
+
+	grainSize = std::max<std::size_t>(grainSize, 1);
+
+	//How many chunks the loop is split into.
+	const std::size_t chunkCount = (count + grainSize - 1) / grainSize;
+
+	//Run the loop inline if there is nobody to share it with; it is the same work, without waking any threads.
+	if(m_workerCount == 1 || chunkCount == 1)
+	{
+		invoker(function, 0, count, 0);
+		return;
+	}
+
+	//Give each worker an equal, contiguous share of the chunks; neighbouring chunks are likely to touch neighbouring memory.
+	for(unsigned int worker = 0; worker < m_workerCount; ++worker)
+	{
+		const std::uint64_t first = chunkCount * worker / m_workerCount;
+		const std::uint64_t last = chunkCount * (worker + 1) / m_workerCount;
+
+		m_queues[worker].chunks.store(first << 32 | last, std::memory_order_relaxed);
+	}
+
+	m_mutex.lock();
+
+	m_invoker = invoker;
+	m_function = function;
+	m_count = count;
+	m_grainSize = grainSize;
+	m_busyWorkers = m_workerCount - 1;
+	++m_generation;
+
+	m_mutex.unlock();
+
+	m_wakeCondition.notify_all();
+
+	//Work on the loop while the other workers do; instead of only waiting for them.
+	work(0);
+
+	//Wait for the other workers to finish their last chunk; they may still be running one after every chunk has been taken.
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [this]() { return m_busyWorkers == 0; });
+}
+
+//Waits for loops, and runs them, until the pool is stopping.
+//	worker : Index of the worker the thread runs as.
+void JobSystem::workerLoop(unsigned int worker)
+{
+	//The last loop this worker ran.
+	unsigned long generation = 0;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while(true)
+	{
+		m_wakeCondition.wait(lock, [this, generation]() { return m_isStopping || m_generation != generation; });
+
+		if(m_isStopping) return;
+
+		generation = m_generation;
+
+		lock.unlock();
+		work(worker);
+		lock.lock();
+
+		//Wake the calling thread if this was the last worker running the loop.
+		if(--m_busyWorkers == 0) m_doneCondition.notify_one();
+	}
+}
+
+//Runs chunks from the worker's own share, then steals from the other workers, until every chunk has been taken.
+//	worker : Index of the worker running the chunks.
+void JobSystem::work(unsigned int worker)
+{
+	//The chunk being run.
+	std::uint32_t chunk;
+
+	while(true)
+	{
+		//Whether a chunk was found; either in our own share, or stolen from another worker.
+		bool hasChunk = popFront(m_queues[worker], chunk);
+
+		//Steal from the other workers in turn, starting with our neighbour, so thieves spread out over the victims.
+		for(unsigned int offset = 1; !hasChunk && offset < m_workerCount; ++offset)
+		{
+			hasChunk = stealBack(m_queues[(worker + offset) % m_workerCount], chunk);
+		}
+
+		//Every chunk has been taken; no more are added while a loop runs, so the worker is done.
+		if(!hasChunk) return;
+
+		const std::size_t begin = chunk * m_grainSize;
+		m_invoker(m_function, begin, std::min(begin + m_grainSize, m_count), worker);
+	}
+}
+
+//Takes the next chunk from the front of a worker's share.
+//	queue : The share to take from.
+//	chunk : Set to the chunk taken.
+//Returns whether a chunk was taken.
+bool JobSystem::popFront(WorkerQueue &queue, std::uint32_t &chunk)
+{
+	std::uint64_t chunks = queue.chunks.load(std::memory_order_relaxed);
+
+	while(true)
+	{
+		const std::uint32_t first = static_cast<std::uint32_t>(chunks >> 32);
+		const std::uint32_t last = static_cast<std::uint32_t>(chunks);
+
+		if(first >= last) return false;
+
+		if(queue.chunks.compare_exchange_weak(chunks, std::uint64_t(first + 1) << 32 | last, std::memory_order_relaxed))
+		{
+			chunk = first;
+			return true;
+		}
+	}
+}
+
+//Takes the last chunk from the back of another worker's share.
+//	queue : The share to steal from.
+//	chunk : Set to the chunk taken.
+//Returns whether a chunk was taken.
+bool JobSystem::stealBack(WorkerQueue &queue, std::uint32_t &chunk)
+{
+	std::uint64_t chunks = queue.chunks.load(std::memory_order_relaxed);
+
+	while(true)
+	{
+		const std::uint32_t first = static_cast<std::uint32_t>(chunks >> 32);
+		const std::uint32_t last = static_cast<std::uint32_t>(chunks);
+
+		if(first >= last) return false;
+
+		if(queue.chunks.compare_exchange_weak(chunks, std::uint64_t(first) << 32 | (last - 1), std::memory_order_relaxed))
+		{
+			chunk = last - 1;
+			return true;
+		}
+	}
+}
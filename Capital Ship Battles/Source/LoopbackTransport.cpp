@@ -0,0 +1,134 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "LoopbackTransport.hpp"
+
+#include <algorithm> //For std::min.
+#include <chrono> //For waiting on the pipe.
+
+//Connects two ends to each other; dropping any connection either had.
+//	first : One end.
+//	second : The other end.
+//	impairment : How badly each link drops, and delays, what is sent over it; the same model both ways.
+//	seed : Seed of the links' random choices; the same seed gives the same losses, and delays.
+void LoopbackTransport::connect(LoopbackTransport &first, LoopbackTransport &second, const LinkImpairment &impairment, unsigned int seed)
+{
+	std::shared_ptr<Pipe> pipe = std::make_shared<Pipe>();
+
+	for(unsigned int i = 0; i < 2; ++i)
+	{
+		//Each way is seeded differently; so the two ends do not lose the same datagrams.
+		pipe->links[i] = ImpairedLink(seed + i);
+		pipe->links[i].setImpairment(impairment);
+	}
+
+	first.m_pipe = pipe;
+	first.m_end = 0;
+	first.open();
+
+	second.m_pipe = pipe;
+	second.m_end = 1;
+	second.open();
+}
+
+//Returns whether the end is connected; it is connected when created, so there is nothing to wait for.
+//	port : Unused.
+bool LoopbackTransport::host(unsigned short)
+{
+	return isConnected();
+}
+
+//Returns whether the end is connected; it is connected when created, so there is nothing to reach.
+//	address : Unused.
+//	port : Unused.
+bool LoopbackTransport::join(const sf::IpAddress&, unsigned short)
+{
+	return isConnected();
+}
+
+//Closes the pipe; both ends notice at once. Safe to call from any thread.
+void LoopbackTransport::disconnect()
+{
+	ChannelTransport::disconnect();
+
+	if(!m_pipe) return;
+
+	m_pipe->mutex.lock();
+
+	m_pipe->isOpen = false;
+
+	m_pipe->mutex.unlock();
+
+	m_pipe->arrived.notify_all();
+}
+
+//Returns whether the peer is still connected.
+bool LoopbackTransport::isConnected() const
+{
+	if(!m_pipe || !ChannelTransport::isConnected()) return false;
+
+	m_pipe->mutex.lock();
+
+	const bool isOpen = m_pipe->isOpen;
+
+	m_pipe->mutex.unlock();
+
+	return isOpen;
+}
+
+//Sends a datagram over the link to the other end.
+//	datagram : The bytes of the datagram.
+void LoopbackTransport::sendDatagram(std::vector<std::uint8_t> datagram)
+{
+	m_pipe->mutex.lock();
+
+	m_pipe->links[m_end].send(std::move(datagram), m_pipe->clock.getElapsedTime());
+
+	m_pipe->mutex.unlock();
+
+	m_pipe->arrived.notify_all();
+}
+
+//Waits, at most the timeout, for a datagram from the other end to be due.
+//	timeout : The longest to wait.
+//Returns whether a datagram is due.
+bool LoopbackTransport::waitForDatagram(const sf::Time &timeout)
+{
+	std::unique_lock<std::mutex> lock(m_pipe->mutex);
+
+	//The link the other end sends on.
+	const ImpairedLink &incoming = m_pipe->links[1 - m_end];
+	//When to stop waiting.
+	const sf::Time deadline = m_pipe->clock.getElapsedTime() + timeout;
+	//When the datagram due soonest is due.
+	sf::Time due;
+
+	while(m_pipe->isOpen)
+	{
+		const sf::Time now = m_pipe->clock.getElapsedTime();
+		const bool isHeld = incoming.getNextDue(due);
+
+		if(isHeld && due <= now) return true;
+		if(now >= deadline) return false;
+
+		//Sleep until the next datagram is due, or the deadline; whichever is first. Sending one sooner wakes us early.
+		const sf::Time wake = isHeld ? std::min(due, deadline) : deadline;
+		m_pipe->arrived.wait_for(lock, std::chrono::microseconds((wake - now).asMicroseconds()));
+	}
+
+	return false;
+}
+
+//Takes the next datagram due from the other end, without waiting.
+//	datagram : Set to the bytes of the datagram.
+//Returns whether there was a datagram.
+bool LoopbackTransport::receiveDatagram(std::vector<std::uint8_t> &datagram)
+{
+	m_pipe->mutex.lock();
+
+	const bool isDue = m_pipe->links[1 - m_end].takeDue(m_pipe->clock.getElapsedTime(), datagram);
+
+	m_pipe->mutex.unlock();
+
+	return isDue;
+}
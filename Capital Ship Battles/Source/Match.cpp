@@ -0,0 +1,279 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "Match.hpp"
+
+#include <algorithm> //For std::stable_sort.
+
+#include "CSB_Functions.hpp" //For the game's default tick.
+#include "NetworkManager.hpp" //For the types of message.
+#include "WireFormat.hpp" //For encoding, and decoding, the messages.
+
+namespace
+{
+	const sf::Time TICK_LENGTH = CSB::tickLength(CSB::DEFAULT_TICK_RATE); //The fixed tick every match runs at; the game's default.
+}
+
+//Basic Match constructor.
+//	hullKey : Pristine collision key of the hull every ship is built from; must outlive the match.
+//	inputDelay : How many ticks after a command is given it is carried out; at least one.
+//	startTime : When the match starts, by the server's clock; its first tick is due then.
+Match::Match(const DamageMask &hullKey, unsigned int inputDelay, const sf::Time &startTime)
+	:m_simulation(hullKey), m_inputDelay(std::max(inputDelay, 1u)), m_nextTickTime(startTime)
+{}
+
+//Returns the first message sent to a player; the version of the wire format, their seat, the lockstep settings, and the tick length.
+//	seat : The player's seat; 0 plays as the host, and 1 as the joining player.
+std::vector<std::uint8_t> Match::createMatchMessage(unsigned int seat) const
+{
+	WireWriter writer;
+	writer.writeByte(static_cast<std::uint8_t>(PacketType::MATCH));
+	writer.writeVarint(Wire::VERSION);
+	writer.writeVarint(seat);
+	//Matches are always played in lockstep; the server could not follow the battle otherwise.
+	writer.writeByte(1);
+	writer.writeVarint(m_inputDelay);
+	//The player must run the same ticks as the match; they are refused if they do not.
+	writer.writeVarint(TICK_LENGTH.asMicroseconds());
+
+	return writer.getBytes();
+}
+
+//Queues a message from a player, to be handled on the next run; only call while the match is not running.
+//	seat : The seat of the player that sent it.
+//	message : The bytes of the message; their handshake, then each flush of frames.
+void Match::queueMessage(unsigned int seat, std::vector<std::uint8_t> message)
+{
+	m_seats[seat].inbox.push_back(std::move(message));
+}
+
+//Handles the queued messages, then runs every tick that is due; at most MAX_TICKS_PER_RUN, so no match holds up the others for long.
+//	now : The time by the server's clock.
+//Returns how many ticks were run.
+unsigned int Match::run(const sf::Time &now)
+{
+	for(unsigned int seat = 0; seat < 2 && !m_isRejected; ++seat)
+	{
+		for(const auto &message : m_seats[seat].inbox)
+		{
+			//Decodes the message's bytes in the wire format.
+			WireReader reader(message.data(), message.size());
+
+			if(m_seats[seat].hasHandshake ? !receiveFrames(seat, reader) : !(m_seats[seat].hasHandshake = receiveHandshake(seat, reader)))
+			{
+				m_isRejected = true;
+				break;
+			}
+		}
+
+		m_seats[seat].inbox.clear();
+	}
+
+	//The players pace the battle; time spent waiting on them is not caught up on afterwards, as they will not have run ahead either.
+	if(m_isWaitingOnPlayers && canTick()) m_nextTickTime = std::max(m_nextTickTime, now);
+
+	//How many ticks have been run.
+	unsigned int ticksRun = 0;
+
+	for(; ticksRun < MAX_TICKS_PER_RUN && !m_isRejected && canTick() && m_nextTickTime <= now; ++ticksRun)
+	{
+		m_lastLateness = now - m_nextTickTime;
+
+		tick();
+
+		m_nextTickTime += TICK_LENGTH;
+	}
+
+	m_isWaitingOnPlayers = !canTick();
+
+	return ticksRun;
+}
+
+//Returns whether the match needs running; it has messages waiting, or a tick is due.
+//	now : The time by the server's clock.
+bool Match::isDue(const sf::Time &now) const
+{
+	if(m_isRejected) return false;
+
+	//When the next tick is due.
+	sf::Time tickTime;
+
+	return !m_seats[0].inbox.empty() || !m_seats[1].inbox.empty() || (getNextTickTime(tickTime) && tickTime <= now);
+}
+
+//Returns when the next tick is due, if both players have marked it done; otherwise, the match waits on the players.
+//	time : Set to when the next tick is due.
+//Returns whether the next tick can run, once it is due.
+bool Match::getNextTickTime(sf::Time &time) const
+{
+	time = m_nextTickTime;
+
+	return !m_isRejected && canTick();
+}
+
+//Returns the seat of the player whose ship survived; only meaningful once the battle is finished.
+unsigned int Match::getWinner() const
+{
+	return m_simulation.getShips(0).empty() ? 1 : 0;
+}
+
+//Handles the handshake; the first message from a player.
+//	seat : The seat of the player.
+//	reader : Reads the message.
+//Returns whether the handshake was accepted.
+bool Match::receiveHandshake(unsigned int seat, WireReader &reader)
+{
+	//Refuse a player sending another version of the format, as we would misread everything they send.
+	if(static_cast<PacketType>(reader.readByte()) != PacketType::CONNECT || reader.readVarint() != Wire::VERSION) return false;
+
+	//Refuse a player with other settings than the match's too; they would be out of sync with the server, and the other player.
+	const bool isLockstep = reader.readByte() != 0;
+	const std::uint64_t inputDelay = reader.readVarint();
+	const std::uint64_t tickLength = reader.readVarint();
+
+	if(!isLockstep || inputDelay != m_inputDelay || tickLength != static_cast<std::uint64_t>(TICK_LENGTH.asMicroseconds())) return false;
+
+	//The player's ship; both ships are created at the first tick, as the players create them.
+	BattleCommand ship;
+	ship.type = CommandType::CREATE_SHIP;
+	ship.shipLayer = seat;
+	ship.tick = 0;
+	reader.readCommand(ship);
+
+	if(!reader.isValid()) return false;
+
+	m_pendingCommands.push_back(std::move(ship));
+
+	//Every command is stamped at least the input delay ahead; so with the ship received, every tick before the delay is done.
+	m_seats[seat].confirmedTick = std::max<std::int64_t>(m_seats[seat].confirmedTick, m_inputDelay - 1);
+
+	return true;
+}
+
+//Handles every frame in a message from a player.
+//	seat : The seat of the player.
+//	reader : Reads the message.
+//Returns whether every frame was well-formed, and stamped within MAX_FRAME_LEAD ticks of the match.
+bool Match::receiveFrames(unsigned int seat, WireReader &reader)
+{
+	while(reader.isValid() && !reader.isAtEnd())
+	{
+		//The tick the frame was closed at, as sent.
+		const std::uint64_t frameTick = reader.readVarint();
+
+		//Refuse a frame stamped far past the match; its commands, and hash, would be held until a tick that may never come.
+		if(frameTick > m_simulation.getTick() + static_cast<std::uint64_t>(MAX_FRAME_LEAD)) return false;
+
+		//The tick the frame was closed at.
+		const std::uint32_t tick = static_cast<std::uint32_t>(frameTick);
+		//How many messages the frame holds.
+		const std::uint64_t messageCount = reader.readVarint();
+
+		for(std::uint64_t i = 0; i < messageCount && reader.isValid(); ++i)
+		{
+			//The command the message carries; for the player's ship, at the frame's tick plus the delay.
+			BattleCommand command;
+			command.shipLayer = seat;
+			command.tick = tick + m_inputDelay;
+
+			//The type of message we received.
+			PacketType receivedType = static_cast<PacketType>(reader.readByte());
+			//The hash a state hash message carries.
+			std::uint64_t hash;
+
+			switch(receivedType)
+			{
+				//Move the player's ship, or order it to fire on the other player's.
+				case PacketType::MOVE:
+				case PacketType::FIRE:
+					command.type = receivedType == PacketType::FIRE ? CommandType::FIRE : CommandType::MOVE;
+					command.targetLayer = 1 - seat;
+					reader.readCommand(command);
+
+					if(reader.isValid()) m_pendingCommands.push_back(std::move(command));
+
+					break;
+				//The hash of the player's battle at the end of the frame's tick; to check it against our own.
+				case PacketType::STATE_HASH:
+					hash = reader.readUint64();
+
+					if(reader.isValid()) m_seats[seat].pendingHashes.push_back({tick, hash});
+
+					break;
+				//The player is leaving; the server notices when their connection closes.
+				case PacketType::DISCONNECT:
+					break;
+				//Any other type means the frame is malformed, as its length is unknown.
+				default:
+					return false;
+			}
+		}
+
+		//The frame marks every command the player gives for the tick the delay ahead, and those before it, as sent.
+		if(reader.isValid()) m_seats[seat].confirmedTick = std::max<std::int64_t>(m_seats[seat].confirmedTick, tick + m_inputDelay);
+	}
+
+	return reader.isValid();
+}
+
+//Returns whether both players have marked the next tick done.
+bool Match::canTick() const
+{
+	//The tick run next.
+	const std::int64_t tick = m_simulation.getTick();
+
+	return !m_simulation.isFinished() && m_seats[0].confirmedTick >= tick && m_seats[1].confirmedTick >= tick;
+}
+
+//Applies the commands for the next tick, runs it, and checks the players' hashes against it.
+void Match::tick()
+{
+	//The tick being run.
+	const std::uint32_t tick = m_simulation.getTick();
+
+	//Order the commands by tick, then layer, keeping the order they arrived in for the same ship; as both players order them.
+	std::stable_sort(m_pendingCommands.begin(), m_pendingCommands.end(), [](const BattleCommand &lhs, const BattleCommand &rhs)
+	{
+		return lhs.tick < rhs.tick || (lhs.tick == rhs.tick && lhs.shipLayer < rhs.shipLayer);
+	});
+
+	//The first command stamped for a later tick; it, and every command after it, waits for its tick.
+	auto due = m_pendingCommands.begin();
+
+	for(; due != m_pendingCommands.end() && due->tick <= tick; ++due)
+	{
+		m_simulation.applyCommand(*due);
+	}
+
+	m_pendingCommands.erase(m_pendingCommands.begin(), due);
+
+	m_simulation.update(TICK_LENGTH);
+
+	m_hashes[tick % HASH_HISTORY] = {tick, m_simulation.getStateHash()};
+
+	checkStateHashes();
+}
+
+//Checks the players' hashes of the ticks the match has run against its own.
+void Match::checkStateHashes()
+{
+	for(Seat &seat : m_seats)
+	{
+		for(auto remote = seat.pendingHashes.begin(); remote != seat.pendingHashes.end();)
+		{
+			//Keep the hashes of ticks we have not run yet, until we have.
+			if(remote->tick >= m_simulation.getTick())
+			{
+				++remote;
+				continue;
+			}
+
+			//Our hash of the same tick; unless it is too old to have been kept.
+			const TickHash &local = m_hashes[remote->tick % HASH_HISTORY];
+
+			if(local.tick == remote->tick && local.hash != remote->hash) seat.isDesynced = true;
+
+			remote = seat.pendingHashes.erase(remote);
+		}
+	}
+}
@@ -0,0 +1,353 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "MatchServer.hpp"
+
+#include <algorithm> //For std::min, std::max, and std::remove.
+#include <iostream> //For the log.
+
+namespace
+{
+	const sf::Time IDLE_WAIT = sf::milliseconds(100); //The longest the server waits on its sockets; so reports are not held up when idle.
+	const sf::Time SEND_RETRY_WAIT = sf::milliseconds(1); //How long the server waits before retrying a send the socket would not take.
+	//The shortest the server waits on its sockets; a selector waits forever on a time of zero.
+	const sf::Time MIN_WAIT = sf::microseconds(100);
+	const sf::Time REPORT_INTERVAL = sf::seconds(10); //How often the server reports what it has done.
+}
+
+//Basic MatchServer constructor.
+//	hullKey : Pristine collision key of the hull every ship is built from; must outlive the server.
+//	workerCount : How many workers run the matches, including the server's thread; at least one.
+//	matchesPerWorker : How many matches each worker is expected to keep up with; the server hosts at most this many per worker.
+//	inputDelay : How many ticks after a command is given it is carried out, in every match.
+MatchServer::MatchServer(const DamageMask &hullKey, unsigned int workerCount, unsigned int matchesPerWorker, unsigned int inputDelay)
+	:m_hullKey(hullKey), m_inputDelay(inputDelay), m_jobs(workerCount),
+	m_matchCapacity(static_cast<std::size_t>(std::max(matchesPerWorker, 1u)) * m_jobs.getWorkerCount())
+{}
+
+//Starts listening for players on the port.
+//	port : The port to listen on.
+//Returns whether the server could listen on the port.
+bool MatchServer::listen(unsigned short port)
+{
+	if(m_listener.listen(port) != sf::Socket::Done) return false;
+
+	//Accept every player waiting whenever the selector wakes, without blocking on the next.
+	m_listener.setBlocking(false);
+	m_selector.add(m_listener);
+
+	return true;
+}
+
+//Runs the server; accepting players, pairing them into matches, and running the matches.
+//	duration : How long to run for; zero to run until the process is stopped.
+void MatchServer::run(const sf::Time &duration)
+{
+	//When to stop, if the server only runs for a while.
+	const sf::Time endTime = m_clock.getElapsedTime() + duration;
+
+	m_nextReportTime = m_clock.getElapsedTime() + REPORT_INTERVAL;
+
+	while(duration == sf::Time::Zero || m_clock.getElapsedTime() < endTime)
+	{
+		//Wake when a player joins, or sends something; or when the soonest match is due.
+		if(m_selector.wait(getWaitTime()))
+		{
+			if(m_selector.isReady(m_listener)) acceptPlayers();
+
+			for(auto &player : m_players)
+			{
+				if(m_selector.isReady(player->socket)) receiveFrom(*player);
+			}
+		}
+
+		//Retry whatever the sockets would not take last time.
+		for(auto &player : m_players)
+		{
+			if(!player->outgoing.empty()) flush(*player);
+		}
+
+		closeMatches();
+		pairPlayers();
+		runMatches();
+		report(false);
+	}
+
+	report(true);
+}
+
+//Accepts every player waiting to join, and puts them in the lobby.
+void MatchServer::acceptPlayers()
+{
+	while(true)
+	{
+		std::unique_ptr<Player> player = std::make_unique<Player>();
+
+		if(m_listener.accept(player->socket) != sf::Socket::Done) return;
+
+		//So a player that is slow to read can not hold up every other player.
+		player->socket.setBlocking(false);
+		m_selector.add(player->socket);
+
+		std::cout << "Player joined from " << player->socket.getRemoteAddress().toString() << "; " << m_lobby.size() + 1 << " waiting"
+			<< std::endl;
+
+		m_lobby.push_back(player.get());
+		m_players.push_back(std::move(player));
+	}
+}
+
+//Receives every packet the player has sent; relaying each to the other player in their match, and queuing it on the match.
+//	player : The player.
+void MatchServer::receiveFrom(Player &player)
+{
+	//Holds data of most recently received packet.
+	sf::Packet packet;
+
+	while(true)
+	{
+		//What became of the receive.
+		const sf::Socket::Status status = player.socket.receive(packet);
+
+		if(status == sf::Socket::NotReady || status == sf::Socket::Partial) return;
+
+		//A player in the lobby has nothing to send yet; so anything else than a whole packet in a match means they have gone.
+		if(status != sf::Socket::Done || !player.match)
+		{
+			player.isClosed = true;
+			return;
+		}
+
+		//The other player in the match.
+		Player &other = *player.match->players[1 - player.seat];
+
+		if(!other.isClosed) sendTo(other, packet);
+
+		const std::uint8_t *data = static_cast<const std::uint8_t*>(packet.getData());
+		player.match->match->queueMessage(player.seat, std::vector<std::uint8_t>(data, data + packet.getDataSize()));
+	}
+}
+
+//Queues a packet to send to a player, and sends as much of their queue as the socket takes;
+//a player whose queue would grow past MAX_OUTGOING_BYTES is disconnected instead.
+//	player : The player to send to.
+//	packet : The packet to send.
+void MatchServer::sendTo(Player &player, const sf::Packet &packet)
+{
+	//A player this far behind is not reading what is sent to them; holding on to it all would let them run the server out of memory.
+	if(player.outgoingBytes + packet.getDataSize() > MAX_OUTGOING_BYTES)
+	{
+		std::cout << "Player at " << player.socket.getRemoteAddress().toString() << " has " << player.outgoingBytes
+			<< " bytes waiting to be sent; disconnecting" << std::endl;
+
+		player.isClosed = true;
+		return;
+	}
+
+	player.outgoing.push_back(packet);
+	player.outgoingBytes += packet.getDataSize();
+
+	flush(player);
+}
+
+//Sends as much of the player's queued packets as the socket takes, without waiting.
+//	player : The player to send to.
+void MatchServer::flush(Player &player)
+{
+	while(!player.outgoing.empty())
+	{
+		//What became of the send; a packet that was partly sent remembers how much, so the same packet is sent again.
+		const sf::Socket::Status status = player.socket.send(player.outgoing.front());
+
+		if(status == sf::Socket::NotReady || status == sf::Socket::Partial) return;
+
+		if(status != sf::Socket::Done)
+		{
+			player.isClosed = true;
+			return;
+		}
+
+		player.outgoingBytes -= player.outgoing.front().getDataSize();
+		player.outgoing.pop_front();
+	}
+}
+
+//Pairs the players in the lobby into matches, in the order they joined; while there is room for another match.
+void MatchServer::pairPlayers()
+{
+	while(m_lobby.size() >= 2 && m_matches.size() < m_matchCapacity)
+	{
+		std::unique_ptr<HostedMatch> hosted = std::make_unique<HostedMatch>();
+		hosted->match = std::make_unique<Match>(m_hullKey, m_inputDelay, m_clock.getElapsedTime());
+		hosted->id = m_nextMatchId++;
+
+		//The player who has waited longest plays as the host.
+		for(unsigned int seat = 0; seat < 2; ++seat)
+		{
+			Player *player = m_lobby.front();
+			m_lobby.pop_front();
+
+			player->match = hosted.get();
+			player->seat = seat;
+			hosted->players[seat] = player;
+
+			//Tell the player their seat; the battle starts once they have it.
+			const std::vector<std::uint8_t> message = hosted->match->createMatchMessage(seat);
+			sf::Packet packet;
+			packet.append(message.data(), message.size());
+
+			sendTo(*player, packet);
+		}
+
+		std::cout << "Match " << hosted->id << " started; " << m_matches.size() + 1 << " of " << m_matchCapacity << " running" << std::endl;
+
+		m_matches.push_back(std::move(hosted));
+	}
+}
+
+//Runs every match that is due on the workers, then logs anything that happened in them.
+void MatchServer::runMatches()
+{
+	//Every match in the batch is run up to the same time.
+	const sf::Time now = m_clock.getElapsedTime();
+
+	m_dueMatches.clear();
+
+	for(auto &hosted : m_matches)
+	{
+		if(hosted->match->isDue(now)) m_dueMatches.push_back(hosted.get());
+	}
+
+	if(m_dueMatches.empty()) return;
+
+	//One match to a chunk; matches take very different times, as some are idle and others mid-fight, so the workers steal the rest.
+	m_jobs.parallelFor(m_dueMatches.size(), 1, [this, &now](std::size_t begin, std::size_t end, unsigned int)
+	{
+		for(std::size_t i = begin; i < end; ++i)
+		{
+			m_dueMatches[i]->ticksRun = m_dueMatches[i]->match->run(now);
+		}
+	});
+
+	//How long the batch took.
+	const sf::Time batchTime = m_clock.getElapsedTime() - now;
+
+	++m_stats.batches;
+	m_stats.batchTime += batchTime;
+	m_stats.longestBatch = std::max(m_stats.longestBatch, batchTime);
+
+	for(HostedMatch *hosted : m_dueMatches)
+	{
+		const Match &match = *hosted->match;
+
+		if(hosted->ticksRun == 0) continue;
+
+		m_stats.ticks += hosted->ticksRun;
+		m_stats.latestTick = std::max(m_stats.latestTick, match.getLastLateness());
+
+		for(unsigned int seat = 0; seat < 2; ++seat)
+		{
+			if(match.isDesynced(seat) && !hosted->isDesyncReported[seat])
+			{
+				hosted->isDesyncReported[seat] = true;
+
+				std::cout << "Match " << hosted->id << ": player " << seat << " is out of sync with the server, by tick " << match.getTick()
+					<< std::endl;
+			}
+		}
+
+		if(match.isFinished() && !hosted->isFinishReported)
+		{
+			hosted->isFinishReported = true;
+
+			std::cout << "Match " << hosted->id << " finished at tick " << match.getTick() << "; player " << match.getWinner() << " won" << std::endl;
+		}
+	}
+}
+
+//Ends every match a player has left, or that was rejected; disconnecting both players. Then drops every player that has left.
+void MatchServer::closeMatches()
+{
+	for(auto hosted = m_matches.begin(); hosted != m_matches.end();)
+	{
+		const HostedMatch &match = **hosted;
+
+		if(!match.players[0]->isClosed && !match.players[1]->isClosed && !match.match->isRejected())
+		{
+			++hosted;
+			continue;
+		}
+
+		std::cout << "Match " << match.id << " closed at tick " << match.match->getTick()
+			<< (match.match->isRejected() ? "; a player sent something it could not accept" : "") << std::endl;
+
+		//Neither player can go on without the other.
+		match.players[0]->isClosed = true;
+		match.players[1]->isClosed = true;
+
+		hosted = m_matches.erase(hosted);
+	}
+
+	//Players who left the lobby, before they were paired.
+	m_lobby.erase(std::remove_if(m_lobby.begin(), m_lobby.end(), [](const Player *player)
+	{
+		return player->isClosed;
+	}), m_lobby.end());
+
+	for(auto player = m_players.begin(); player != m_players.end();)
+	{
+		if(!(*player)->isClosed)
+		{
+			++player;
+			continue;
+		}
+
+		m_selector.remove((*player)->socket);
+		(*player)->socket.disconnect();
+
+		player = m_players.erase(player);
+	}
+}
+
+//Returns how long the server may wait for a socket before a match is due.
+sf::Time MatchServer::getWaitTime() const
+{
+	//The time by the server's clock.
+	const sf::Time now = m_clock.getElapsedTime();
+	//How long until the soonest match is due.
+	sf::Time wait = IDLE_WAIT;
+	//When a match's next tick is due.
+	sf::Time tickTime;
+
+	for(const auto &hosted : m_matches)
+	{
+		//A match that waits on its players is woken by what they send.
+		if(hosted->match->getNextTickTime(tickTime)) wait = std::min(wait, tickTime - now);
+	}
+
+	for(const auto &player : m_players)
+	{
+		if(!player->outgoing.empty()) wait = std::min(wait, SEND_RETRY_WAIT);
+	}
+
+	return std::max(wait, MIN_WAIT);
+}
+
+//Reports what the server has done since the last report, if a report is due.
+//	isForced : Whether to report even if it is not due yet.
+void MatchServer::report(bool isForced)
+{
+	if(!isForced && m_clock.getElapsedTime() < m_nextReportTime) return;
+
+	m_nextReportTime = m_clock.getElapsedTime() + REPORT_INTERVAL;
+
+	//How long a batch took on average, in milliseconds.
+	const double meanBatch = m_stats.batches > 0 ? m_stats.batchTime.asMicroseconds() / 1000.0 / m_stats.batches : 0;
+
+	std::cout << m_matches.size() << " of " << m_matchCapacity << " matches running, " << m_lobby.size() << " waiting; "
+		<< m_stats.ticks << " ticks in " << m_stats.batches << " batches, mean batch " << meanBatch << " ms, longest "
+		<< m_stats.longestBatch.asMicroseconds() / 1000.0 << " ms; latest tick " << m_stats.latestTick.asMicroseconds() / 1000.0
+		<< " ms behind" << std::endl;
+
+	m_stats = Stats();
+}
@@ -3,7 +3,33 @@
  */
 #include "NetworkManager.hpp"
 
-#include <BattleState.hpp> //For sending information to the battle we are networking.
+#include <algorithm> //For std::max.
+#include <cstdint> //For UINT32_MAX.
+#include <iostream> //For reporting a peer of another version, or of other settings.
+#include <sstream> //For describing the settings of a peer.
+
+#include "BattleSession.hpp" //For sending information to the battle we are networking.
+
+namespace
+{
+	const sf::Time MATCH_POLL_INTERVAL = sf::milliseconds(250); //How often waiting for a match checks whether the connection was closed.
+
+	//Returns the settings a peer plays with, as text; for reporting a peer whose settings differ.
+	//	isLockstep : Whether the peer networks battles in lockstep.
+	//	inputDelay : How many ticks after a command is given it is carried out, in lockstep.
+	//	tickLength : How long each tick lasts, in microseconds.
+	std::string describeSettings(bool isLockstep, std::uint64_t inputDelay, std::uint64_t tickLength)
+	{
+		std::ostringstream description;
+
+		if(isLockstep) description << "in lockstep with an input delay of " << inputDelay << " ticks";
+		else description << "without lockstep";
+
+		description << ", at " << tickLength << " us a tick";
+
+		return description.str();
+	}
+}
 
 //Listens for a client attempting to join on the local user.
 //Returns whether a server was successfully set up.
@@ -11,12 +37,7 @@ bool NetworkManager::hostServer()
 {
 	m_isHost = true;
 
-	//Listen on the defined port.
-	m_listener.listen(PORT);
-
-	//Accept the next client to connect to the server.
-	//If the socket is "Done", then it managed to gain a client.
-	return m_listener.accept(m_socket) == sf::Socket::Done;
+	return m_transport->host(PORT);
 }
 
 //Attempt to join a server on the passed IP; non-blocking so it may be interrupted.
@@ -26,76 +47,170 @@ bool NetworkManager::joinServer(const std::string &rawIP)
 {
 	m_isHost = false;
 
-	//Attempt to connect to the passed IP; with a five second time-out.
-	return m_socket.connect(sf::IpAddress(rawIP), PORT, sf::seconds(5)) == sf::Socket::Done;
+	const sf::IpAddress address(rawIP);
+
+	if(address == sf::IpAddress::None || !m_transport->join(address, PORT)) return false;
+
+	//A dedicated server is not the other player; the battle can only start once it has paired us with one.
+	return !m_isDedicatedServer || waitForMatch();
 }
 
 //Stops any connections, and any attempts to connect to another user.
 void NetworkManager::closeAllConnections()
 {
-	//Stops any connection attempts.
-	m_listener.close();
-	//Close current connection.
-	m_socket.disconnect();
+	m_transport->disconnect();
+
+	//Drop anything left unsent, so it is not sent to the next peer.
+	m_openFrame.clear();
+	m_openMessageCount = 0;
+
+	m_frameMutex.lock();
+
+	m_handshake.clear();
+	m_closedFrames.clear();
+
+	m_frameMutex.unlock();
 }
 
-//Handles receiving of packets from the peer; the main loop of the network manager.
+//Handles receiving of packets from the peer, and flushing closed frames to them; the main loop of the network manager.
 void NetworkManager::receive()
 {
-	//Holds data of most recently received packet.
-	sf::Packet packet;
-	//Listen for and handle packets, while they are still being sent.
-	while(m_socket.receive(packet) == sf::Socket::Done)
-	{
-		//Packet type as raw value, as sf::Packet can not store enum classes.
-		std::underlying_type_t<PacketType> rawPacketType;
-		//Identifying number of the ship.
-		unsigned int shipID;
-		//Global position of the information; i.e. where to move to, or where to shoot at.
-		sf::Vector2f globalPosition;
+	//Most recently received message.
+	std::vector<std::uint8_t> message;
+	//Whether the peer's handshake has been received; every message after it is a flush of frames.
+	bool hasHandshake = false;
 
-		//Unpackage the packet type from the packet.
-		packet >> rawPacketType;
-
-		//The type of packet we received.
-		PacketType receivedType = static_cast<PacketType>(rawPacketType);
-
-		switch(receivedType)
+	//Wake when something arrives; or after the flush latency, to flush the closed frames. Until either user disconnects.
+	while(m_transport->wait(m_flushLatency))
+	{
+		while(m_transport->receive(message))
 		{
-			//Unpackage the ship we received if it was a connection packet.
-			case PacketType::CONNECT:
-				unpackageShip(packet);
-
-				break;
-			//Disconnect from the server, if the peer disconnected.
-			case PacketType::DISCONNECT:
-				m_socket.disconnect();
-
-				break;
-			//Move the enemy ship.
-			case PacketType::MOVE:
-				packet >> shipID;
-				packet >> globalPosition.x;
-				packet >> globalPosition.y;
-				m_battle->issueMoveCommand(1, shipID, globalPosition);
-
-				break;
-			//Order the enemy ship to fire on the target.
-			case PacketType::FIRE:
-				packet >> shipID;
-				packet >> globalPosition.x;
-				packet >> globalPosition.y;
-				m_battle->issueFireCommand(1, shipID, globalPosition, 0);
-
-				break;
+			//Decodes the message's bytes in the wire format.
+			WireReader reader(message.data(), message.size());
+
+			if(hasHandshake)
+			{
+				receiveFrames(reader);
+			}
+			//Refuse a peer whose handshake is not accepted; the transport then reports it disconnected, ending the loop.
+			else if(!(hasHandshake = receiveHandshake(reader)))
+			{
+				m_transport->disconnect();
+			}
 		}
+
+		flush();
 	}
+
+	//The peer has gone, so it will never mark another tick; let the battle carry on without it, rather than wait forever.
+	if(m_isLockstep) m_battle->confirmRemoteTick(UINT32_MAX);
 }
 
-//Send a packet to the other user.
-void NetworkManager::send(sf::Packet packet)
+//Adds a move, or fire, command given to the local player's ship to the frame being built.
+//	command : The command given; stamped with the tick the frame will be closed at, plus the input delay in lockstep.
+void NetworkManager::sendCommand(const BattleCommand &command)
 {
-	m_socket.send(packet);
+	m_openFrame.writeByte(static_cast<std::uint8_t>(command.type == CommandType::FIRE ? PacketType::FIRE : PacketType::MOVE));
+	//The command's tick is not written; the peer takes it from the frame's tick.
+	m_openFrame.writeCommand(command);
+	++m_openMessageCount;
+}
+
+//Adds the hash of the battle's state at the end of the tick the frame will be closed at to the frame being built; only used in lockstep.
+//	hash : The hash of the battle's state.
+void NetworkManager::sendStateHash(std::uint64_t hash)
+{
+	m_openFrame.writeByte(static_cast<std::uint8_t>(PacketType::STATE_HASH));
+	m_openFrame.writeUint64(hash);
+	++m_openMessageCount;
+}
+
+//Closes the frame being built, to be flushed by the network thread; called after each tick runs.
+//Without lockstep, a frame with no messages is dropped; in lockstep, every frame is sent, as it marks the tick done.
+//	tick : The tick that just ran; the frame is stamped with it.
+void NetworkManager::closeFrame(std::uint32_t tick)
+{
+	if(m_openMessageCount == 0 && !m_isLockstep) return;
+
+	//The frame's header; its tick, and how many messages follow.
+	WireWriter header;
+	header.writeVarint(tick);
+	header.writeVarint(m_openMessageCount);
+
+	m_frameMutex.lock();
+
+	m_closedFrames.insert(m_closedFrames.end(), header.getBytes().begin(), header.getBytes().end());
+	m_closedFrames.insert(m_closedFrames.end(), m_openFrame.getBytes().begin(), m_openFrame.getBytes().end());
+
+	m_frameMutex.unlock();
+
+	m_openFrame.clear();
+	m_openMessageCount = 0;
+}
+
+//Sets whether battles are networked in lockstep; both players must use the same settings. Only call before a battle starts.
+//	isLockstep : Whether battles are networked in lockstep.
+//	inputDelay : How many ticks after a command is given it is carried out; long enough for it to reach the other user.
+void NetworkManager::setLockstep(bool isLockstep, unsigned int inputDelay)
+{
+	m_isLockstep = isLockstep;
+	//At least one tick, as a command can not be carried out at a tick that has already been marked done.
+	m_inputDelay = std::max(inputDelay, 1u);
+}
+
+//Sets how long each tick lasts; both players must use the same. Only call before a battle starts.
+//	tickLength : How long each tick lasts.
+void NetworkManager::setTickLength(const sf::Time &tickLength)
+{
+	m_tickLength = tickLength;
+}
+
+//Sets how long a closed frame may wait for the network thread to flush it; at least a millisecond. Only call before a battle starts.
+//	flushLatency : The longest a closed frame waits to be sent.
+void NetworkManager::setFlushLatency(const sf::Time &flushLatency)
+{
+	//A selector waits forever on a time of zero, so the network thread would never flush while the peer is quiet.
+	m_flushLatency = std::max(flushLatency, sf::milliseconds(1));
+}
+
+//Sets whether the operating system may hold back small sends to merge them; off by default, as frames are already batched.
+//Applied to the next connection.
+//	isNagleEnabled : Whether Nagle's algorithm is enabled.
+void NetworkManager::setNagleEnabled(bool isNagleEnabled)
+{
+	m_tcpTransport.setNagleEnabled(isNagleEnabled);
+}
+
+//Sets whether to connect over UDP, rather than TCP; both players must use the same transport. Only call while not connected.
+//	isUdpEnabled : Whether to connect over UDP.
+void NetworkManager::setUdpEnabled(bool isUdpEnabled)
+{
+	m_transport = isUdpEnabled ? static_cast<Transport*>(&m_udpTransport) : &m_tcpTransport;
+}
+
+//Sets how badly what is sent over UDP is dropped, and delayed, before it reaches the socket; for testing. Only call while not connected.
+//	impairment : The model to impair datagrams by.
+void NetworkManager::setImpairment(const LinkImpairment &impairment)
+{
+	m_udpTransport.setImpairment(impairment);
+}
+
+//Uses a transport that is already connected, in place of hosting, or joining; i.e. one end of a LoopbackTransport pair.
+//Only call while not connected; the transport must outlive the battle.
+//	transport : The connected transport.
+//	isHost : Whether the local player is taken as the host.
+void NetworkManager::useTransport(Transport &transport, bool isHost)
+{
+	m_transport = &transport;
+	m_isHost = isHost;
+}
+
+//Sets whether joining connects to a dedicated server, which pairs the player with another, rather than to another player.
+//The server decides who plays as the host, and the lockstep settings; so they replace any set here. Only call while not connected.
+//	isDedicatedServer : Whether joining connects to a dedicated server.
+void NetworkManager::setDedicatedServer(bool isDedicatedServer)
+{
+	m_isDedicatedServer = isDedicatedServer;
 }
 
 //Sets the turret list of the ship built by the local player.
@@ -107,89 +222,222 @@ void NetworkManager::setTurretList(const std::vector<TurretInfo>& shipTurrets)
 
 //Sets the battle to the passed value.
 //	newBattle : The battle we want the network manager to handle the networking for.
-void NetworkManager::setBattle(BattleState *newBattle)
+void NetworkManager::setBattle(BattleSession *newBattle)
 {
 	m_battle = newBattle;
 }
 
-//Sends the ship built by the local user to the other user.
+//Sends the ship built by the local user to the other user; as the handshake, so it is sent before any frame.
 void NetworkManager::sendShip()
 {
-	//Create a connection packet, which will store the constructed ship's information.
-	sf::Packet packet;
-	packet << std::underlying_type_t<PacketType>(PacketType::CONNECT);
+	//Create a connection packet, which will store the constructed ship's information; after the version of the format, and our settings.
+	WireWriter writer;
+	writer.writeByte(static_cast<std::uint8_t>(PacketType::CONNECT));
+	writer.writeVarint(Wire::VERSION);
+	//The settings both peers must share; the peer refuses us if any differ from its own.
+	writer.writeByte(m_isLockstep ? 1 : 0);
+	writer.writeVarint(m_inputDelay);
+	writer.writeVarint(m_tickLength.asMicroseconds());
+
+	//The local player's ship.
+	BattleCommand ship;
+	ship.type = CommandType::CREATE_SHIP;
+	ship.position = getStartPosition();
+	ship.angle = getStartAngle();
+	ship.turrets = m_shipTurrets;
+	writer.writeCommand(ship);
+
+	//Hand the information on the ship to the network thread, to send to the peer.
+	m_frameMutex.lock();
+
+	m_handshake = writer.getBytes();
 
-	//Place the host's ship in the top-left.
-	if(m_isHost)
+	m_frameMutex.unlock();
+}
+
+//Queues a command received from the peer onto the battle; waits for room while the battle catches up, unless the peer disconnects.
+//	command : The command received.
+void NetworkManager::queueCommand(BattleCommand &&command)
+{
+	while(!m_battle->queueRemoteCommand(std::move(command)) && m_transport->isConnected())
 	{
-		//Package the ship's position.
-		packet << 1800.f;
-		packet << 1800.f;
-		//Package the ship's angle.
-		packet << 45.f;
+		sf::sleep(sf::milliseconds(1));
 	}
-	//Otherwise, place the joining user's ship in the bottom-right.
-	else
+}
+
+//Waits for a dedicated server to pair the local player into a match, and takes the settings of the match from it.
+//Returns whether the player was put in a match; false if the server is of another version, or tick length, or the connection is closed.
+bool NetworkManager::waitForMatch()
+{
+	//The match message; the first the server sends.
+	std::vector<std::uint8_t> message;
+
+	//Waiting may take as long as it takes another player to join; closing all connections stops it.
+	while(!m_transport->receive(message))
 	{
-		//Package the ship's position.
-		packet << 2200.f;
-		packet << 2200.f;
-		//Package the ship's angle.
-		packet << 225.f;
+		if(!m_transport->wait(MATCH_POLL_INTERVAL)) return false;
 	}
 
-	//Package how many turrets the ship has.
-	packet << m_shipTurrets.size();
+	//Decodes the match's bytes in the wire format.
+	WireReader reader(message.data(), message.size());
 
-	//Package all of the info for building the turrets.
-	for(const auto &turretInfo : m_shipTurrets)
+	if(static_cast<PacketType>(reader.readByte()) != PacketType::MATCH || reader.readVarint() != Wire::VERSION)
 	{
-		//Package what type of projectile the turret shoots.
-		packet << std::underlying_type_t<ProjectileType>(turretInfo.projType);
-		//Package the position of the turret on the ship.
-		packet << turretInfo.localPosition.x;
-		packet << turretInfo.localPosition.y;
+		std::cerr << "Server uses another version of the wire format; disconnecting." << std::endl;
+		m_transport->disconnect();
+
+		return false;
 	}
 
-	//Send the information on the ship to the peer.
-	send(packet);
+	//Which of the two players we are; the first plays as the host.
+	const std::uint64_t seat = reader.readVarint();
+	//The lockstep settings of the match; both players are given the same.
+	const bool isLockstep = reader.readByte() != 0;
+	const std::uint64_t inputDelay = reader.readVarint();
+	//How long each tick of the match lasts, in microseconds; the tick rate is ours to set, so it is not taken from the server.
+	const std::uint64_t tickLength = reader.readVarint();
+
+	if(!reader.isValid() || seat > 1)
+	{
+		m_transport->disconnect();
+
+		return false;
+	}
+
+	//Refuse a match at another tick rate, as our battle would run apart from the server's, and the other player's.
+	if(tickLength != static_cast<std::uint64_t>(m_tickLength.asMicroseconds()))
+	{
+		std::cerr << "Server plays at " << tickLength << " us a tick; we play at " << m_tickLength.asMicroseconds() << " us a tick. Disconnecting."
+			<< std::endl;
+		m_transport->disconnect();
+
+		return false;
+	}
+
+	m_isHost = seat == 0;
+	setLockstep(isLockstep, static_cast<unsigned int>(inputDelay));
+
+	return true;
 }
 
-//Unpackages the data of the ship built by the other user, and creates the ship in the battle.
-	//	shipPacket : Network packet containing the data on the ship.
-void NetworkManager::unpackageShip(sf::Packet shipPacket)
+//Handles the handshake; the first packet from the peer.
+//	reader : Reads the packet.
+//Returns whether the handshake was accepted.
+bool NetworkManager::receiveHandshake(WireReader &reader)
 {
-	//The position of the received ship.
-	sf::Vector2f shipPosition;
-	shipPacket >> shipPosition.x; shipPacket >> shipPosition.y;
+	//Refuse a peer sending another version of the format, as we would misread everything it sends.
+	if(static_cast<PacketType>(reader.readByte()) != PacketType::CONNECT || reader.readVarint() != Wire::VERSION)
+	{
+		std::cerr << "Peer uses another version of the wire format; disconnecting." << std::endl;
+		return false;
+	}
 
-	//The ship's angle.
-	float angle;
-	shipPacket >> angle;
+	//The peer's settings; without lockstep, the input delay is unused, so it may differ.
+	const bool isLockstep = reader.readByte() != 0;
+	const std::uint64_t inputDelay = reader.readVarint();
+	const std::uint64_t tickLength = reader.readVarint();
 
-	//How many turrets the ship has.
-	size_t turretAmount;
-	shipPacket >> turretAmount;
+	if(!reader.isValid()) return false;
 
-	//List of build information of the turrets on the ship.
-	std::vector<TurretInfo> turretList;
+	//Refuse a peer with other settings too; the battles would run different ticks, or carry out commands at different ticks, and desync.
+	if(isLockstep != m_isLockstep || (m_isLockstep && inputDelay != m_inputDelay)
+		|| tickLength != static_cast<std::uint64_t>(m_tickLength.asMicroseconds()))
+	{
+		std::cerr << "Peer plays with " << describeSettings(isLockstep, inputDelay, tickLength) << "; we play with "
+			<< describeSettings(m_isLockstep, m_inputDelay, m_tickLength.asMicroseconds()) << ". Disconnecting." << std::endl;
+		return false;
+	}
+
+	//The peer's ship; in lockstep, both peers create both ships before the first tick.
+	BattleCommand ship;
+	ship.type = CommandType::CREATE_SHIP;
+	ship.shipLayer = getRemoteLayer();
+	reader.readCommand(ship);
+	ship.tick = m_isLockstep ? 0 : m_battle->getTick();
+
+	if(!reader.isValid()) return false;
+
+	queueCommand(std::move(ship));
+
+	//Every command is stamped at least the input delay ahead; so with the ship received, every tick before the delay is done.
+	if(m_isLockstep) m_battle->confirmRemoteTick(m_inputDelay - 1);
+
+	return true;
+}
 
-	//Unpackage the information of the turrets on the ship.
-	for(unsigned int i = 0; i < turretAmount; i++)
+//Handles every frame in a packet from the peer.
+//	reader : Reads the packet.
+void NetworkManager::receiveFrames(WireReader &reader)
+{
+	while(reader.isValid() && !reader.isAtEnd())
 	{
-		//The projectile the turret fires.
-		std::underlying_type_t<ProjectileType> projType;
-		shipPacket >> projType;
-
-		//Position of the turret.
-		sf::Vector2f position;
-		shipPacket >> position.x;
-		shipPacket >> position.y;
-		
-		//Add the unpackaged information to the list.
-		turretList.push_back({static_cast<ProjectileType>(projType), position});
+		//The tick the frame was closed at.
+		const std::uint32_t tick = static_cast<std::uint32_t>(reader.readVarint());
+		//How many messages the frame holds.
+		const std::uint64_t messageCount = reader.readVarint();
+
+		for(std::uint64_t i = 0; i < messageCount && reader.isValid(); ++i)
+		{
+			//The command the message carries; for the peer's ship, applied at the next tick, or at the frame's tick plus the delay in lockstep.
+			BattleCommand command;
+			command.shipLayer = getRemoteLayer();
+			command.tick = m_isLockstep ? tick + m_inputDelay : m_battle->getTick();
+
+			//The type of message we received.
+			PacketType receivedType = static_cast<PacketType>(reader.readByte());
+			//The hash a state hash message carries.
+			std::uint64_t hash;
+
+			switch(receivedType)
+			{
+				//Move the enemy ship, or order it to fire on the target.
+				case PacketType::MOVE:
+				case PacketType::FIRE:
+					command.type = receivedType == PacketType::FIRE ? CommandType::FIRE : CommandType::MOVE;
+					command.targetLayer = getLocalLayer();
+					reader.readCommand(command);
+
+					if(reader.isValid()) queueCommand(std::move(command));
+
+					break;
+				//The hash of the peer's battle at the end of the frame's tick; to check it against our own.
+				case PacketType::STATE_HASH:
+					hash = reader.readUint64();
+
+					if(reader.isValid()) m_battle->queueRemoteHash(tick, hash);
+
+					break;
+				//Disconnect from the server, if the peer disconnected.
+				case PacketType::DISCONNECT:
+					m_transport->disconnect();
+
+					break;
+				//Any other type means the frame is malformed, as its length is unknown.
+				default:
+					return;
+			}
+		}
+
+		//In lockstep, the frame marks every command the peer gives for the tick the delay ahead, and those before it, as sent.
+		if(m_isLockstep && reader.isValid()) m_battle->confirmRemoteTick(tick + m_inputDelay);
 	}
+}
+
+//Sends the handshake, and every closed frame, to the other user; only call from the network thread.
+void NetworkManager::flush()
+{
+	//Taken from the shared buffers, so the battle's thread is not held up while they are sent.
+	std::vector<std::uint8_t> handshake, frames;
+
+	m_frameMutex.lock();
+
+	handshake.swap(m_handshake);
+	frames.swap(m_closedFrames);
+
+	m_frameMutex.unlock();
+
+	if(!handshake.empty()) m_transport->sendHandshake(std::move(handshake));
+	if(!frames.empty()) m_transport->sendFrames(std::move(frames));
 
-	//Create the received ship.
-	m_battle->createShip(1, shipPosition, angle, turretList);
+	m_transport->flush();
 }
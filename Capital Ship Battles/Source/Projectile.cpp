@@ -1,58 +1,26 @@
 /*
  * Author: George Mostyn-Parry
- *
- * Implementation of projectile class.
- * Possible optimisiation is to multiply by fast inverse square root when calculating velocity.
  */
 #include "Projectile.hpp"
 
-#include "CSB_Functions.hpp" //For calculating angle to face the target on spawn.
+#include <type_traits> //For std::underlying_type_t.
 
-//Construct a projectile with the passed ShotInfo.
-//	info : Information on how to construct the projectile.
-Projectile::Projectile(const ShotInfo &info)
-	:m_projType(info.projType), m_layer(info.layer)
+//Declared in an anonymous namespace to prevent name clashes.
+namespace
 {
-	//How many co-ordinates per second the projectile should move.
-	float speed;
-
-	//Customise the projectile depending on what type it is.
-	switch(m_projType)
+	//How each projectile type looks and moves; indexed by the ProjectileType's value.
+	//Colours are spelt out, rather than using sf::Color's constants, as those may not be initialised before this table.
+	const ProjectileTypeInfo PROJECTILE_TYPES[] =
 	{
-		case ProjectileType::LASER:
-			setSize({8, 4});
-			setFillColor(sf::Color::Red);
-			speed = 1000;
-			break;
-		case ProjectileType::MISSILE:
-			setSize({24, 8});
-			setFillColor(sf::Color::Cyan);
-			speed = 750;
-			break;
-		case ProjectileType::PLASMA:
-			setSize({10, 10});
-			setFillColor(sf::Color::Green);
-			speed = 600;
-			break;
-	}
-
-	setPosition(info.spawn);
-	//Centre the origin of the projectile.
-	setOrigin(getSize() / 2.f);
-
-	//Distance between the target and the projectile's starting position.
-	sf::Vector2f diff = info.target - getPosition();
-	setRotation(CSB::vectorAngle(diff));
-
-	//Vector length of the difference.
-	float diffLength = sqrt(diff.x * diff.x + diff.y * diff.y);
-	//Normalise distance vector and multiply by speed to get the projectile's velocity.
-	m_velocity = diff / diffLength * speed;
+		{{8, 4}, sf::Color(255, 0, 0), 1000}, //LASER; red.
+		{{24, 8}, sf::Color(0, 255, 255), 750}, //MISSILE; cyan.
+		{{10, 10}, sf::Color(0, 255, 0), 600} //PLASMA; green.
+	};
 }
 
-//Processes the projectile for this tick.
-//	deltaTime : How much time has passed since the last update.
-void Projectile::update(const sf::Time &deltaTime)
+//Returns how the passed type of projectile looks, and moves.
+//	projType : The type of projectile we want the information of.
+const ProjectileTypeInfo& getProjectileTypeInfo(ProjectileType projType)
 {
-	move(m_velocity * deltaTime.asSeconds());
-}
\ No newline at end of file
+	return PROJECTILE_TYPES[std::underlying_type_t<ProjectileType>(projType)];
+}
@@ -0,0 +1,140 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Implementation of the projectile pool.
+ * Possible optimisiation is to multiply by fast inverse square root when calculating velocity.
+ */
+#include "ProjectilePool.hpp"
+
+#include <algorithm> //For std::max.
+#include <cmath> //For sqrt, and the trigonometric functions.
+
+#include "CSB_Functions.hpp" //For calculating angle to face the target on spawn.
+
+//Basic ProjectilePool constructor.
+//	initialCapacity : How many projectiles the pool can hold before it has to grow.
+ProjectilePool::ProjectilePool(std::size_t initialCapacity)
+{
+	//Reserve the arrays up-front, so the first volleys do not have to grow them.
+	m_positions.reserve(initialCapacity);
+	m_velocities.reserve(initialCapacity);
+	m_layers.reserve(initialCapacity);
+	m_types.reserve(initialCapacity);
+	m_rotations.reserve(initialCapacity);
+}
+
+//Creates a projectile with the passed information.
+//	info : Information on how to construct the projectile.
+void ProjectilePool::create(const ShotInfo &info)
+{
+	//Distance between the target and the projectile's starting position.
+	sf::Vector2f diff = info.target - info.spawn;
+	//Vector length of the difference.
+	float diffLength = std::sqrt(diff.x * diff.x + diff.y * diff.y);
+
+	//Fill the next slot; the arrays keep their capacity on removal, so this only allocates when the pool outgrows its peak.
+	m_positions.push_back(info.spawn);
+	//Normalise distance vector and multiply by speed to get the projectile's velocity.
+	m_velocities.push_back(diff / diffLength * getProjectileTypeInfo(info.projType).speed);
+	m_layers.push_back(info.layer);
+	m_types.push_back(info.projType);
+	m_rotations.push_back(CSB::vectorAngle(diff));
+}
+
+//Creates a projectile for each shot in the list, in order; the pool grows at most once for the whole list.
+//	shots : Information on how to construct each projectile.
+void ProjectilePool::create(const std::vector<ShotInfo> &shots)
+{
+	//How many projectiles the pool must hold once the shots are created.
+	const std::size_t required = size() + shots.size();
+
+	//Grow every array at once, doubling as push_back would, rather than each array reallocating part way through the shots.
+	if(required > m_positions.capacity())
+	{
+		const std::size_t capacity = std::max(required, m_positions.capacity() * 2);
+
+		m_positions.reserve(capacity);
+		m_velocities.reserve(capacity);
+		m_layers.reserve(capacity);
+		m_types.reserve(capacity);
+		m_rotations.reserve(capacity);
+	}
+
+	for(const auto &info : shots)
+	{
+		create(info);
+	}
+}
+
+//Removes the projectile at the index; the last projectile in the pool is moved into its place.
+//	index : Index of the projectile to remove.
+void ProjectilePool::remove(std::size_t index)
+{
+	//Index of the last projectile in the pool.
+	const std::size_t last = size() - 1;
+
+	//Move the last projectile into the removed slot; unless the removed projectile is the last.
+	if(index != last)
+	{
+		m_positions[index] = m_positions[last];
+		m_velocities[index] = m_velocities[last];
+		m_layers[index] = m_layers[last];
+		m_types[index] = m_types[last];
+		m_rotations[index] = m_rotations[last];
+	}
+
+	//Remove the now duplicated last slot.
+	m_positions.pop_back();
+	m_velocities.pop_back();
+	m_layers.pop_back();
+	m_types.pop_back();
+	m_rotations.pop_back();
+}
+
+//Removes every projectile in the pool.
+void ProjectilePool::clear()
+{
+	m_positions.clear();
+	m_velocities.clear();
+	m_layers.clear();
+	m_types.clear();
+	m_rotations.clear();
+}
+
+//Moves every projectile in the pool by its velocity.
+//	deltaTime : How much time has passed since the last update.
+void ProjectilePool::update(const sf::Time &deltaTime)
+{
+	update(deltaTime, 0, size());
+}
+
+//Moves a range of projectiles in the pool by their velocity; ranges that do not overlap may be moved from different threads at once.
+//	deltaTime : How much time has passed since the last update.
+//	begin : Index of the first projectile to move.
+//	end : Index after the last projectile to move.
+void ProjectilePool::update(const sf::Time &deltaTime, std::size_t begin, std::size_t end)
+{
+	const float seconds = deltaTime.asSeconds();
+
+	for(std::size_t i = begin; i < end; ++i)
+	{
+		m_positions[i] += m_velocities[i] * seconds;
+	}
+}
+
+//Returns the bounding rectangle of the projectile at the index, in global co-ordinates.
+//	index : Index of the projectile.
+sf::FloatRect ProjectilePool::getGlobalBounds(std::size_t index) const
+{
+	//Size of the projectile's rectangle.
+	const sf::Vector2f &size = getProjectileTypeInfo(m_types[index]).size;
+	//Rotation of the projectile, in radians.
+	const float angle = m_rotations[index] * (CSB::PI / 180.f);
+	const float cosine = std::abs(std::cos(angle));
+	const float sine = std::abs(std::sin(angle));
+
+	//Half of the extents of the rotated rectangle; the rectangle is rotated around its centre.
+	const sf::Vector2f halfExtents = sf::Vector2f(size.x * cosine + size.y * sine, size.x * sine + size.y * cosine) / 2.f;
+
+	return sf::FloatRect(m_positions[index] - halfExtents, halfExtents * 2.f);
+}
@@ -0,0 +1,56 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "ProjectileRenderer.hpp"
+
+#include <cmath> //For the trigonometric functions.
+
+#include "CSB_Functions.hpp" //For PI.
+
+//Basic ProjectileRenderer constructor.
+ProjectileRenderer::ProjectileRenderer()
+	:m_vertices(sf::Quads)
+{}
+
+//Rebuilds the quads from the projectiles in the pool; the pool must not be changed while this is running.
+//	projectiles : The projectiles that will be drawn.
+//	rewind : How far back along its velocity each projectile is drawn; for drawing a moment before the end of the tick.
+void ProjectileRenderer::update(const ProjectilePool &projectiles, const sf::Time &rewind)
+{
+	//Four vertices per projectile; resizing keeps the memory of the larger size, so this only allocates when we pass the peak.
+	m_vertices.resize(projectiles.size() * 4);
+
+	for(std::size_t i = 0; i < projectiles.size(); ++i)
+	{
+		//How this type of projectile looks.
+		const ProjectileTypeInfo &typeInfo = getProjectileTypeInfo(projectiles.getProjectileType(i));
+		//Rotation of the projectile, in radians.
+		const float angle = projectiles.getRotation(i) * (CSB::PI / 180.f);
+
+		//Half of the projectile's length along its direction, and half of its width across its direction;
+		//the projectile is rotated around its centre, as with a centred origin.
+		const sf::Vector2f alongAxis = sf::Vector2f(std::cos(angle), std::sin(angle)) * (typeInfo.size.x / 2.f);
+		const sf::Vector2f acrossAxis = sf::Vector2f(-std::sin(angle), std::cos(angle)) * (typeInfo.size.y / 2.f);
+
+		//Centre of the projectile; projectiles move in a straight line, so its earlier position is found from its velocity.
+		const sf::Vector2f position = projectiles.getPosition(i) - projectiles.getVelocity(i) * rewind.asSeconds();
+		//The quad of this projectile.
+		sf::Vertex *quad = &m_vertices[i * 4];
+
+		//Place the corners in the same winding as a rectangle shape; top-left, top-right, bottom-right, bottom-left.
+		quad[0].position = position - alongAxis - acrossAxis;
+		quad[1].position = position + alongAxis - acrossAxis;
+		quad[2].position = position + alongAxis + acrossAxis;
+		quad[3].position = position - alongAxis + acrossAxis;
+
+		quad[0].color = quad[1].color = quad[2].color = quad[3].color = typeInfo.colour;
+	}
+}
+
+//Draws every projectile in the batch with a single draw call.
+//	target : What we will be drawing onto.
+//	states : Visual manipulations to the elements that are being drawn.
+void ProjectileRenderer::draw(sf::RenderTarget &target, sf::RenderStates states) const
+{
+	target.draw(m_vertices, states);
+}
@@ -3,6 +3,8 @@
  */
 #include "ResourceManager.hpp"
 
+#include "Ship.hpp" //For building the keys of hulls.
+
  //Returns the texture found at the file path; returns nullptr on a failed load.
  //	filePath : File path of the texture we want to load into the resource manager, if it is not already loaded.
 sf::Texture* ResourceManager::loadTexture(const std::string &filePath)
@@ -32,6 +34,100 @@ sf::Texture* ResourceManager::loadTexture(const std::string &filePath)
 	}
 }
 
+//Returns the image found at the file path; returns nullptr on a failed load.
+//Images stay in system memory, so they may be loaded without a graphics context.
+//	filePath : File path of the image we want to load into the resource manager, if it is not already loaded.
+sf::Image* ResourceManager::loadImage(const std::string &filePath)
+{
+	//Attempt to load the image, if the image does not exist in the table.
+	if(m_imageTable.find(filePath) == m_imageTable.end())
+	{
+		//Image that will be used to load the image from file.
+		sf::Image loader;
+
+		//Store, and return, the image if it was successfully loaded.
+		if(loader.loadFromFile(filePath))
+		{
+			m_imageTable[filePath] = loader;
+			return &m_imageTable[filePath];
+		}
+		//Otherwise, return a nullptr.
+		else
+		{
+			return nullptr;
+		}
+	}
+	//Otherwise, return a pointer to the stored image.
+	else
+	{
+		return &m_imageTable[filePath];
+	}
+}
+
+//Returns the pristine collision key of the hull image found at the file path; returns nullptr on a failed load.
+//The key is only built the first time, and shared by every ship with the hull.
+//	filePath : File path of the hull image we want the key of.
+const DamageMask* ResourceManager::loadDamageKey(const std::string &filePath)
+{
+	//Attempt to build the key, if the key does not exist in the table.
+	if(m_damageKeyTable.find(filePath) == m_damageKeyTable.end())
+	{
+		//The hull image the key is built from.
+		sf::Image *hullImage = loadImage(filePath);
+
+		//Store, and return, the key if the hull image was successfully loaded.
+		if(hullImage)
+		{
+			m_damageKeyTable[filePath] = Ship::createPristineKey(*hullImage);
+			return &m_damageKeyTable[filePath];
+		}
+		//Otherwise, return a nullptr.
+		else
+		{
+			return nullptr;
+		}
+	}
+	//Otherwise, return a pointer to the stored key.
+	else
+	{
+		return &m_damageKeyTable[filePath];
+	}
+}
+
+//Returns the shader found at the file path, compiled for the passed stage; returns nullptr on a failed load.
+//The shader is only compiled the first time, so every user shares the one program.
+//	filePath : File path of the shader we want to load into the resource manager, if it is not already loaded.
+//	type : The stage the shader is compiled for; i.e. vertex, or fragment.
+sf::Shader* ResourceManager::loadShader(const std::string &filePath, sf::Shader::Type type)
+{
+	//Key of the shader in the table.
+	const auto key = std::make_pair(filePath, type);
+
+	//Attempt to load the shader, if the shader does not exist in the table.
+	if(m_shaderTable.find(key) == m_shaderTable.end())
+	{
+		//Shaders can not be copied, so the shader is loaded in place.
+		sf::Shader &loader = m_shaderTable[key];
+
+		//Return the shader if it was successfully loaded.
+		if(loader.loadFromFile(filePath, type))
+		{
+			return &loader;
+		}
+		//Otherwise, remove the failed shader, and return a nullptr.
+		else
+		{
+			m_shaderTable.erase(key);
+			return nullptr;
+		}
+	}
+	//Otherwise, return a pointer to the stored shader.
+	else
+	{
+		return &m_shaderTable[key];
+	}
+}
+
 //Returns the font found at the file path; returns nullptr on a failed load.
 //	filePath : File path of the font we want to load into the resource manager, if it is not already loaded.
 sf::Font* ResourceManager::loadFont(const std::string &filePath)
@@ -3,39 +3,58 @@
  */
 #include "Ship.hpp"
 
-#include "CSB_Functions.hpp" //For rotating to face the movement destination.
+#include <algorithm> //For std::find_if.
+#include <cmath> //For sqrt, and abs.
+#include <ostream> //For dumping the ship's state.
 
- //Declared in an anonymous namespace to prevent name clashes.
- //These have to be global to allow them to be used in the const draw function.
-namespace
-{
-	sf::Mutex turretMutex; //Controls access to the turret list.
-}
+#include "CSB_Functions.hpp" //For rotating to face the movement destination.
 
 //Construct ship with passed parameters.
 //	position : Position the ship starts at.
 //	angle : Angle the ship starts at.
 //	turretList : List of turrets the ship starts with.
-//	hullTexture : Texture of the ship hull.
-//	turretAtlasTexture : Texture atlas for the turrets.
-Ship::Ship(const sf::Vector2f &position, float angle, const std::vector<TurretInfo> &turretList, const sf::Texture *hullTexture, const sf::Texture *turretAtlasTexture)
+//	pristineKey : Undamaged key of the ship hull, from createPristineKey; shared by every ship with the hull, so it must outlive the ship.
+//	shotQueue : Queue the ship's turrets push their shots onto; nullptr for a ship whose turrets never fire, such as the one being built.
+//	fireOrder : Where the ship's shots are placed in the queue, relative to the other ships; unique to each ship in the battle.
+Ship::Ship(const sf::Vector2f &position, float angle, const std::vector<TurretInfo> &turretList, const DamageMask &pristineKey,
+	ShotQueue *shotQueue, std::uint64_t fireOrder)
+	:m_shotQueue(shotQueue), m_fireOrder(fireOrder), m_damageMask(&pristineKey)
 {
+	//Size of the hull, in pixels.
+	const sf::Vector2u hullSize = pristineKey.getSize() * KEY_SIZE_FACTOR;
+
 	setPosition(position);
 	setRotation(angle);
-	//Set texture, and set the origin to the centre of the texture.
-	setTexture(*hullTexture);
+	//Set the texture rectangle from the key, as the ship never holds the texture itself.
+	setTextureRect({0, 0, static_cast<int>(hullSize.x), static_cast<int>(hullSize.y)});
+	//Set the origin to the centre of the hull.
 	setOrigin(sf::Vector2f(getLocalBounds().width, getLocalBounds().height) / 2.f);
+	//Cache the starting transforms, as the turrets and collision use them before the first update.
+	updateTickTransforms();
+	m_previousPose = {getPosition(), getRotation()};
 
-	//Create the image key as a quarter of the size of the texture, so attacks are more impactful.
-	m_keyImage.create(getTexture()->getSize().x / KEY_SIZE_FACTOR, getTexture()->getSize().y / KEY_SIZE_FACTOR, sf::Color(0, 0, 0, 0));
+	//Add turrets to the ship.
+	addTurrets(turretList);
+}
+
+//Builds the undamaged key of a hull; a cell is intact if any pixel in its block is opaque.
+//Slow, as it reads every pixel of the hull; build it once per hull, and share it between ships.
+//	hullImage : Image of the ship hull.
+//Returns the key the hull's ships are constructed from.
+DamageMask Ship::createPristineKey(const sf::Image &hullImage)
+{
+	//Size of the hull, in pixels.
+	const sf::Vector2u hullSize = hullImage.getSize();
+	//The key being built.
+	DamageMask pristineKey;
 
-	//Image of texture, so we can read its pixels..
-	sf::Image textureImage = getTexture()->copyToImage();
+	//Create the key as a quarter of the size of the texture, so attacks are more impactful.
+	pristineKey.create(hullSize.x / KEY_SIZE_FACTOR, hullSize.y / KEY_SIZE_FACTOR);
 
-	//Colour all non-transparent pixel blocks as white; in pixel groups as defined by the KEY_SIZE_FACTOR.
-	for(unsigned int y = 0; y < getTexture()->getSize().y; y += KEY_SIZE_FACTOR)
+	//Mark all non-transparent pixel blocks as intact; in pixel groups as defined by the KEY_SIZE_FACTOR.
+	for(unsigned int y = 0; y < hullSize.y; y += KEY_SIZE_FACTOR)
 	{
-		for(unsigned int x = 0; x < getTexture()->getSize().x; x += KEY_SIZE_FACTOR)
+		for(unsigned int x = 0; x < hullSize.x; x += KEY_SIZE_FACTOR)
 		{
 			//Whether there is an opaque pixel in this pixel block.
 			bool hasOpaquePixel = false;
@@ -46,7 +65,7 @@ Ship::Ship(const sf::Vector2f &position, float angle, const std::vector<TurretIn
 				for(unsigned int i = 0; i < KEY_SIZE_FACTOR; ++i)
 				{
 					//Mark an opaque pixel was found if one of the pixels in the block is not fully transparent.
-					if(textureImage.getPixel(x + i, y + j).a != 0)
+					if(hullImage.getPixel(x + i, y + j).a != 0)
 					{
 						hasOpaquePixel = true;
 						break;
@@ -57,31 +76,23 @@ Ship::Ship(const sf::Vector2f &position, float angle, const std::vector<TurretIn
 				if(hasOpaquePixel) break;
 			}
 
-			//Mark the pixel on the destruction key as a collidable pixel, if there was an opaque pixel in this block.
+			//Mark the cell on the key as a collidable cell, if there was an opaque pixel in this block.
 			if(hasOpaquePixel)
 			{
-				m_keyImage.setPixel(x / KEY_SIZE_FACTOR, y / KEY_SIZE_FACTOR, sf::Color(255, 255, 255));
+				pristineKey.set(x / KEY_SIZE_FACTOR, y / KEY_SIZE_FACTOR);
 			}
 		}
 	}
 
-	//Load key into texture, so it can be used with the fragment shader.
-	m_keyTex.loadFromImage(m_keyImage);
-
-	//Load the damage shader from file as a fragment shader.
-	m_damageShader.loadFromFile("Assets/damageShader.frag", sf::Shader::Fragment);
-	//Set the uniforms for the shader.
-	m_damageShader.setUniform("texture", *getTexture());
-	m_damageShader.setUniform("keyTexture", m_keyTex);
-
-	//Add turrets to the ship.
-	addTurrets(turretList, turretAtlasTexture);
+	return pristineKey;
 }
 
 //Causes the ship to process internal data to update its state for this tick.
 //	deltaTime : The amount of time that has passed since the last update.
 void Ship::update(const sf::Time &deltaTime)
 {
+	m_previousPose = {getPosition(), getRotation()};
+
 	//Distance from current position to the target destination.
 	sf::Vector2f vectorDistance = m_destination - getPosition();
 	//Length of the distance to the destination.
@@ -125,8 +136,11 @@ void Ship::update(const sf::Time &deltaTime)
 			break;
 	}
 
+	//The ship has finished moving this tick, so the turrets, collision, and drawing can all share one transform.
+	updateTickTransforms();
+
 	//Lock ship's turret list for processing.
-	turretMutex.lock();
+	m_turretMutex.lock();
 
 	//Process each turret for this tick.
 	for(auto &turret : m_turrets)
@@ -134,36 +148,86 @@ void Ship::update(const sf::Time &deltaTime)
 		turret->update(deltaTime);
 	}
 
-	turretMutex.unlock();
+	m_turretMutex.unlock();
+}
+
+//Copies how the ship looks as of this tick into the snapshot; reuses the snapshot's memory where it can.
+//	snapshot : The snapshot to fill.
+void Ship::fillSnapshot(ShipSnapshot &snapshot) const
+{
+	snapshot.pose = {getPosition(), getRotation()};
+	snapshot.previousPose = m_previousPose;
+	snapshot.origin = getOrigin();
+	snapshot.textureRect = getTextureRect();
+	snapshot.damage = *m_damageMask;
+
+	m_turretMutex.lock();
+
+	snapshot.turrets.resize(m_turrets.size());
+
+	for(std::size_t i = 0; i < m_turrets.size(); ++i)
+	{
+		const Turret &turret = *m_turrets[i];
+
+		snapshot.turrets[i] = {turret.getTurretInfo().projType, turret.getPosition(), turret.getRotation(), turret.getPreviousRotation()};
+	}
+
+	m_turretMutex.unlock();
 }
 
-//Draw the ship, and its children, to the render target.
-//	target : What we will draw the ship onto.
-//	states : How to manipulate the drawing of the ship.
-void Ship::draw(sf::RenderTarget& target, sf::RenderStates states) const
+//Mixes the ship's state into the hash; its pose, movement and destination, damage, and turrets.
+//	hash : The hash to mix into.
+void Ship::hashState(StateHash &hash) const
 {
-	//Custom render states that has a custom fragment shader to draw the ship damage.
-	sf::RenderStates shipDamageStates = states;
+	hash.mixFloat(getPosition().x);
+	hash.mixFloat(getPosition().y);
+	hash.mixFloat(getRotation());
+	hash.mixFloat(m_speed);
+	hash.mix(static_cast<std::uint64_t>(m_movementState));
+	hash.mixFloat(m_destination.x);
+	hash.mixFloat(m_destination.y);
+	hash.mix(m_damageHash);
 
-	//Put the shader in the render states.
-	shipDamageStates.shader = &m_damageShader;
+	m_turretMutex.lock();
 
-	//Draw the body of the ship.
-	target.draw((sf::Sprite)*this, shipDamageStates);
+	hash.mix(m_turrets.size());
 
-	//Combine the ship's transform into the render states, so the child objects will move and rotate with it.
-	states.transform.combine(getTransform());
+	for(const auto &turret : m_turrets)
+	{
+		turret->hashState(hash);
+	}
 
-	//Lock the turret list for drawing.
-	turretMutex.lock();
+	m_turretMutex.unlock();
+}
+
+//Writes the ship's state as text, with exact floats; so two dumps may be diffed to find where the ships diverged.
+//	stream : The stream to write to.
+void Ship::dumpState(std::ostream &stream) const
+{
+	stream << std::hexfloat << "position " << getPosition().x << " " << getPosition().y << " rotation " << getRotation() << "\n";
+	stream << "speed " << m_speed << " state " << static_cast<int>(m_movementState)
+		<< " destination " << m_destination.x << " " << m_destination.y << "\n";
+
+	m_turretMutex.lock();
+
+	stream << "turrets " << m_turrets.size() << "\n";
 
-	//Draw every turret on the ship.
 	for(const auto &turret : m_turrets)
 	{
-		target.draw(*turret, states);
+		turret->dumpState(stream);
+	}
+
+	m_turretMutex.unlock();
+
+	//The damage, as the words of the mask; a diff of two dumps then shows which rows differ.
+	stream << "damage " << std::hex << m_damageHash << "\n";
+
+	for(std::uint64_t word : m_damageMask->getWords())
+	{
+		stream << word << " ";
 	}
 
-	turretMutex.unlock();
+	stream << std::dec << std::defaultfloat << "\n";
 }
 
 //Orders the ship to move to the target position.
@@ -181,14 +245,14 @@ void Ship::moveCommand(const sf::Vector2f &target)
 //	layer : The layer the shot will travel on.
 void Ship::fireCommand(const sf::Vector2f &target, unsigned int layer)
 {
-	turretMutex.lock();
+	m_turretMutex.lock();
 
 	for(auto &turret : m_turrets)
 	{
 		turret->fireCommand(target, layer);
 	}
 
-	turretMutex.unlock();
+	m_turretMutex.unlock();
 }
 
 //Finds if there was a collision between this ship and the passed global position.
@@ -204,71 +268,127 @@ bool Ship::collide(const sf::Vector2f &globalPosition)
 	//Make further collision checks if passed broad-phase pass.
 	if(getLocalBounds().contains(sf::Vector2f(pixelPosition)))
 	{
-		//A collision occured if the pixel at the location is not transparent.
-		didCollide = m_keyImage.getPixel(pixelPosition.x / KEY_SIZE_FACTOR, pixelPosition.y / KEY_SIZE_FACTOR).a != 0;
+		//A collision occured if the cell at the location is still intact.
+		didCollide = m_damageMask->isSet(pixelPosition.x / KEY_SIZE_FACTOR, pixelPosition.y / KEY_SIZE_FACTOR);
 	}
 
 	return didCollide;
 }
 
-//Finds if there was a collision between this ship and the passed projectile.
-//	proj : Projectile that might have collided with this ship.
+//Finds if there was a collision between this ship and the passed projectile, and applies the damage if there was.
+//	projectiles : Pool holding the projectile that might have collided with this ship.
+//	index : Index of the projectile in the pool.
 //	deltaTime : The amount of time that passed to move the projectile to this position from the last.
 //Returns whether the collision occurred.
-bool Ship::collide(const Projectile &proj, const sf::Time &deltaTime)
+bool Ship::collide(const ProjectilePool &projectiles, std::size_t index, const sf::Time &deltaTime)
 {
-	//Whether the projectile collided or not.
-	bool didCollide = false;
+	//The cell hit by the projectile, if any.
+	const sf::Vector2i pixelHit = findHit(projectiles, index, deltaTime);
+
+	//There was a collision if it was not out of bounds.
+	if(pixelHit.x != -1) applyHit(pixelHit);
 
+	return pixelHit.x != -1;
+}
+
+//Finds the cell of the damage mask the projectile first hit, without changing the ship; so it may be called from several threads at once.
+//	projectiles : Pool holding the projectile that might have collided with this ship.
+//	index : Index of the projectile in the pool.
+//	deltaTime : The amount of time that passed to move the projectile to this position from the last.
+//Returns the cell hit, or a value of {-1, -1} if there was no collision.
+sf::Vector2i Ship::findHit(const ProjectilePool &projectiles, std::size_t index, const sf::Time &deltaTime) const
+{
 	//Make further collision checks if the projectile's bounds intersect the ship's bounds.
-	if(getGlobalBounds().intersects(proj.getGlobalBounds()))
+	if(m_tickBounds.intersects(projectiles.getGlobalBounds(index)))
+	{
+		return firstPixelHit(projectiles, index, deltaTime);
+	}
+
+	return {-1, -1};
+}
+
+//Destroys a cell of the damage mask, and the turrets mounted on it.
+//	cell : The cell hit; from findHit.
+void Ship::applyHit(const sf::Vector2i &cell)
+{
+	//Take a copy of the shared pristine key on the first hit; every later hit damages the copy.
+	if(m_damageMask != &m_ownDamageMask)
 	{
-		//Find the first pixel hit by the projectile.
-		sf::Vector2i pixelHit = firstPixelHit(proj, deltaTime);
+		m_ownDamageMask = *m_damageMask;
+		m_damageMask = &m_ownDamageMask;
+	}
 
-		//There was a collision if it was not out of bounds.
-		if(pixelHit.x != -1)
-		{
-			//Black out the pixel that was hit on the key.
-			m_keyImage.setPixel(pixelHit.x, pixelHit.y, sf::Color(0, 0, 0, 0));
-			//Update key with new image.
-			m_keyTex.update(m_keyImage);
+	//Destroy the cell that was hit on the mask; the hash only changes if it was intact, as xor would undo an earlier hit on it.
+	if(m_ownDamageMask.isSet(cell.x, cell.y))
+	{
+		m_damageHash ^= StateHash::scramble(cell.y * m_ownDamageMask.getSize().x + cell.x);
+	}
+
+	m_ownDamageMask.reset(cell.x, cell.y);
+
+	//Lock turret list, so we can delete elements safely.
+	m_turretMutex.lock();
 
-			//Lock turret list, so we can delete elements safely.
-			turretMutex.lock();
+	//Erase the turrets mounted on the destroyed cell, and any that had no hull beneath them.
+	for(unsigned int cellIndex : {cell.y * m_damageMask->getSize().x + cell.x, UNSUPPORTED_CELL})
+	{
+		auto mounted = m_turretsByCell.find(cellIndex);
 
-			//Erase any turrets that were hit by the projectile.
-			for(auto it = m_turrets.begin(); it != m_turrets.end();)
+		if(mounted != m_turretsByCell.end())
+		{
+			for(const Turret *turret : mounted->second)
 			{
-				//Erase the turret if the pixel beneath it no longer exists.
-				if(!collide(getTransform().transformPoint((*it)->getPosition())))
-				{
-					it = m_turrets.erase(it);
-				}
-				//Otherwise, increment the loop.
-				else
+				//Erasing keeps the order of the remaining turrets, so they still fire in the order they were built.
+				m_turrets.erase(std::find_if(m_turrets.begin(), m_turrets.end(), [turret](const std::unique_ptr<Turret> &mountedTurret)
 				{
-					it++;
-				}
+					return mountedTurret.get() == turret;
+				}));
 			}
 
-			turretMutex.unlock();
-
-			didCollide = true;
+			m_turretsByCell.erase(mounted);
 		}
 	}
 
-	return didCollide;
+	m_turretMutex.unlock();
+}
+
+//Recomputes the cached transforms, and bounds, from the ship's position; done by update, so only needed when the ship is placed directly.
+void Ship::updateTickTransforms()
+{
+	m_tickTransform = getTransform();
+	m_tickInverseTransform = m_tickTransform.getInverse();
+	m_tickBounds = m_tickTransform.transformRect(getLocalBounds());
 }
 
 //Builds, and adds, turrets made from the build info to this ship.
 //	newTurrets : Build information for the new turrets.
-//	turretAtlasTexture : Texture atlas to apply to the new turrets.
-void Ship::addTurrets(const std::vector<TurretInfo> &newTurrets, const sf::Texture *turretAtlasTexture)
+void Ship::addTurrets(const std::vector<TurretInfo> &newTurrets)
 {
 	for(const auto &buildInfo : newTurrets)
 	{
-		m_turrets.push_back(std::make_unique<Turret>(buildInfo, &getTransform(), turretAtlasTexture));
+		//Turrets are updated in the order they were added, so numbering them in turn keeps their shots in that order.
+		const std::uint64_t turretOrder = m_fireOrder << TURRET_ORDER_BITS | m_turretsAdded++;
+
+		//The turrets are drawn by the ShipRenderer, so they have no texture of their own.
+		m_turrets.push_back(std::make_unique<Turret>(buildInfo, &m_tickTransform, &m_tickInverseTransform, nullptr, m_shotQueue, turretOrder));
+
+		//The turret's position is local to the ship, so it is already in pixel co-ordinates of the hull.
+		sf::Vector2i pixelPosition(buildInfo.localPosition);
+		//Cell of the damage mask the turret is mounted on.
+		unsigned int cell = UNSUPPORTED_CELL;
+
+		//Mount the turret on the cell beneath it, if the cell is part of the hull.
+		if(getLocalBounds().contains(sf::Vector2f(pixelPosition)))
+		{
+			sf::Vector2u cellPosition = sf::Vector2u(pixelPosition) / KEY_SIZE_FACTOR;
+
+			if(m_damageMask->isSet(cellPosition.x, cellPosition.y))
+			{
+				cell = cellPosition.y * m_damageMask->getSize().x + cellPosition.x;
+			}
+		}
+
+		m_turretsByCell[cell].push_back(m_turrets.back().get());
 	}
 }
 
@@ -277,14 +397,15 @@ void Ship::addTurrets(const std::vector<TurretInfo> &newTurrets, const sf::Textu
 //Returns the pixel co-ordinates that the global co-ordinates transformed to.
 sf::Vector2i Ship::getPixelPosition(sf::Vector2f globalPosition) const
 {
-	return sf::Vector2i(getTransform().getInverse().transformPoint(globalPosition));
+	return sf::Vector2i(m_tickInverseTransform.transformPoint(globalPosition));
 }
 
 //Finds the first pixel hit by the projectile.
-//	proj : The projectile that might have collided with the ship.
+//	projectiles : Pool holding the projectile that might have collided with the ship.
+//	index : Index of the projectile in the pool.
 //	deltaTime : The amount of time that passed to move the projectile to this position from the last.
 //Returns the first pixel hit, or a value of {-1, -1} if there was no collision.
-sf::Vector2i Ship::firstPixelHit(const Projectile &proj, const sf::Time &deltaTime) const
+sf::Vector2i Ship::firstPixelHit(const ProjectilePool &projectiles, std::size_t index, const sf::Time &deltaTime) const
 {
 	///The following is a tailored implementation of Bresenham's line algorithm to find the first pixel in a line that was hit.
 	///I.e. The first pixel that was not transparent.
@@ -293,9 +414,9 @@ sf::Vector2i Ship::firstPixelHit(const Projectile &proj, const sf::Time &deltaTi
 	sf::Vector2i pixelHit = sf::Vector2i(-1, -1);
 
 	//End position of the projectile; where the projectile currently is.
-	sf::Vector2f endPosition = proj.getPosition();
+	sf::Vector2f endPosition = projectiles.getPosition(index);
 	//Start position of the projectile; where the projectile was before it was moved.
-	sf::Vector2f startPosition = proj.getPosition() - proj.getVelocity() * deltaTime.asSeconds();
+	sf::Vector2f startPosition = endPosition - projectiles.getVelocity(index) * deltaTime.asSeconds();
 
 	//Turn the start and end position into pixel co-ordinates, so we can identify the first pixel hit.
 	//Divided by KEY_SIZE_FACTOR, as the damage key is usually not the same size as the texture.
@@ -303,7 +424,7 @@ sf::Vector2i Ship::firstPixelHit(const Projectile &proj, const sf::Time &deltaTi
 	sf::Vector2i pixelEndPosition = sf::Vector2i(sf::Vector2f(getPixelPosition(endPosition)) / static_cast<float>(KEY_SIZE_FACTOR));
 
 	//Whether the line originally had a greater y difference than x difference.
-	const bool isSteep = (abs(pixelEndPosition.y - pixelStartPosition.y) > abs(pixelEndPosition.x - pixelStartPosition.x));
+	const bool isSteep = (std::abs(pixelEndPosition.y - pixelStartPosition.y) > std::abs(pixelEndPosition.x - pixelStartPosition.x));
 	//Swap he x and y co-ordinates if the line is steep; to make the algorithm simpler.
 	if(isSteep)
 	{
@@ -316,52 +437,69 @@ sf::Vector2i Ship::firstPixelHit(const Projectile &proj, const sf::Time &deltaTi
 	const int yStep = (pixelStartPosition.y < pixelEndPosition.y) ? 1 : -1;
 
 	//Difference on the x-axis between the start and end.
-	const float xDiff = static_cast<float>(abs(pixelEndPosition.x - pixelStartPosition.x));
+	const float xDiff = static_cast<float>(std::abs(pixelEndPosition.x - pixelStartPosition.x));
 	//Difference on the y-axis between the start and end.
-	const float yDiff = static_cast<float>(abs(pixelEndPosition.y - pixelStartPosition.y));
+	const float yDiff = static_cast<float>(std::abs(pixelEndPosition.y - pixelStartPosition.y));
 
 	//Measures how long until we have to step the y-axis.
 	float error = xDiff / 2.0f;
 	//Start position on the y-axis.
 	int y = pixelStartPosition.y;
 
-	//Step through all x co-ordinates of the line drawn from the start position to the end position..
-	for(int x = pixelStartPosition.x; x != pixelEndPosition.x; x += xStep)
+	//A steep line changes row on the damage mask every step, so each cell is tested on its own.
+	if(isSteep)
 	{
-		//Only read a pixel from a valid position.
-		if(sf::IntRect({0, 0}, (sf::Vector2i)m_keyImage.getSize()).contains(y, x))
+		//Step through all x co-ordinates of the line drawn from the start position to the end position.
+		for(int x = pixelStartPosition.x; x != pixelEndPosition.x; x += xStep)
 		{
-			//If the line was originally steep, then we need to swap the x and y co-ordinates back.
-			if(isSteep)
+			//The x and y co-ordinates were swapped, so we need to swap them back to read the mask.
+			//Mark this as the first pixel hit, and break out of the loop, if this cell is intact.
+			if(m_damageMask->contains(y, x) && m_damageMask->isSet(y, x))
 			{
-				//Mark this as the first pixel hit, and break out of the loop, if this pixel is not transparent.
-				if(m_keyImage.getPixel(y, x).a != 0)
-				{
-					pixelHit = {y, x};
-					break;
-				}
+				pixelHit = {y, x};
+				break;
 			}
 
-			//Otherwise, we use the x and y co-ordinates as they are.
-			else
+			//Subtract the y diff from the error to measure how long until we step on the y-axis.
+			error -= yDiff;
+			//Step on y-axis if the error is less than 0.
+			if(error < 0)
 			{
-				//Mark this as the first pixel hit, and break out of the loop, if this pixel is not transparent.
-				if(m_keyImage.getPixel(x, y).a != 0)
-				{
-					pixelHit = {x, y};
-					break;
-				}
+				y += yStep;
+				//Add xDiff so we can measure when we next need to step on the y-axis.
+				error += xDiff;
+			}
+		}
+	}
+	//Otherwise, the line walks along a row until it steps on the y-axis; so each run along a row is tested a word at a time.
+	else
+	{
+		//Where the run along the current row started.
+		int runStart = pixelStartPosition.x;
+
+		//Step through all x co-ordinates of the line drawn from the start position to the end position, until a cell is hit.
+		for(int x = pixelStartPosition.x; x != pixelEndPosition.x && pixelHit.x == -1; x += xStep)
+		{
+			//Subtract the y diff from the error to measure how long until we step on the y-axis.
+			error -= yDiff;
+			//The run ends if the error is less than 0; so test the run, and step on the y-axis.
+			if(error < 0)
+			{
+				int hitX = m_damageMask->findFirstSet(y, runStart, x + xStep);
+				if(hitX != -1) pixelHit = {hitX, y};
+
+				runStart = x + xStep;
+				y += yStep;
+				//Add xDiff so we can measure when we next need to step on the y-axis.
+				error += xDiff;
 			}
 		}
 
-		//Subtract the y diff from the error to measure how long until we step on the y-axis.
-		error -= yDiff;
-		//Step on y-axis if the error is less than 0.
-		if(error < 0)
+		//Test the last run, which ends at the end of the line.
+		if(pixelHit.x == -1)
 		{
-			y += yStep;
-			//Add xDiff so we can measure when we next need to step on the y-axis.
-			error += xDiff;
+			int hitX = m_damageMask->findFirstSet(y, runStart, pixelEndPosition.x);
+			if(hitX != -1) pixelHit = {hitX, y};
 		}
 	}
 
@@ -0,0 +1,157 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "ShipGrid.hpp"
+
+#include <algorithm> //For std::min, std::max, std::find_if, and std::sort.
+#include <cmath> //For std::ceil, and std::floor.
+
+#include "Ship.hpp" //For the bounds of the ships.
+
+//Basic ShipGrid constructor.
+//	area : The area the grid covers; ships outside of it are placed in the nearest edge cells.
+//	cellSize : Width and height of each cell in the grid.
+ShipGrid::ShipGrid(const sf::FloatRect &area, float cellSize)
+	:m_area(area), m_cellSize(cellSize),
+	m_gridSize(std::max(1, static_cast<int>(std::ceil(area.width / cellSize))), std::max(1, static_cast<int>(std::ceil(area.height / cellSize))))
+{
+	m_cells.resize(m_gridSize.x * m_gridSize.y);
+}
+
+//Adds a ship to the grid.
+//	ship : The ship to add.
+//	order : Where the ship is in its list; candidates are returned in this order, so collisions resolve as they would without the grid.
+void ShipGrid::add(Ship *ship, unsigned int order)
+{
+	m_trackedShips.push_back({{ship, order}, getCellRange(ship->getTickBounds())});
+
+	placeInCells(m_trackedShips.back(), true);
+}
+
+//Removes a ship from the grid.
+//	ship : The ship to remove.
+void ShipGrid::remove(Ship *ship)
+{
+	auto it = std::find_if(m_trackedShips.begin(), m_trackedShips.end(), [ship](const TrackedShip &trackedShip)
+	{
+		return trackedShip.entry.ship == ship;
+	});
+
+	if(it != m_trackedShips.end())
+	{
+		placeInCells(*it, false);
+
+		//Order of the tracked list does not matter, as the order is stored with each ship.
+		*it = m_trackedShips.back();
+		m_trackedShips.pop_back();
+	}
+}
+
+//Moves every ship to the cells their bounds now overlap; only touches the cells of ships that changed cells.
+void ShipGrid::update()
+{
+	for(auto &trackedShip : m_trackedShips)
+	{
+		sf::IntRect newCells = getCellRange(trackedShip.entry.ship->getTickBounds());
+
+		//Most ticks a ship stays within the same cells, so there is nothing to do.
+		if(newCells != trackedShip.cells)
+		{
+			placeInCells(trackedShip, false);
+			trackedShip.cells = newCells;
+			placeInCells(trackedShip, true);
+		}
+	}
+}
+
+//Finds every ship in the cells the area overlaps.
+//	area : The area to find ships near, in global co-ordinates.
+//	candidates : Filled with the ships found, in list order; cleared first.
+void ShipGrid::query(const sf::FloatRect &area, std::vector<Ship*> &candidates) const
+{
+	//Ships found so far, with their order; one per thread, so it is reused without allocating, and workers may query at once.
+	static thread_local std::vector<CellEntry> queryBuffer;
+
+	candidates.clear();
+	queryBuffer.clear();
+
+	sf::IntRect cells = getCellRange(area);
+
+	for(int y = cells.top; y < cells.top + cells.height; ++y)
+	{
+		for(int x = cells.left; x < cells.left + cells.width; ++x)
+		{
+			for(const auto &entry : m_cells[y * m_gridSize.x + x])
+			{
+				//A ship spanning several cells the area also overlaps is only added once.
+				if(std::find_if(queryBuffer.begin(), queryBuffer.end(), [&entry](const CellEntry &found) { return found.ship == entry.ship; })
+					== queryBuffer.end())
+				{
+					queryBuffer.push_back(entry);
+				}
+			}
+		}
+	}
+
+	//Return the ships in list order, so the first ship hit is the same as when every ship was tested.
+	std::sort(queryBuffer.begin(), queryBuffer.end(), [](const CellEntry &lhs, const CellEntry &rhs)
+	{
+		return lhs.order < rhs.order;
+	});
+
+	for(const auto &entry : queryBuffer)
+	{
+		candidates.push_back(entry.ship);
+	}
+}
+
+//Returns the range of cells the area overlaps, clamped to the grid.
+//	area : The area in global co-ordinates.
+sf::IntRect ShipGrid::getCellRange(const sf::FloatRect &area) const
+{
+	//Cells of the top-left, and bottom-right, corners of the area.
+	int left = static_cast<int>(std::floor((area.left - m_area.left) / m_cellSize));
+	int top = static_cast<int>(std::floor((area.top - m_area.top) / m_cellSize));
+	int right = static_cast<int>(std::floor((area.left + area.width - m_area.left) / m_cellSize));
+	int bottom = static_cast<int>(std::floor((area.top + area.height - m_area.top) / m_cellSize));
+
+	//Anything outside of the grid is placed in the edge cells.
+	left = std::min(std::max(left, 0), m_gridSize.x - 1);
+	top = std::min(std::max(top, 0), m_gridSize.y - 1);
+	right = std::min(std::max(right, 0), m_gridSize.x - 1);
+	bottom = std::min(std::max(bottom, 0), m_gridSize.y - 1);
+
+	return {left, top, right - left + 1, bottom - top + 1};
+}
+
+//Adds, or removes, the tracked ship to each cell in its range.
+//	trackedShip : The ship being placed, or removed.
+//	isAdding : Whether the ship is being added to the cells; otherwise, it is removed.
+void ShipGrid::placeInCells(const TrackedShip &trackedShip, bool isAdding)
+{
+	const sf::IntRect &cells = trackedShip.cells;
+
+	for(int y = cells.top; y < cells.top + cells.height; ++y)
+	{
+		for(int x = cells.left; x < cells.left + cells.width; ++x)
+		{
+			auto &cell = m_cells[y * m_gridSize.x + x];
+
+			if(isAdding)
+			{
+				cell.push_back(trackedShip.entry);
+			}
+			else
+			{
+				auto it = std::find_if(cell.begin(), cell.end(), [&trackedShip](const CellEntry &entry)
+				{
+					return entry.ship == trackedShip.entry.ship;
+				});
+
+				//Cells are unordered, so swap-and-pop.
+				*it = cell.back();
+				cell.pop_back();
+			}
+		}
+	}
+}
@@ -0,0 +1,142 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "ShipRenderer.hpp"
+
+//Declared in an anonymous namespace to prevent name clashes.
+namespace
+{
+	constexpr float TURRET_SIZE = 32; //Width and height of a turret, and of its sprite in the atlas.
+}
+
+//Basic ShipRenderer constructor.
+//	hullTexture : Texture of the ship hull.
+//	turretAtlasTexture : Texture atlas for the turrets.
+//	damageShader : Damage shader shared by every ship; nullptr if shaders are unavailable, in which case damage is not shown.
+ShipRenderer::ShipRenderer(const sf::Texture *hullTexture, const sf::Texture *turretAtlasTexture, sf::Shader *damageShader)
+	:m_hullTexture(hullTexture), m_turretAtlasTexture(turretAtlasTexture), m_damageShader(damageShader), m_turretVertices(sf::Quads)
+{
+	//The hull is sampled from whichever texture is being drawn, so it is the same for every ship sharing the shader.
+	if(m_damageShader) m_damageShader->setUniform("texture", sf::Shader::CurrentTexture);
+}
+
+//Uploads each ship's damage, and rebuilds the turrets, from the snapshots; call once per frame before drawing.
+//	ships : Snapshots of the ships to draw; must stay unchanged until they have been drawn.
+//	interpolation : How far from their previous poses to draw the ships; 1 draws them where they are at the end of the tick.
+void ShipRenderer::update(const std::vector<ShipSnapshot> &ships, float interpolation)
+{
+	m_ships = &ships;
+	m_keyUploadBytes = 0;
+
+	//A key texture is kept for every ship; when a ship dies, those after it take over the texture before them,
+	//which only costs uploading the difference between the two ships' damage.
+	if(m_keyTextures.size() < ships.size()) m_keyTextures.resize(ships.size());
+
+	m_shipTransforms.resize(ships.size());
+	m_turretOffsets.resize(ships.size() + 1);
+	m_turretOffsets[0] = 0;
+
+	for(std::size_t i = 0; i < ships.size(); ++i)
+	{
+		const ShipSnapshot &ship = ships[i];
+
+		//Create the key texture the first time a ship is drawn in this position; it is filled by the first upload.
+		if(!m_keyTextures[i]) m_keyTextures[i] = std::make_unique<KeyTexture>();
+
+		uploadDamage(*m_keyTextures[i], ship.damage);
+
+		m_shipTransforms[i] = ship.getTransform(interpolation);
+
+		//Four vertices per turret; resizing keeps the memory of the larger size, so this only allocates when we pass the peak.
+		m_turretOffsets[i + 1] = m_turretOffsets[i] + ship.turrets.size() * 4;
+		m_turretVertices.resize(m_turretOffsets[i + 1]);
+
+		for(std::size_t j = 0; j < ship.turrets.size(); ++j)
+		{
+			const TurretSnapshot &turret = ship.turrets[j];
+
+			//Transform from the turret's sprite to global co-ordinates; the turret is rotated around its centre.
+			sf::Transform turretTransform = m_shipTransforms[i];
+			turretTransform.translate(turret.localPosition).rotate(CSB::lerpAngle(turret.previousRotation, turret.rotation, interpolation))
+				.translate(-TURRET_SIZE / 2.f, -TURRET_SIZE / 2.f);
+
+			//Left edge of the turret's sprite in the atlas; each projectile type has its own sprite.
+			const float atlasLeft = std::underlying_type_t<ProjectileType>(turret.projType) * TURRET_SIZE;
+			//The quad of this turret.
+			sf::Vertex *quad = &m_turretVertices[m_turretOffsets[i] + j * 4];
+
+			//Place the corners in the same winding as a rectangle shape; top-left, top-right, bottom-right, bottom-left.
+			quad[0].position = turretTransform.transformPoint(0, 0);
+			quad[1].position = turretTransform.transformPoint(TURRET_SIZE, 0);
+			quad[2].position = turretTransform.transformPoint(TURRET_SIZE, TURRET_SIZE);
+			quad[3].position = turretTransform.transformPoint(0, TURRET_SIZE);
+
+			quad[0].texCoords = {atlasLeft, 0};
+			quad[1].texCoords = {atlasLeft + TURRET_SIZE, 0};
+			quad[2].texCoords = {atlasLeft + TURRET_SIZE, TURRET_SIZE};
+			quad[3].texCoords = {atlasLeft, TURRET_SIZE};
+
+			quad[0].color = quad[1].color = quad[2].color = quad[3].color = sf::Color::White;
+		}
+	}
+}
+
+//Draws every ship, with its turrets drawn over it.
+//	target : What we will be drawing onto.
+//	states : Visual manipulations to the ships that are being drawn.
+void ShipRenderer::draw(sf::RenderTarget &target, sf::RenderStates states) const
+{
+	//Nothing has been given to draw yet.
+	if(!m_ships) return;
+
+	//Render states for the turrets; their quads are already in global co-ordinates.
+	sf::RenderStates turretStates = states;
+	turretStates.texture = m_turretAtlasTexture;
+
+	for(std::size_t i = 0; i < m_ships->size(); ++i)
+	{
+		const ShipSnapshot &ship = (*m_ships)[i];
+
+		//Custom render states that has a custom fragment shader to draw the ship damage.
+		sf::RenderStates shipDamageStates = states;
+		shipDamageStates.transform.combine(m_shipTransforms[i]);
+
+		//Put the shader in the render states, with this ship's key; the shader is shared, so the key is set every time a ship is drawn.
+		if(m_damageShader)
+		{
+			m_damageShader->setUniform("keyTexture", m_keyTextures[i]->texture);
+			shipDamageStates.shader = m_damageShader;
+		}
+
+		//Draw the body of the ship with the snapshot's transform; the sprite is left untransformed, so it is not computed again.
+		target.draw(sf::Sprite(*m_hullTexture, ship.textureRect), shipDamageStates);
+
+		//Draw the ship's turrets over it, with a single draw call.
+		if(m_turretOffsets[i + 1] != m_turretOffsets[i])
+		{
+			target.draw(&m_turretVertices[m_turretOffsets[i]], m_turretOffsets[i + 1] - m_turretOffsets[i], sf::Quads, turretStates);
+		}
+	}
+}
+
+//Uploads the area of the ship's damage that changed to its key texture.
+//	keyTexture : The ship's key texture.
+//	damage : The ship's current damage mask.
+void ShipRenderer::uploadDamage(KeyTexture &keyTexture, const DamageMask &damage)
+{
+	//Only the area that differs from what the texture already holds is uploaded; the whole mask, if it is new or a different size.
+	const sf::IntRect changedArea = damage.getChangedArea(keyTexture.uploaded);
+
+	if(changedArea.width == 0) return;
+
+	if(keyTexture.texture.getSize() != damage.getSize())
+	{
+		keyTexture.texture.create(damage.getSize().x, damage.getSize().y);
+	}
+
+	damage.getPixels(changedArea, m_keyPixels);
+	keyTexture.texture.update(m_keyPixels.data(), changedArea.width, changedArea.height, changedArea.left, changedArea.top);
+	keyTexture.uploaded = damage;
+
+	m_keyUploadBytes += m_keyPixels.size();
+}
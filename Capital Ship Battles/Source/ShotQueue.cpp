@@ -0,0 +1,66 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "ShotQueue.hpp"
+
+#include <algorithm> //For std::sort.
+
+//Basic ShotQueue constructor.
+//	capacity : How many shots a tick may fire before the queue falls back to a locked overflow list; grown to fit on each drain.
+ShotQueue::ShotQueue(std::size_t capacity)
+	:m_entries(capacity)
+{}
+
+//Queues a shot; may be called from any number of threads at once, but not while the queue is being drained.
+//	shot : The shot fired.
+//	fireOrder : Order of the turret that fired it; unique per turret, and the order the turrets are updated in a serial tick.
+void ShotQueue::push(const ShotInfo &shot, std::uint64_t fireOrder)
+{
+	//Claim the next slot; every thread gets a different one, so the write needs no lock.
+	const std::size_t slot = m_size.fetch_add(1, std::memory_order_relaxed);
+
+	if(slot < m_entries.size())
+	{
+		m_entries[slot] = {shot, fireOrder};
+	}
+	//Every slot has been claimed, so the shot goes to the overflow until the next drain makes room.
+	else
+	{
+		m_overflowMutex.lock();
+
+		m_overflow.push_back({shot, fireOrder});
+
+		m_overflowMutex.unlock();
+	}
+}
+
+//Moves every queued shot to the list, in fire order, and empties the queue; only call while nothing is pushing.
+//	shots : Filled with the shots; cleared first.
+void ShotQueue::drain(std::vector<ShotInfo> &shots)
+{
+	//How many shots were pushed; the slots that were claimed, with the overflow after them.
+	const std::size_t count = m_size.load(std::memory_order_acquire);
+
+	//Move the overflow after the slots, so every shot can be sorted together; the slots then stay large enough for a tick as busy as this.
+	if(count > m_entries.size())
+	{
+		m_entries.insert(m_entries.end(), m_overflow.begin(), m_overflow.end());
+		m_overflow.clear();
+	}
+
+	//Fire orders are unique per turret, and a turret fires at most once per tick; so the order does not depend on which worker pushed first.
+	std::sort(m_entries.begin(), m_entries.begin() + count, [](const Entry &lhs, const Entry &rhs)
+	{
+		return lhs.fireOrder < rhs.fireOrder;
+	});
+
+	shots.clear();
+	shots.reserve(count);
+
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		shots.push_back(m_entries[i].shot);
+	}
+
+	m_size.store(0, std::memory_order_relaxed);
+}
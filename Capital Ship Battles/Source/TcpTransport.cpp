@@ -0,0 +1,150 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "TcpTransport.hpp"
+
+//For setting Nagle's algorithm on the socket.
+#ifdef _WIN32
+#include <winsock2.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+//Sets whether the operating system may hold back small sends to merge them; only call while connected.
+//	isNagleEnabled : Whether Nagle's algorithm is enabled.
+void NetworkSocket::setNagleEnabled(bool isNagleEnabled)
+{
+	//TCP_NODELAY turns Nagle's algorithm off.
+	int isNoDelay = isNagleEnabled ? 0 : 1;
+
+	setsockopt(getHandle(), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&isNoDelay), sizeof(isNoDelay));
+}
+
+//Waits for a peer to connect; stopped by disconnect, from another thread.
+//	port : The port to wait on.
+//Returns whether a peer connected.
+bool TcpTransport::host(unsigned short port)
+{
+	//Listen on the defined port.
+	m_listener.listen(port);
+
+	//Accept the next client to connect to the server.
+	//If the socket is "Done", then it managed to gain a client.
+	if(m_listener.accept(m_socket) != sf::Socket::Done) return false;
+
+	onConnected();
+
+	return true;
+}
+
+//Connects to a peer waiting on the address; with a five second time-out.
+//	address : The address of the peer.
+//	port : The port the peer is waiting on.
+//Returns whether the peer was reached.
+bool TcpTransport::join(const sf::IpAddress &address, unsigned short port)
+{
+	if(m_socket.connect(address, port, sf::seconds(5)) != sf::Socket::Done) return false;
+
+	onConnected();
+
+	return true;
+}
+
+//Closes the connection, or stops connecting; safe to call from any thread.
+void TcpTransport::disconnect()
+{
+	//Stops any connection attempts.
+	m_listener.close();
+	//Close current connection.
+	m_socket.disconnect();
+}
+
+//Returns whether the peer is still connected.
+bool TcpTransport::isConnected() const
+{
+	return m_socket.getRemoteAddress() != sf::IpAddress::None;
+}
+
+//Queues the handshake, to be sent on the next flush.
+//	handshake : The bytes of the handshake.
+void TcpTransport::sendHandshake(std::vector<std::uint8_t> handshake)
+{
+	m_outgoing.push_back(std::move(handshake));
+}
+
+//Queues a flush of frames, to be sent on the next flush.
+//	frames : The bytes of the frames.
+void TcpTransport::sendFrames(std::vector<std::uint8_t> frames)
+{
+	m_outgoing.push_back(std::move(frames));
+}
+
+//Sends everything queued; only call from the network thread.
+void TcpTransport::flush()
+{
+	for(const auto &bytes : m_outgoing)
+	{
+		sf::Packet packet;
+		packet.append(bytes.data(), bytes.size());
+
+		m_socket.send(packet);
+	}
+
+	m_outgoing.clear();
+}
+
+//Waits, at most the timeout, for a packet to arrive from the peer; only call from the network thread.
+//	timeout : The longest to wait.
+//Returns whether the peer is still connected.
+bool TcpTransport::wait(const sf::Time &timeout)
+{
+	if(!m_selector.wait(timeout)) return isConnected();
+
+	//Holds data of most recently received packet.
+	sf::Packet packet;
+
+	if(m_socket.receive(packet) != sf::Socket::Done) return false;
+
+	const std::uint8_t *data = static_cast<const std::uint8_t*>(packet.getData());
+	m_incoming.emplace_back(data, data + packet.getDataSize());
+
+	return true;
+}
+
+//Takes the next packet from the peer; the handshake, then each flush of frames. Only call from the network thread.
+//	message : Set to the bytes of the packet.
+//Returns whether there was a packet.
+bool TcpTransport::receive(std::vector<std::uint8_t> &message)
+{
+	//Nothing more is handed on once disconnected; i.e. after the peer says it is leaving.
+	if(m_incoming.empty() || !isConnected()) return false;
+
+	message = std::move(m_incoming.front());
+	m_incoming.pop_front();
+
+	return true;
+}
+
+//Sets whether the operating system may hold back small sends to merge them; off by default, as frames are already batched.
+//Applied to the next connection.
+//	isNagleEnabled : Whether Nagle's algorithm is enabled.
+void TcpTransport::setNagleEnabled(bool isNagleEnabled)
+{
+	m_isNagleEnabled = isNagleEnabled;
+}
+
+//Sets up the socket once it has connected.
+void TcpTransport::onConnected()
+{
+	m_socket.setNagleEnabled(m_isNagleEnabled);
+
+	//Drop anything left from the last peer.
+	m_outgoing.clear();
+	m_incoming.clear();
+
+	m_selector.clear();
+	m_selector.add(m_socket);
+}
@@ -3,14 +3,22 @@
  */
 #include "Turret.hpp"
 
+#include <ostream> //For dumping the turret's state.
+
 #include "CSB_Functions.hpp" //For rotating the turret to face its target.
+#include "ShotQueue.hpp" //For queueing shots.
 
  //Construct a complete turret from the passed information.
  //	info : Information defining how the turret should be constructed.
  //	parentTransform : Transform of the turret's parent; used for transforming the turret to global co-ordinates.
+ //	parentInverseTransform : Inverse of the parent's transform; used for transforming the target to local co-ordinates.
  //	atlasTexture : Texture that holds all the different sprites the turret can use.
-Turret::Turret(TurretInfo info, const sf::Transform *parentTransform, const sf::Texture *atlasTexture)
-	:m_projType(info.projType), m_parentTransform(parentTransform)
+ //	shotQueue : Queue the turret's shots are pushed onto; nullptr for a turret that never fires, such as one being built.
+ //	fireOrder : Where the turret's shots are placed in the queue, relative to the other turrets; unique to each turret in the battle.
+Turret::Turret(TurretInfo info, const sf::Transform *parentTransform, const sf::Transform *parentInverseTransform, const sf::Texture *atlasTexture,
+	ShotQueue *shotQueue, std::uint64_t fireOrder)
+	:m_parentTransform(parentTransform), m_parentInverseTransform(parentInverseTransform), m_shotQueue(shotQueue), m_fireOrder(fireOrder),
+	m_projType(info.projType)
 {
 	setPosition(info.localPosition);
 	setSize({32, 32});
@@ -43,15 +51,41 @@ Turret::Turret(TurretInfo info, const sf::Transform *parentTransform, const sf::
 //	deltaTime : The amount of time that has passed since the turret was last updated.
 void Turret::update(sf::Time deltaTime)
 {
+	//Kept so the turret can be drawn turning smoothly between updates.
+	m_previousRotation = getRotation();
 	m_timeSinceLastShot += deltaTime;
 
 	//Rotate towards the target if the turret is tracking a target, and fire when the turret is facing the target.
-	if(m_isTrackingTarget && CSB::faceTargetAndCheck(*this, m_parentTransform->getInverse().transformPoint(m_targetPosition), deltaTime))
+	if(m_isTrackingTarget && CSB::faceTargetAndCheck(*this, m_parentInverseTransform->transformPoint(m_targetPosition), deltaTime))
 	{
 		fire();
 	}
 }
 
+//Mixes the turret's state into the hash; its type, rotation, target, and reload.
+//	hash : The hash to mix into.
+void Turret::hashState(StateHash &hash) const
+{
+	hash.mix(static_cast<std::uint64_t>(m_projType));
+	hash.mixFloat(getRotation());
+	//The target decides where the turret turns, and fires; the layer is only set along with it.
+	hash.mix(m_isTrackingTarget);
+	hash.mixFloat(m_targetPosition.x);
+	hash.mixFloat(m_targetPosition.y);
+	if(m_isTrackingTarget) hash.mix(m_targetlayer);
+	//The time since the last shot decides when the turret may next be ordered to fire.
+	hash.mix(static_cast<std::uint64_t>(m_timeSinceLastShot.asMicroseconds()));
+}
+
+//Writes the turret's state as text, with exact floats, on one line; as part of its ship's dump.
+//	stream : The stream to write to.
+void Turret::dumpState(std::ostream &stream) const
+{
+	stream << "\tturret " << static_cast<int>(m_projType) << " " << getPosition().x << " " << getPosition().y
+		<< " rotation " << getRotation() << " tracking " << m_isTrackingTarget << " target " << m_targetPosition.x << " "
+		<< m_targetPosition.y << " since shot " << m_timeSinceLastShot.asMicroseconds() << "\n";
+}
+
 //Orders the turret to fire at the specified target.
 //	target : Where the turret should fire at.
 //	layer : Which layer the shot should be fired onto.
@@ -66,10 +100,13 @@ void Turret::fireCommand(const sf::Vector2f & target, unsigned int layer)
 	}
 }
 
-//Pushes information on a projectile to be created onto the firing list.
+//Pushes information on a projectile to be created onto the shot queue.
 void Turret::fire()
 {
-	s_fireList->push_back({m_projType, m_targetlayer, m_parentTransform->transformPoint(getPosition()), m_targetPosition});
+	if(m_shotQueue)
+	{
+		m_shotQueue->push({m_projType, m_targetlayer, m_parentTransform->transformPoint(getPosition()), m_targetPosition}, m_fireOrder);
+	}
 
 	m_isTrackingTarget = false;
 	m_timeSinceLastShot = sf::seconds(0);
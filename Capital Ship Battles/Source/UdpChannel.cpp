@@ -0,0 +1,370 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "UdpChannel.hpp"
+
+#include <algorithm> //For std::min_element, std::max, and std::min.
+
+namespace
+{
+	const sf::Time INITIAL_RESEND_TIMEOUT = sf::milliseconds(200); //The resend timeout before the round trip has been measured.
+	const sf::Time MIN_RESEND_TIMEOUT = sf::milliseconds(20); //The shortest resend timeout; so a steady link does not resend early.
+	const sf::Time MAX_RESEND_TIMEOUT = sf::seconds(1); //The longest resend timeout.
+	const sf::Time HEARTBEAT_INTERVAL = sf::milliseconds(250); //The longest between datagrams; so the peer knows we are still there.
+	//How long an acknowledgement waits for a datagram to ride on; longer than a tick, so in lockstep it rides on the next frame.
+	const sf::Time ACK_DELAY = sf::milliseconds(20);
+	//How much longer than the latency a reordered datagram is held back, on top of it; so it is overtaken even with no latency.
+	const sf::Time REORDER_DELAY = sf::milliseconds(10);
+}
+
+//Queues a message on the reliable stream; sent once, then resent if it is not acknowledged within the resend timeout.
+//	message : The bytes of the message.
+void UdpChannel::sendReliable(std::vector<std::uint8_t> message)
+{
+	m_reliable.unacknowledged.push_back({m_reliable.nextNumber++, std::move(message)});
+}
+
+//Queues a message on the redundant stream; sent in every datagram until it is acknowledged.
+//	message : The bytes of the message.
+void UdpChannel::sendRedundant(std::vector<std::uint8_t> message)
+{
+	m_redundant.unacknowledged.push_back({m_redundant.nextNumber++, std::move(message)});
+}
+
+//Writes the next datagram to send to the peer, if anything is due.
+//	now : The current time.
+//	datagram : Set to the bytes of the datagram.
+//	isForced : Whether to write a datagram even if nothing is due; i.e. to greet the peer.
+//Returns whether a datagram was written.
+bool UdpChannel::writeDatagram(const sf::Time &now, std::vector<std::uint8_t> &datagram, bool isForced)
+{
+	const bool isDue = isForced || (m_isAckOwed && now - m_ackOwedSince >= ACK_DELAY) || now - m_lastSent >= HEARTBEAT_INTERVAL
+		|| isStreamDue(m_reliable, now) || isStreamDue(m_redundant, now);
+
+	if(!isDue) return false;
+
+	//The header; our sequence number, the peer's we last received, and how many of each stream's messages we have received.
+	WireWriter writer;
+	writer.writeVarint(m_nextSequence);
+	writer.writeVarint(m_latestReceived);
+	writer.writeVarint(m_reliable.received);
+	writer.writeVarint(m_redundant.received);
+
+	writeStream(writer, m_reliable, now, false);
+	writeStream(writer, m_redundant, now, true);
+
+	m_sendTimes[m_nextSequence % SEND_HISTORY] = {m_nextSequence, now};
+	++m_nextSequence;
+	m_isAckOwed = false;
+	m_lastSent = now;
+
+	datagram = writer.getBytes();
+
+	return true;
+}
+
+//Reads a datagram received from the peer; delivering any messages it completes, and acknowledging any of ours it acknowledges.
+//	data : The bytes of the datagram.
+//	size : How many bytes there are.
+//	now : The current time.
+//Returns whether the datagram was well-formed; a malformed datagram is ignored whole.
+bool UdpChannel::readDatagram(const void *data, std::size_t size, const sf::Time &now)
+{
+	WireReader reader(data, size);
+
+	const std::uint64_t sequence = reader.readVarint();
+	const std::uint64_t echoed = reader.readVarint();
+	const std::uint64_t reliableReceived = reader.readVarint();
+	const std::uint64_t redundantReceived = reader.readVarint();
+
+	//The messages of each stream, with their numbers; read whole before any is delivered, so a malformed datagram changes nothing.
+	std::vector<std::pair<std::uint64_t, std::vector<std::uint8_t>>> messages[2];
+
+	for(auto &streamMessages : messages)
+	{
+		const std::uint64_t count = reader.readVarint();
+
+		//Stop at the end of the bytes, so a malformed count can not make us build a huge list.
+		for(std::uint64_t i = 0; i < count && reader.isValid(); ++i)
+		{
+			streamMessages.emplace_back(reader.readVarint(), std::vector<std::uint8_t>());
+			reader.readBytes(streamMessages.back().second);
+		}
+	}
+
+	//Echoing a sequence number we never sent would mean the datagram is not from our peer.
+	if(!reader.isValid() || !reader.isAtEnd() || echoed > m_nextSequence) return false;
+
+	m_latestReceived = std::max(m_latestReceived, sequence + 1);
+
+	//Measure the round trip on the first echo of each datagram; later echoes of it have waited on the peer.
+	if(echoed > m_latestEchoed)
+	{
+		m_latestEchoed = echoed;
+
+		const SendTime &sent = m_sendTimes[(echoed - 1) % SEND_HISTORY];
+		if(sent.sequence == echoed - 1) measureRoundTrip(now - sent.time);
+	}
+
+	acknowledge(m_reliable, reliableReceived);
+	acknowledge(m_redundant, redundantReceived);
+
+	//Whether the datagram needs acknowledging; any new message does, as does a message on the reliable stream we already had,
+	//as it is only resent if our acknowledgement was lost. The redundant stream's messages are resent in every datagram,
+	//so acknowledging those we already had would have the peers acknowledge each other's acknowledgements forever.
+	bool isAckNeeded = false;
+
+	for(auto &message : messages[0])
+	{
+		deliver(m_reliable, message.first, std::move(message.second));
+		isAckNeeded = true;
+	}
+
+	for(auto &message : messages[1])
+	{
+		isAckNeeded = deliver(m_redundant, message.first, std::move(message.second)) || isAckNeeded;
+	}
+
+	if(isAckNeeded && !m_isAckOwed)
+	{
+		m_isAckOwed = true;
+		m_ackOwedSince = now;
+	}
+
+	return true;
+}
+
+//Takes the next message delivered on the reliable stream.
+//	message : Set to the bytes of the message.
+//Returns whether there was a message.
+bool UdpChannel::takeReliable(std::vector<std::uint8_t> &message)
+{
+	if(m_reliable.delivered.empty()) return false;
+
+	message = std::move(m_reliable.delivered.front());
+	m_reliable.delivered.pop_front();
+
+	return true;
+}
+
+//Takes the next message delivered on the redundant stream.
+//	message : Set to the bytes of the message.
+//Returns whether there was a message.
+bool UdpChannel::takeRedundant(std::vector<std::uint8_t> &message)
+{
+	if(m_redundant.delivered.empty()) return false;
+
+	message = std::move(m_redundant.delivered.front());
+	m_redundant.delivered.pop_front();
+
+	return true;
+}
+
+//Returns how long a message on the reliable stream waits to be acknowledged before it is resent.
+sf::Time UdpChannel::getResendTimeout() const
+{
+	if(m_smoothedRoundTrip == sf::Time::Zero) return INITIAL_RESEND_TIMEOUT;
+
+	//As TCP does; the round trip, with room for it to vary by four times as much as it has been.
+	return std::min(std::max(m_smoothedRoundTrip + m_roundTripVariation * 4.f, MIN_RESEND_TIMEOUT), MAX_RESEND_TIMEOUT);
+}
+
+//Forgets every message, and everything known about the peer; for a new connection.
+void UdpChannel::reset()
+{
+	*this = UdpChannel();
+}
+
+//Returns whether any message in the stream is due to be sent; either new, or unacknowledged past the resend timeout.
+//	stream : The stream to check.
+//	now : The current time.
+bool UdpChannel::isStreamDue(const Stream &stream, const sf::Time &now) const
+{
+	const sf::Time resendTimeout = getResendTimeout();
+
+	for(const auto &message : stream.unacknowledged)
+	{
+		if(!message.isSent || now - message.lastSent >= resendTimeout) return true;
+	}
+
+	return false;
+}
+
+//Writes the messages of the stream that are due into the datagram; every unacknowledged message, on the redundant stream.
+//	writer : The datagram being written.
+//	stream : The stream to write.
+//	now : The current time.
+//	isRedundant : Whether the stream is the redundant stream.
+void UdpChannel::writeStream(WireWriter &writer, Stream &stream, const sf::Time &now, bool isRedundant)
+{
+	const sf::Time resendTimeout = getResendTimeout();
+
+	//The messages written; oldest first, and as many as fit in the datagram, though always at least one.
+	std::vector<OutgoingMessage*> written;
+	//How big the datagram will be, with the messages written so far.
+	std::size_t size = writer.getBytes().size();
+
+	for(auto &message : stream.unacknowledged)
+	{
+		if(!isRedundant && message.isSent && now - message.lastSent < resendTimeout) continue;
+
+		//Each message also takes its number, and size; at most ten bytes each.
+		size += message.bytes.size() + 20;
+
+		if(size > MAX_DATAGRAM_SIZE && !written.empty()) break;
+
+		written.push_back(&message);
+	}
+
+	writer.writeVarint(written.size());
+
+	for(OutgoingMessage *message : written)
+	{
+		writer.writeVarint(message->number);
+		writer.writeBytes(message->bytes);
+
+		message->isSent = true;
+		message->lastSent = now;
+	}
+}
+
+//Removes the messages the peer has acknowledged from the stream.
+//	stream : The stream acknowledged.
+//	received : How many messages of the stream the peer has received.
+void UdpChannel::acknowledge(Stream &stream, std::uint64_t received)
+{
+	while(!stream.unacknowledged.empty() && stream.unacknowledged.front().number < received)
+	{
+		stream.unacknowledged.pop_front();
+	}
+}
+
+//Delivers a message received on the stream; or keeps it until those before it arrive. Duplicates are dropped.
+//	stream : The stream the message was received on.
+//	number : The message's place in the stream.
+//	bytes : The bytes of the message.
+//Returns whether the message was new; i.e. not a duplicate, nor too far ahead to keep.
+bool UdpChannel::deliver(Stream &stream, std::uint64_t number, std::vector<std::uint8_t> &&bytes)
+{
+	if(number < stream.received || number - stream.received > MAX_EARLY_MESSAGES) return false;
+
+	if(number > stream.received) return stream.early.emplace(number, std::move(bytes)).second;
+
+	stream.delivered.push_back(std::move(bytes));
+	++stream.received;
+
+	//Deliver every message kept that was waiting on this one.
+	for(auto early = stream.early.begin(); early != stream.early.end() && early->first == stream.received; early = stream.early.erase(early))
+	{
+		stream.delivered.push_back(std::move(early->second));
+		++stream.received;
+	}
+
+	return true;
+}
+
+//Adds a measurement of the round trip to the smoothed round trip.
+//	roundTrip : The round trip measured.
+void UdpChannel::measureRoundTrip(const sf::Time &roundTrip)
+{
+	//The first measurement is taken as it is; later ones are averaged in, as TCP does.
+	if(m_smoothedRoundTrip == sf::Time::Zero)
+	{
+		m_smoothedRoundTrip = roundTrip;
+		m_roundTripVariation = roundTrip / 2.f;
+	}
+	else
+	{
+		const sf::Time difference = m_smoothedRoundTrip > roundTrip ? m_smoothedRoundTrip - roundTrip : roundTrip - m_smoothedRoundTrip;
+
+		m_roundTripVariation = m_roundTripVariation * 0.75f + difference * 0.25f;
+		m_smoothedRoundTrip = m_smoothedRoundTrip * 0.875f + roundTrip * 0.125f;
+	}
+}
+
+//Basic ImpairedLink constructor.
+//	seed : Seed of the random choices; the same seed gives the same losses, and delays.
+ImpairedLink::ImpairedLink(unsigned int seed)
+	:m_random(seed)
+{}
+
+//Sets how badly the link drops, and delays, datagrams; applied to datagrams sent from now on.
+//	impairment : The model to impair datagrams by.
+void ImpairedLink::setImpairment(const LinkImpairment &impairment)
+{
+	m_impairment = impairment;
+}
+
+//Sends a datagram over the link; it is dropped, or held back until due, by the model.
+//	datagram : The bytes of the datagram.
+//	now : The current time.
+void ImpairedLink::send(std::vector<std::uint8_t> datagram, const sf::Time &now)
+{
+	if(m_impairment.lossRate > 0 && std::uniform_real_distribution<float>(0, 1)(m_random) < m_impairment.lossRate) return;
+
+	//When the datagram has been carried over the link; it waits for those before it, when the link is limited.
+	sf::Time sent = now;
+
+	if(m_impairment.bandwidth > 0)
+	{
+		m_linkFreeAt = std::max(m_linkFreeAt, now) + sf::microseconds(static_cast<sf::Int64>(datagram.size()) * 1000000 / m_impairment.bandwidth);
+		sent = m_linkFreeAt;
+	}
+
+	//Extra time this datagram is held back, on top of the latency.
+	sf::Time jitter = sf::microseconds(m_impairment.jitter.asMicroseconds() > 0
+		? std::uniform_int_distribution<sf::Int64>(0, m_impairment.jitter.asMicroseconds())(m_random) : 0);
+
+	if(m_impairment.reorderRate > 0 && std::uniform_real_distribution<float>(0, 1)(m_random) < m_impairment.reorderRate)
+	{
+		jitter += m_impairment.latency + REORDER_DELAY;
+	}
+
+	m_held.push_back({sent + m_impairment.latency + jitter, std::move(datagram)});
+}
+
+//Takes the datagram due soonest, if it is due.
+//	now : The current time.
+//	datagram : Set to the bytes of the datagram.
+//Returns whether a datagram was due.
+bool ImpairedLink::takeDue(const sf::Time &now, std::vector<std::uint8_t> &datagram)
+{
+	const auto soonest = findSoonest();
+
+	if(soonest == m_held.end() || soonest->due > now) return false;
+
+	datagram = std::move(m_held[soonest - m_held.begin()].bytes);
+	m_held.erase(soonest);
+
+	return true;
+}
+
+//Finds when the datagram due soonest is let through.
+//	due : Set to when the datagram is due.
+//Returns whether any datagram is being held back.
+bool ImpairedLink::getNextDue(sf::Time &due) const
+{
+	const auto soonest = findSoonest();
+
+	if(soonest == m_held.end()) return false;
+
+	due = soonest->due;
+
+	return true;
+}
+
+//Drops every datagram being held back.
+void ImpairedLink::clear()
+{
+	m_held.clear();
+	m_linkFreeAt = sf::Time::Zero;
+}
+
+//Returns the datagram held back due soonest; the first sent, of those due at the same time.
+std::vector<ImpairedLink::HeldDatagram>::const_iterator ImpairedLink::findSoonest() const
+{
+	return std::min_element(m_held.begin(), m_held.end(), [](const HeldDatagram &lhs, const HeldDatagram &rhs)
+	{
+		return lhs.due < rhs.due;
+	});
+}
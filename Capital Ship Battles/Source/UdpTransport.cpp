@@ -0,0 +1,168 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "UdpTransport.hpp"
+
+namespace
+{
+	const sf::Time JOIN_TIMEOUT = sf::seconds(5); //How long to wait for the host to answer, when joining.
+	const sf::Time GREETING_INTERVAL = sf::milliseconds(250); //How often to greet the host, until it answers.
+	const sf::Time HOST_POLL_INTERVAL = sf::milliseconds(100); //How often the host checks whether hosting was stopped.
+}
+
+//Waits for a player to send a datagram; stopped by disconnect, from another thread.
+//	port : The port to wait on.
+//Returns whether a player joined.
+bool UdpTransport::host(unsigned short port)
+{
+	if(!bind(port)) return false;
+
+	std::size_t received;
+
+	//Take whoever sends the first well-formed datagram as the peer; there is no listener, as UDP has no connections.
+	while(m_isOpen)
+	{
+		if(!m_selector.wait(HOST_POLL_INTERVAL)) continue;
+
+		if(m_socket.receive(m_buffer.data(), m_buffer.size(), received, m_peerAddress, m_peerPort) == sf::Socket::Done
+			&& readDatagram(m_buffer.data(), received))
+		{
+			//Answer, so the peer knows we are here.
+			sendDue(true);
+
+			return true;
+		}
+	}
+
+	m_socket.unbind();
+
+	return false;
+}
+
+//Greets the host until it answers; for at most five seconds.
+//	address : The address of the host.
+//	port : The port the host is waiting on.
+//Returns whether the host answered.
+bool UdpTransport::join(const sf::IpAddress &address, unsigned short port)
+{
+	m_peerAddress = address;
+	m_peerPort = port;
+
+	if(!bind(sf::Socket::AnyPort)) return false;
+
+	std::vector<std::uint8_t> datagram;
+	sf::Clock joinClock;
+
+	//Greet the host until it answers; the greeting is an empty datagram of the reliability layer.
+	while(m_isOpen && joinClock.getElapsedTime() < JOIN_TIMEOUT)
+	{
+		sendDue(true);
+
+		if(!m_selector.wait(GREETING_INTERVAL)) continue;
+
+		//The host's answer; or its handshake, if the answer was lost.
+		if(receiveDatagram(datagram) && readDatagram(datagram.data(), datagram.size())) return true;
+	}
+
+	m_isOpen = false;
+	m_socket.unbind();
+
+	return false;
+}
+
+//Sends a datagram, if the reliability layer has anything due, and lets through whatever the link has due; only call from the network thread.
+void UdpTransport::flush()
+{
+	ChannelTransport::flush();
+
+	sendHeld();
+}
+
+//Waits, at most the timeout, for datagrams from the peer, and reads every one that arrived; only call from the network thread.
+//Closes the socket once the peer has gone.
+//	timeout : The longest to wait.
+//Returns whether the peer is still connected.
+bool UdpTransport::wait(const sf::Time &timeout)
+{
+	if(ChannelTransport::wait(timeout)) return true;
+
+	m_socket.unbind();
+
+	return false;
+}
+
+//Sets how badly what is sent is dropped, and delayed, before it reaches the socket; for testing. Only call while not connected.
+//	impairment : The model to impair datagrams by.
+void UdpTransport::setImpairment(const LinkImpairment &impairment)
+{
+	m_link.setImpairment(impairment);
+}
+
+//Sends a datagram to the peer, through the link.
+//	datagram : The bytes of the datagram.
+void UdpTransport::sendDatagram(std::vector<std::uint8_t> datagram)
+{
+	m_link.send(std::move(datagram), getTime());
+
+	sendHeld();
+}
+
+//Waits, at most the timeout, for a datagram to arrive on the socket.
+//	timeout : The longest to wait.
+//Returns whether a datagram arrived.
+bool UdpTransport::waitForDatagram(const sf::Time &timeout)
+{
+	return m_selector.wait(timeout);
+}
+
+//Takes the next datagram from the peer, without waiting; ignoring any not from the peer.
+//	datagram : Set to the bytes of the datagram.
+//Returns whether there was a datagram.
+bool UdpTransport::receiveDatagram(std::vector<std::uint8_t> &datagram)
+{
+	std::size_t received;
+	sf::IpAddress address;
+	unsigned short port;
+
+	while(m_socket.receive(m_buffer.data(), m_buffer.size(), received, address, port) == sf::Socket::Done)
+	{
+		if(address == m_peerAddress && port == m_peerPort)
+		{
+			datagram.assign(m_buffer.begin(), m_buffer.begin() + received);
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//Binds the socket, and starts a new connection.
+//	port : The port to bind to.
+//Returns whether the socket was bound.
+bool UdpTransport::bind(unsigned short port)
+{
+	m_link.clear();
+
+	if(m_socket.bind(port) != sf::Socket::Done) return false;
+
+	m_socket.setBlocking(false);
+
+	m_selector.clear();
+	m_selector.add(m_socket);
+
+	open();
+
+	return true;
+}
+
+//Lets through whatever the link has due to the peer.
+void UdpTransport::sendHeld()
+{
+	std::vector<std::uint8_t> datagram;
+
+	while(m_link.takeDue(getTime(), datagram))
+	{
+		m_socket.send(datagram.data(), datagram.size(), m_peerAddress, m_peerPort);
+	}
+}
@@ -0,0 +1,317 @@
+/*
+ * Author: George Mostyn-Parry
+ */
+#include "WireFormat.hpp"
+
+#include <algorithm> //For std::clamp.
+#include <cmath> //For rounding, and wrapping angles.
+
+namespace
+{
+	//Returns the steps a co-ordinate on the battlefield is sent as; clamped to 16 bits.
+	//	value : The co-ordinate.
+	std::uint16_t fieldSteps(float value)
+	{
+		return static_cast<std::uint16_t>(std::clamp(std::round(value * Wire::FIELD_POSITION_SCALE), 0.f, 65535.f));
+	}
+
+	//Returns the steps a co-ordinate on the hull is sent as.
+	//	value : The co-ordinate.
+	std::int64_t hullSteps(float value)
+	{
+		return std::llround(value * Wire::HULL_POSITION_SCALE);
+	}
+
+	//Returns the steps an angle is sent as.
+	//	angle : The angle, in degrees.
+	std::uint16_t angleSteps(float angle)
+	{
+		//The angle wrapped to between 0 and 360.
+		const float wrapped = std::fmod(std::fmod(angle, 360.f) + 360.f, 360.f);
+
+		//A wrapped angle just below 360 rounds up to a whole turn; the cast wraps it back to 0.
+		return static_cast<std::uint16_t>(std::lround(wrapped / 360.f * Wire::ANGLE_STEPS) & 0xFFFF);
+	}
+
+	//Returns the angle sent as the steps; exact, as 360 / 65536 is 45 / 8192.
+	//	steps : The steps of the angle.
+	float angleFromSteps(std::uint16_t steps)
+	{
+		return static_cast<float>(steps * 45u) / 8192.f;
+	}
+}
+
+//Rounds a position on the battlefield to the nearest value the format can carry; clamped to the area it can carry.
+//	position : The position to quantise.
+//Returns the position the peer will receive.
+sf::Vector2f Wire::quantiseFieldPosition(const sf::Vector2f &position)
+{
+	return sf::Vector2f(fieldSteps(position.x), fieldSteps(position.y)) / FIELD_POSITION_SCALE;
+}
+
+//Rounds a turret's position on the hull to the nearest value the format can carry.
+//	position : The position to quantise.
+//Returns the position the peer will receive.
+sf::Vector2f Wire::quantiseHullPosition(const sf::Vector2f &position)
+{
+	return sf::Vector2f(static_cast<float>(hullSteps(position.x)), static_cast<float>(hullSteps(position.y))) / HULL_POSITION_SCALE;
+}
+
+//Rounds an angle to the nearest value the format can carry; wrapped to between 0 and 360.
+//	angle : The angle to quantise, in degrees.
+//Returns the angle the peer will receive.
+float Wire::quantiseAngle(float angle)
+{
+	return angleFromSteps(angleSteps(angle));
+}
+
+//Quantises every value in the command the format carries; so the sender carries out the same command the peer receives.
+//	command : The command to quantise.
+void Wire::quantiseCommand(BattleCommand &command)
+{
+	command.position = quantiseFieldPosition(command.position);
+	command.angle = quantiseAngle(command.angle);
+
+	for(auto &turret : command.turrets)
+	{
+		turret.localPosition = quantiseHullPosition(turret.localPosition);
+	}
+}
+
+//Writes a single byte.
+//	value : The byte to write.
+void WireWriter::writeByte(std::uint8_t value)
+{
+	m_bytes.push_back(value);
+}
+
+//Writes an unsigned integer as a varint; seven bits per byte, lowest first, with the top bit set on every byte but the last.
+//	value : The integer to write.
+void WireWriter::writeVarint(std::uint64_t value)
+{
+	while(value >= 0x80)
+	{
+		m_bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+
+	m_bytes.push_back(static_cast<std::uint8_t>(value));
+}
+
+//Writes a signed integer as a varint; zig-zag encoded first, so small negative values are small too.
+//	value : The integer to write.
+void WireWriter::writeSignedVarint(std::int64_t value)
+{
+	//Interleave the signs; 0, -1, 1, -2, 2 become 0, 1, 2, 3, 4.
+	writeVarint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+//Writes an unsigned 16 bit integer, lowest byte first.
+//	value : The integer to write.
+void WireWriter::writeUint16(std::uint16_t value)
+{
+	m_bytes.push_back(static_cast<std::uint8_t>(value));
+	m_bytes.push_back(static_cast<std::uint8_t>(value >> 8));
+}
+
+//Writes an unsigned 64 bit integer, lowest byte first.
+//	value : The integer to write.
+void WireWriter::writeUint64(std::uint64_t value)
+{
+	for(int i = 0; i < 8; ++i)
+	{
+		m_bytes.push_back(static_cast<std::uint8_t>(value >> (i * 8)));
+	}
+}
+
+//Writes a run of bytes as they are, after their count as a varint.
+//	bytes : The bytes to write.
+void WireWriter::writeBytes(const std::vector<std::uint8_t> &bytes)
+{
+	writeVarint(bytes.size());
+	m_bytes.insert(m_bytes.end(), bytes.begin(), bytes.end());
+}
+
+//Writes a position on the battlefield; see Wire::quantiseFieldPosition.
+//	position : The position to write.
+void WireWriter::writeFieldPosition(const sf::Vector2f &position)
+{
+	writeUint16(fieldSteps(position.x));
+	writeUint16(fieldSteps(position.y));
+}
+
+//Writes a turret's position on the hull; see Wire::quantiseHullPosition.
+//	position : The position to write.
+void WireWriter::writeHullPosition(const sf::Vector2f &position)
+{
+	writeSignedVarint(hullSteps(position.x));
+	writeSignedVarint(hullSteps(position.y));
+}
+
+//Writes an angle; see Wire::quantiseAngle.
+//	angle : The angle to write, in degrees.
+void WireWriter::writeAngle(float angle)
+{
+	writeUint16(angleSteps(angle));
+}
+
+//Writes a command; the ship, and position, of a move, or fire, command, or the ship a create command builds.
+//The command type, tick, and layers are not written; the message type, the frame it is in, and who sent it, imply them.
+//	command : The command to write.
+void WireWriter::writeCommand(const BattleCommand &command)
+{
+	if(command.type == CommandType::CREATE_SHIP)
+	{
+		writeFieldPosition(command.position);
+		writeAngle(command.angle);
+		writeVarint(command.turrets.size());
+
+		for(const auto &turret : command.turrets)
+		{
+			writeByte(static_cast<std::uint8_t>(turret.projType));
+			writeHullPosition(turret.localPosition);
+		}
+	}
+	else
+	{
+		writeVarint(command.shipID);
+		writeFieldPosition(command.position);
+	}
+}
+
+//Basic WireReader constructor.
+//	data : The bytes to read; must outlive the reader.
+//	size : How many bytes there are.
+WireReader::WireReader(const void *data, std::size_t size)
+	:m_data(static_cast<const std::uint8_t*>(data)), m_size(size)
+{}
+
+//Reads a single byte.
+std::uint8_t WireReader::readByte()
+{
+	if(m_readPosition >= m_size)
+	{
+		m_isValid = false;
+		return 0;
+	}
+
+	return m_data[m_readPosition++];
+}
+
+//Reads an unsigned varint; invalidates the reader if it is longer than 64 bits.
+std::uint64_t WireReader::readVarint()
+{
+	std::uint64_t value = 0;
+
+	for(unsigned int shift = 0; shift < 64; shift += 7)
+	{
+		const std::uint8_t byte = readByte();
+		value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+
+		if(!(byte & 0x80)) return value;
+	}
+
+	m_isValid = false;
+	return 0;
+}
+
+//Reads a zig-zag encoded signed varint.
+std::int64_t WireReader::readSignedVarint()
+{
+	const std::uint64_t value = readVarint();
+
+	return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+//Reads an unsigned 16 bit integer, lowest byte first.
+std::uint16_t WireReader::readUint16()
+{
+	const std::uint16_t low = readByte();
+
+	return static_cast<std::uint16_t>(low | readByte() << 8);
+}
+
+//Reads an unsigned 64 bit integer, lowest byte first.
+std::uint64_t WireReader::readUint64()
+{
+	std::uint64_t value = 0;
+
+	for(int i = 0; i < 8; ++i)
+	{
+		value |= static_cast<std::uint64_t>(readByte()) << (i * 8);
+	}
+
+	return value;
+}
+
+//Reads a run of bytes written by writeBytes; invalidates the reader if the count runs past the end.
+//	bytes : Set to the bytes read.
+void WireReader::readBytes(std::vector<std::uint8_t> &bytes)
+{
+	const std::uint64_t count = readVarint();
+
+	bytes.clear();
+
+	//Check the count against the bytes left, rather than reading it; a malformed count could be huge.
+	if(!m_isValid || count > m_size - m_readPosition)
+	{
+		m_isValid = false;
+		return;
+	}
+
+	bytes.assign(m_data + m_readPosition, m_data + m_readPosition + count);
+	m_readPosition += static_cast<std::size_t>(count);
+}
+
+//Reads a position on the battlefield.
+sf::Vector2f WireReader::readFieldPosition()
+{
+	const float x = readUint16();
+
+	return sf::Vector2f(x, readUint16()) / Wire::FIELD_POSITION_SCALE;
+}
+
+//Reads a turret's position on the hull.
+sf::Vector2f WireReader::readHullPosition()
+{
+	const float x = static_cast<float>(readSignedVarint());
+
+	return sf::Vector2f(x, static_cast<float>(readSignedVarint())) / Wire::HULL_POSITION_SCALE;
+}
+
+//Reads an angle, in degrees.
+float WireReader::readAngle()
+{
+	return angleFromSteps(readUint16());
+}
+
+//Reads a command written by writeCommand.
+//	command : Its type must be set, as it decides what is read; the values read are set on it.
+void WireReader::readCommand(BattleCommand &command)
+{
+	if(command.type == CommandType::CREATE_SHIP)
+	{
+		command.position = readFieldPosition();
+		command.angle = readAngle();
+
+		const std::uint64_t turretCount = readVarint();
+
+		//Stop at the end of the bytes, so a malformed count can not make us build a huge list.
+		for(std::uint64_t i = 0; i < turretCount && m_isValid; ++i)
+		{
+			const std::uint8_t rawProjType = readByte();
+
+			//A type we do not know would index past the projectile table.
+			if(rawProjType > static_cast<std::uint8_t>(ProjectileType::PLASMA)) m_isValid = false;
+
+			const ProjectileType projType = static_cast<ProjectileType>(rawProjType);
+
+			command.turrets.push_back({projType, readHullPosition()});
+		}
+	}
+	else
+	{
+		command.shipID = static_cast<unsigned int>(readVarint());
+		command.position = readFieldPosition();
+	}
+}
@@ -13,16 +13,121 @@
  * Battle mode has a zoom function; it will keep the mouse cursor over the same global co-ordinate when zooming out,
  * and keep the point zoomed in on in-view, as long as it does not cause the view to leave the view boundaries of the battle;
  * represent by a white ring when fully zoomed out.
+ *
+ * Usage: CapitalShipBattles [--pacing=vsync|cap|change|unlimited] [--fps=cap] [--tick-rate=ticks per second]
+ *	[--max-catch-up=ticks per cycle] [--time-dilation] [--frame-stats] [--tick-stats] [--lockstep] [--input-delay=ticks]
+ *	[--flush-latency=milliseconds] [--nagle] [--udp] [--udp-loss=percent] [--udp-latency=milliseconds] [--udp-jitter=milliseconds]
+ *	[--udp-reorder=percent] [--udp-bandwidth=bytes per second] [--dedicated]
+ * The pacing decides how often frames are presented; "change" only presents a frame when something changed, for kiosks left idle.
+ * The tick rate defaults to 60; frames are interpolated between ticks, so a lower rate saves CPU without looking any less smooth.
+ * Both players of a networked battle must use the same tick rate; a peer with another tick rate, or lockstep settings, is refused.
+ * A slow tick is caught up on by at most 5 ticks per cycle of the main loop, and any further backlog is dropped;
+ * with time dilation, the game also slows down while it cannot keep up, instead of dropping ticks over and over.
+ * Time spent waiting on the peer in lockstep is not caught up on, or counted as late, or dropped, ticks; nor does it dilate time.
+ * With lockstep, a networked battle only sends commands, and both players run every tick with the same commands;
+ * each command is carried out the input delay after it is given, which defaults to 4 ticks. Both players must use the same options, and build.
+ * Everything sent to the peer during a tick is batched into one frame; the network thread sends the frames closed so far
+ * at least every flush latency, which defaults to 5 milliseconds, up to a second. In lockstep, the input delay should cover the round trip plus the latency.
+ * Nagle's algorithm is disabled on the connection, so frames are not held back by the operating system; unless "--nagle" is given.
+ * With "--udp", players connect over UDP rather than TCP, so a lost packet does not hold back the commands after it; both players must use it.
+ * The loss, latency, jitter, reorder, and bandwidth options drop, delay, and throttle what is sent over UDP by that much; for testing on loopback.
+ * With "--dedicated", joining connects to a dedicated server rather than to another player; the server pairs the player with another,
+ * and decides who plays as the host, and the lockstep settings. Dedicated servers only take TCP, at the default tick rate of 60;
+ * so "--udp", and "--tick-rate", are ignored with "--dedicated".
+ * The latency, and jitter, are at most a minute.
+ * An unknown option, or an invalid value, is reported and ignored.
  */
+#include <iostream> //For reporting unknown options.
 #include <memory> //For make_unique.
+#include <string> //For parsing the command line.
 
+#include "CommandLine.hpp" //For parsing the values of options.
+#include "CSB_Functions.hpp" //For the default tick rate.
 #include "GameManager.hpp" //State manager controlling execution of the application.
 #include "BuildState.hpp" //The starting state.
 
-int main()
+int main(int argc, char *argv[])
 {	
 	//The manager for the game that will handle the execution of the program.
 	GameManager game;
+
+	//How frames are paced, and the frame rate cap used by "cap".
+	FramePacing pacing = FramePacing::VSYNC;
+	unsigned int frameRateCap = 60;
+	//How many ticks are run per second.
+	unsigned int tickRate = CSB::DEFAULT_TICK_RATE;
+	//The most ticks run per cycle of the main loop, and whether the game slows down when it cannot keep up.
+	unsigned int maxTicksPerCycle = 5;
+	bool isTimeDilated = false;
+	//Whether networked battles run in lockstep, and how many ticks commands are delayed by in lockstep.
+	bool isLockstep = false;
+	unsigned int inputDelay = 4;
+	//The longest closed frames wait before being sent, and whether the operating system may hold back small sends.
+	unsigned int flushLatency = 5;
+	bool isNagleEnabled = false;
+	//Whether to connect over UDP, and how badly to impair what is sent over it;
+	//the loss, and reordering, as percentages, the delays in milliseconds, and the bandwidth in bytes per second.
+	bool isUdpEnabled = false;
+	float lossPercent = 0;
+	unsigned int latency = 0;
+	unsigned int jitter = 0;
+	float reorderPercent = 0;
+	unsigned int bandwidth = 0;
+	//Whether joining connects to a dedicated server.
+	bool isDedicatedServer = false;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string option = argv[i];
+
+		if(option == "--pacing=vsync") pacing = FramePacing::VSYNC;
+		else if(option == "--pacing=cap") pacing = FramePacing::FIXED_CAP;
+		else if(option == "--pacing=change") pacing = FramePacing::ON_CHANGE;
+		else if(option == "--pacing=unlimited") pacing = FramePacing::UNLIMITED;
+		else if(option.compare(0, 6, "--fps=") == 0) CSB::parseOption(option, 6, frameRateCap);
+		else if(option.compare(0, 12, "--tick-rate=") == 0) CSB::parseOption(option, 12, tickRate);
+		else if(option.compare(0, 15, "--max-catch-up=") == 0) CSB::parseOption(option, 15, maxTicksPerCycle);
+		else if(option == "--time-dilation") isTimeDilated = true;
+		else if(option == "--frame-stats") game.setFrameStatsEnabled(true);
+		else if(option == "--tick-stats") game.setTickStatsEnabled(true);
+		else if(option == "--lockstep") isLockstep = true;
+		else if(option.compare(0, 14, "--input-delay=") == 0) CSB::parseOption(option, 14, inputDelay);
+		else if(option.compare(0, 16, "--flush-latency=") == 0) CSB::parseOption(option, 16, flushLatency, 1000u);
+		else if(option == "--nagle") isNagleEnabled = true;
+		else if(option == "--udp") isUdpEnabled = true;
+		else if(option.compare(0, 11, "--udp-loss=") == 0) CSB::parseOption(option, 11, lossPercent, 100.f);
+		else if(option.compare(0, 14, "--udp-latency=") == 0) CSB::parseOption(option, 14, latency, 60000u);
+		else if(option.compare(0, 13, "--udp-jitter=") == 0) CSB::parseOption(option, 13, jitter, 60000u);
+		else if(option.compare(0, 14, "--udp-reorder=") == 0) CSB::parseOption(option, 14, reorderPercent, 100.f);
+		else if(option.compare(0, 16, "--udp-bandwidth=") == 0) CSB::parseOption(option, 16, bandwidth);
+		else if(option == "--dedicated") isDedicatedServer = true;
+		else std::cerr << "Unknown option: " << option << std::endl;
+	}
+
+	//A dedicated server only takes players over TCP.
+	if(isDedicatedServer && isUdpEnabled)
+	{
+		std::cerr << "Dedicated servers only take TCP; ignoring \"--udp\"." << std::endl;
+		isUdpEnabled = false;
+	}
+
+	//A dedicated server plays every match at the default tick rate; a player at any other would be refused.
+	if(isDedicatedServer && tickRate != CSB::DEFAULT_TICK_RATE)
+	{
+		std::cerr << "Dedicated servers play at " << CSB::DEFAULT_TICK_RATE << " ticks per second; ignoring \"--tick-rate\"." << std::endl;
+		tickRate = CSB::DEFAULT_TICK_RATE;
+	}
+
+	game.setTickRate(tickRate);
+	game.setFramePacing(pacing, frameRateCap);
+	game.setCatchUp(maxTicksPerCycle, isTimeDilated);
+	game.getNetworkManager().setLockstep(isLockstep, inputDelay);
+	game.getNetworkManager().setFlushLatency(sf::milliseconds(flushLatency));
+	game.getNetworkManager().setNagleEnabled(isNagleEnabled);
+	game.getNetworkManager().setUdpEnabled(isUdpEnabled);
+	game.getNetworkManager().setImpairment({lossPercent / 100.f, sf::milliseconds(latency), sf::milliseconds(jitter), reorderPercent / 100.f,
+		bandwidth});
+	game.getNetworkManager().setDedicatedServer(isDedicatedServer);
 	//Start the game in the build state.
 	game.setState(std::make_unique<BuildState>(game));
 	//Launch the game, which will end when the window closes.
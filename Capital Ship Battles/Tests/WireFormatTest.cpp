@@ -0,0 +1,260 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Checks the wire format packets are sent between peers in; registered with CTest, so it runs on every build.
+ * First, the handshake, the match a dedicated server sends, and frames of each kind of message, are encoded,
+ * and compared byte for byte against their golden encoding; then decoded, and compared against the values they were encoded from.
+ * Any difference means peers built from this tree would not understand peers built before it,
+ * so either the change is a mistake, or Wire::VERSION must be bumped and the golden bytes updated.
+ * Then random commands, and ships, are round-tripped; each must decode to exactly its quantised values.
+ * Exits non-zero if any check fails.
+ *
+ * Usage: WireFormatTest
+ */
+#include <cstdint> //For the golden bytes.
+#include <iomanip> //For printing bytes.
+#include <iostream> //For reporting the results.
+#include <random> //For the round-trip values.
+#include <vector> //For the golden bytes.
+
+#include "WireFormat.hpp" //The format being checked.
+
+namespace
+{
+	//The message types, as NetworkManager's PacketType sends them; it is not included, as it needs the network module.
+	const std::uint8_t CONNECT = 0, MOVE = 2, FIRE = 3, STATE_HASH = 4, MATCH = 5;
+
+	//Prints the bytes as hex.
+	//	bytes : The bytes to print.
+	void printBytes(const std::vector<std::uint8_t> &bytes)
+	{
+		std::cout << std::hex << std::setfill('0');
+
+		for(std::uint8_t byte : bytes)
+		{
+			std::cout << " " << std::setw(2) << static_cast<int>(byte);
+		}
+
+		std::cout << std::dec << std::setfill(' ');
+	}
+
+	//Compares the bytes written against the golden bytes, and reports any difference.
+	//	name : Name of the packet being checked.
+	//	writer : Holds the bytes written.
+	//	golden : The bytes the packet must be encoded as.
+	//Returns whether the bytes matched.
+	bool checkGolden(const char *name, const WireWriter &writer, const std::vector<std::uint8_t> &golden)
+	{
+		const bool isMatch = writer.getBytes() == golden;
+
+		std::cout << name << ": " << writer.getBytes().size() << " bytes, " << (isMatch ? "matches golden" : "MISMATCH") << "\n";
+
+		if(!isMatch)
+		{
+			std::cout << "\twritten:";
+			printBytes(writer.getBytes());
+			std::cout << "\n\tgolden: ";
+			printBytes(golden);
+			std::cout << "\n";
+		}
+
+		return isMatch;
+	}
+
+	//Returns whether two commands carry the same values; only the values the format carries are compared.
+	//	lhs : The first command.
+	//	rhs : The second command.
+	bool isSameCommand(const BattleCommand &lhs, const BattleCommand &rhs)
+	{
+		if(lhs.position != rhs.position) return false;
+
+		if(lhs.type != CommandType::CREATE_SHIP) return lhs.shipID == rhs.shipID;
+
+		if(lhs.angle != rhs.angle || lhs.turrets.size() != rhs.turrets.size()) return false;
+
+		for(std::size_t i = 0; i < lhs.turrets.size(); ++i)
+		{
+			if(lhs.turrets[i].projType != rhs.turrets[i].projType || lhs.turrets[i].localPosition != rhs.turrets[i].localPosition) return false;
+		}
+
+		return true;
+	}
+
+	//Decodes a command from the bytes, and compares it against the command expected.
+	//	name : Name of the packet being checked.
+	//	bytes : The bytes of the packet.
+	//	offset : Index of the first byte of the command; after the frame's header and the type, or the type, version and settings for a ship.
+	//	expected : The command the bytes must decode to.
+	//Returns whether the command decoded matched, and used every byte.
+	bool checkDecode(const char *name, const std::vector<std::uint8_t> &bytes, std::size_t offset, const BattleCommand &expected)
+	{
+		WireReader reader(bytes.data() + offset, bytes.size() - offset);
+		BattleCommand decoded;
+		decoded.type = expected.type;
+		reader.readCommand(decoded);
+
+		const bool isMatch = reader.isValid() && reader.isAtEnd() && isSameCommand(decoded, expected);
+
+		if(!isMatch) std::cout << name << ": decoded MISMATCH\n";
+
+		return isMatch;
+	}
+
+	//Returns a random ship, with its values quantised; with turrets anywhere on a 128 pixel hull, on any quarter pixel.
+	//	random : The generator to draw from.
+	BattleCommand randomShip(std::mt19937 &random)
+	{
+		std::uniform_real_distribution<float> field(0, 4000), angle(0, 360), hull(0, 128);
+
+		BattleCommand ship;
+		ship.type = CommandType::CREATE_SHIP;
+		ship.position = {field(random), field(random)};
+		ship.angle = angle(random);
+
+		for(int i = 0; i < 16; ++i)
+		{
+			ship.turrets.push_back({static_cast<ProjectileType>(random() % 3), {hull(random), hull(random)}});
+		}
+
+		Wire::quantiseCommand(ship);
+
+		return ship;
+	}
+
+	//Encodes the handshake, the match message, and a frame of each kind of message, and checks them against their golden bytes;
+	//and that they decode to what they were encoded from.
+	//Returns whether every packet matched.
+	bool checkGoldenPackets()
+	{
+		//Whether every packet matched.
+		bool isCorrect = true;
+
+		//A frame of tick 300 holding a move command, as the joining player would send it; the frame's header, then the message.
+		BattleCommand move;
+		move.type = CommandType::MOVE;
+		move.position = {1234.5f, 2000.25f};
+
+		WireWriter writer;
+		writer.writeVarint(300);
+		writer.writeVarint(1);
+		writer.writeByte(MOVE);
+		writer.writeCommand(move);
+		isCorrect &= checkGolden("MOVE frame", writer, {0xac, 0x02, 0x01, 0x02, 0x00, 0x28, 0x4d, 0x04, 0x7d});
+		isCorrect &= checkDecode("MOVE frame", writer.getBytes(), 4, move);
+
+		//A lockstep frame of tick 30 holding a fire command, with the same values as the move, and the hash of the battle.
+		writer.clear();
+		writer.writeVarint(30);
+		writer.writeVarint(2);
+		writer.writeByte(FIRE);
+		writer.writeCommand(move);
+		writer.writeByte(STATE_HASH);
+		writer.writeUint64(0x0123456789abcdefull);
+		isCorrect &= checkGolden("FIRE and STATE_HASH frame", writer,
+			{0x1e, 0x02, 0x03, 0x00, 0x28, 0x4d, 0x04, 0x7d, 0x04, 0xef, 0xcd, 0xab, 0x89, 0x67, 0x45, 0x23, 0x01});
+
+		//An empty lockstep frame; it only marks the tick done.
+		writer.clear();
+		writer.writeVarint(3);
+		writer.writeVarint(0);
+		isCorrect &= checkGolden("Empty frame", writer, {0x03, 0x00});
+
+		//The host's ship, with a turret on a quarter pixel, and one off the edge of the hull.
+		BattleCommand ship;
+		ship.type = CommandType::CREATE_SHIP;
+		ship.position = {1800, 1800};
+		ship.angle = 45;
+		ship.turrets = {{ProjectileType::LASER, {12.25f, 100}}, {ProjectileType::PLASMA, {-3.5f, 0}}};
+
+		//The handshake of a host in lockstep, with an input delay of 4 ticks, at 60 ticks a second.
+		writer.clear();
+		writer.writeByte(CONNECT);
+		writer.writeVarint(Wire::VERSION);
+		writer.writeByte(1);
+		writer.writeVarint(4);
+		writer.writeVarint(16666);
+		writer.writeCommand(ship);
+		isCorrect &= checkGolden("CONNECT", writer, {0x00, 0x02, 0x01, 0x04, 0x9a, 0x82, 0x01, 0x80, 0x70, 0x80, 0x70, 0x00, 0x20, 0x02, 0x00,
+			0x62, 0xa0, 0x06, 0x02, 0x1b, 0x00});
+		isCorrect &= checkDecode("CONNECT", writer.getBytes(), 7, ship);
+
+		//A dedicated server seating the joining player, in lockstep with an input delay of 4, at 60 ticks a second.
+		writer.clear();
+		writer.writeByte(MATCH);
+		writer.writeVarint(Wire::VERSION);
+		writer.writeVarint(1);
+		writer.writeByte(1);
+		writer.writeVarint(4);
+		writer.writeVarint(16666);
+		isCorrect &= checkGolden("MATCH", writer, {0x05, 0x02, 0x01, 0x01, 0x04, 0x9a, 0x82, 0x01});
+
+		return isCorrect;
+	}
+
+	//Checks values outside of what the format carries are clamped, and wrapped.
+	//Returns whether every value was.
+	bool checkQuantise()
+	{
+		const bool isCorrect = Wire::quantiseFieldPosition({-10, 5000}) == sf::Vector2f(0, 65535 / Wire::FIELD_POSITION_SCALE)
+			&& Wire::quantiseAngle(-90) == 270 && Wire::quantiseAngle(359.999f) == 0;
+
+		std::cout << "Quantising out of range values: " << (isCorrect ? "clamped, and wrapped" : "MISMATCH") << "\n";
+
+		return isCorrect;
+	}
+
+	//Round-trips random commands, and ships; they are quantised first, as the sender does, so must decode exactly.
+	//Returns whether every value round-tripped.
+	bool checkRoundTrip()
+	{
+		std::mt19937 random(20190301);
+		std::uniform_real_distribution<float> field(0, 4000);
+		//Every random command, then every random ship.
+		std::vector<BattleCommand> values(1024);
+
+		for(auto &command : values)
+		{
+			command.shipID = random() % 4;
+			command.position = Wire::quantiseFieldPosition({field(random), field(random)});
+		}
+
+		for(int i = 0; i < 64; ++i)
+		{
+			values.push_back(randomShip(random));
+		}
+
+		//Whether every random value round-tripped.
+		bool isRoundTripped = true;
+
+		WireWriter writer;
+
+		for(const auto &value : values)
+		{
+			writer.clear();
+			writer.writeCommand(value);
+
+			WireReader reader(writer.getBytes().data(), writer.getBytes().size());
+			BattleCommand decoded;
+			decoded.type = value.type;
+			reader.readCommand(decoded);
+
+			isRoundTripped = isRoundTripped && reader.isValid() && reader.isAtEnd() && isSameCommand(decoded, value);
+		}
+
+		std::cout << "Round trip of " << values.size() << " packets: " << (isRoundTripped ? "exact" : "MISMATCH") << "\n";
+
+		return isRoundTripped;
+	}
+}
+
+int main()
+{
+	//Every check is run, even after one fails; so a single run reports every difference.
+	bool isCorrect = checkGoldenPackets();
+	isCorrect &= checkQuantise();
+	isCorrect &= checkRoundTrip();
+
+	std::cout << (isCorrect ? "All checks passed" : "CHECKS FAILED") << std::endl;
+
+	return isCorrect ? 0 : 1;
+}
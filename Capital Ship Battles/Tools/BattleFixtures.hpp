@@ -0,0 +1,49 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * What the tools build their battles from; the hull every ship is built from, and the "debug" ship built on it.
+ * Shared, so every tool measures the same ship; a tool that built its own would drift from the others.
+ */
+#pragma once
+
+#include <iostream> //For reporting a hull that failed to load.
+#include <string> //For the path of the hull.
+#include <vector> //For the build list.
+
+#include "Turret.hpp" //For the build list of the ship, and SFML's images.
+
+//Fixtures shared by the tools.
+namespace Fixtures
+{
+	//Loads the image of the hull every ship is built from; images stay in system memory, so no graphics context is needed.
+	//	hullPath : Where to load the hull from.
+	//	hullImage : Set to the image of the hull.
+	//Returns whether the hull was loaded; a hull that failed to load is reported.
+	inline bool loadHullImage(const std::string &hullPath, sf::Image &hullImage)
+	{
+		if(hullImage.loadFromFile(hullPath)) return true;
+
+		std::cerr << "Failed to load hull image: " << hullPath << std::endl;
+		return false;
+	}
+
+	//Returns the build list of a "debug" ship; turrets placed every 42 pixels across the hull, as the build state does on F3.
+	//	hullSize : The size of the hull the turrets are placed on.
+	inline std::vector<TurretInfo> buildDebugShip(const sf::Vector2u &hullSize)
+	{
+		//List of turrets on the debug ship.
+		std::vector<TurretInfo> turretList;
+		//Which projectile the next turret fires; cycled so every type is represented.
+		unsigned int typeIndex = 0;
+
+		for(unsigned int y = 0; y < hullSize.y; y += 42)
+		{
+			for(unsigned int x = 0; x < hullSize.x; x += 42)
+			{
+				turretList.push_back({static_cast<ProjectileType>(typeIndex++ % 3), sf::Vector2f(static_cast<float>(x), static_cast<float>(y))});
+			}
+		}
+
+		return turretList;
+	}
+}
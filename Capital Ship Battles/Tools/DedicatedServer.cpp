@@ -0,0 +1,78 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * A dedicated server for Capital Ship Battles, without a window; hosts many matches at once, for players who join it.
+ * Players join with "--dedicated", and the server's address; each pair to join is put in a match of their own, in lockstep.
+ * The matches are run on a pool of workers, one per core by default; the server hosts at most a target number of matches per worker,
+ * and players who join past it wait until a match ends. See MatchServer.hpp.
+ * Every match is played at the game's default tick rate of 60, with the same input delay; players are told both in the match message,
+ * take the input delay, and are refused if their tick rate differs. The game ignores "--tick-rate" when joining with "--dedicated".
+ *
+ * Usage: DedicatedServer [--port=port] [--workers=count] [--matches-per-core=count] [--input-delay=ticks] [--hull=path] [--duration=seconds]
+ * The duration defaults to running until the process is stopped. The server exits on an unknown option, or an invalid value.
+ */
+#include <iostream> //For reporting the server's settings.
+#include <string> //For parsing the command line.
+#include <thread> //For the number of cores.
+
+#include "BattleFixtures.hpp" //For the hull.
+#include "CommandLine.hpp" //For parsing the values of options.
+#include "MatchServer.hpp" //The server.
+#include "Ship.hpp" //For building the hull's collision key.
+
+int main(int argc, char *argv[])
+{
+	//The port players join on; the same as a player hosting.
+	unsigned short port = 25565;
+	//How many workers run the matches; one per core.
+	unsigned int workerCount = std::thread::hardware_concurrency();
+	//How many matches each worker is expected to keep up with.
+	unsigned int matchesPerWorker = 8;
+	//How many ticks after a command is given it is carried out, in every match.
+	unsigned int inputDelay = 4;
+	//Where to load the hull from; every player's ship is built from it.
+	std::string hullPath = "Assets/hull.png";
+	//How long to run for, in seconds; zero to run until stopped.
+	float duration = 0;
+	//Whether every option's value was valid.
+	bool isValid = true;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string option = argv[i];
+
+		if(option.compare(0, 7, "--port=") == 0) isValid &= CSB::parseOption(option, 7, port);
+		else if(option.compare(0, 10, "--workers=") == 0) isValid &= CSB::parseOption(option, 10, workerCount);
+		else if(option.compare(0, 19, "--matches-per-core=") == 0) isValid &= CSB::parseOption(option, 19, matchesPerWorker);
+		else if(option.compare(0, 14, "--input-delay=") == 0) isValid &= CSB::parseOption(option, 14, inputDelay);
+		else if(option.compare(0, 7, "--hull=") == 0) hullPath = option.substr(7);
+		else if(option.compare(0, 11, "--duration=") == 0) isValid &= CSB::parseOption(option, 11, duration);
+		else
+		{
+			std::cerr << "Unknown option: " << option << std::endl;
+			return 1;
+		}
+	}
+
+	if(!isValid) return 1;
+
+	//Image of the hull every ship is built from.
+	sf::Image hullImage;
+	if(!Fixtures::loadHullImage(hullPath, hullImage)) return 1;
+
+	//Collision key of the hull; built once, and shared by every match.
+	const DamageMask hullKey = Ship::createPristineKey(hullImage);
+
+	MatchServer server(hullKey, workerCount, matchesPerWorker, inputDelay);
+
+	if(!server.listen(port))
+	{
+		std::cerr << "Failed to listen on port " << port << std::endl;
+		return 1;
+	}
+
+	std::cout << "Listening on port " << port << "; up to " << server.getMatchCapacity() << " matches, input delay " << inputDelay
+		<< " ticks" << std::endl;
+
+	server.run(sf::seconds(duration));
+}
@@ -0,0 +1,134 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Runs a battle between two fleets of "debug" ships - a ship with the maximum amount of turrets (4x4) - without a window.
+ * The battle is stepped as fast as the machine allows at the game's fixed tick, instead of at the 60 Hz wall-clock pace,
+ * so it may be used for balancing and regression runs on machines with no display.
+ *
+ * Also reports how many projectile-ship pairs were considered for collision each tick; with and without the ship grid.
+ *
+ * Given worker threads, each tick is spread over a JobSystem; the result is bit-identical to the serial tick.
+ *
+ * Usage: HeadlessBattle [maximum ticks] [hull image path] [ships per side] [worker threads; 0 for the serial tick]
+ */
+#include <cmath> //For placing move orders around a circle.
+#include <iostream> //For reporting the result of the battle.
+#include <memory> //For smart pointers.
+#include <string> //For parsing the command line.
+
+#include "BattleFixtures.hpp" //For the hull, and the debug ship.
+#include "CSB_Functions.hpp" //For the game's default tick.
+#include "BattleSimulation.hpp" //The battle we are running.
+
+namespace
+{
+	const sf::Time TICK_LENGTH = CSB::tickLength(CSB::DEFAULT_TICK_RATE); //The fixed tick the game runs at.
+	const unsigned long TICKS_PER_MOVE = 600; //How many ticks pass between each move order; so shots do not always travel the same line.
+	const float SHIP_SPACING = 300; //Distance between the ships in a fleet.
+
+	//Returns how many turrets remain on the passed layer.
+	//	battle : The battle we are counting the turrets in.
+	//	layer : The layer the ships are on; i.e. which team.
+	std::size_t countTurrets(const BattleSimulation &battle, unsigned int layer)
+	{
+		std::size_t turretCount = 0;
+
+		for(const auto &ship : battle.getShips(layer))
+		{
+			turretCount += ship->getTurretCount();
+		}
+
+		return turretCount;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	//How many ticks to run before giving up on the battle; ten minutes of game time by default.
+	const unsigned long maxTicks = argc > 1 ? std::stoul(argv[1]) : 36000;
+	//Where to load the hull from.
+	const std::string hullPath = argc > 2 ? argv[2] : "Assets/hull.png";
+	//How many ships each side starts with.
+	const unsigned int shipsPerSide = argc > 3 ? std::stoul(argv[3]) : 1;
+	//How many workers each tick is spread over; none runs the serial tick.
+	const unsigned int workerCount = argc > 4 ? std::stoul(argv[4]) : 0;
+
+	//Image of the hull both ships are built from.
+	sf::Image hullImage;
+	if(!Fixtures::loadHullImage(hullPath, hullImage)) return 1;
+
+	//Collision key of the hull; built once, and shared by every ship.
+	const DamageMask hullKey = Ship::createPristineKey(hullImage);
+	//Workers each tick is spread over, if any.
+	std::unique_ptr<JobSystem> jobs = workerCount > 0 ? std::make_unique<JobSystem>(workerCount) : nullptr;
+	//The battle being run; without any textures, so it never touches the GPU.
+	BattleSimulation battle(hullKey, jobs.get());
+
+	//Build both fleets facing each other, as in a local battle; each fleet is a line of ships across the diagonal between them.
+	const std::vector<TurretInfo> debugShip = Fixtures::buildDebugShip(hullImage.getSize());
+	const sf::Vector2f centreField = {battle.getBounds().width / 2.f, battle.getBounds().height / 2.f};
+	for(unsigned int i = 0; i < shipsPerSide; ++i)
+	{
+		const sf::Vector2f lineOffset = sf::Vector2f(SHIP_SPACING, -SHIP_SPACING) * (i - (shipsPerSide - 1) / 2.f) / std::sqrt(2.f);
+
+		battle.createShip(0, centreField - sf::Vector2f(200, 200) + lineOffset, 45, debugShip);
+		battle.createShip(1, centreField + sf::Vector2f(200, 200) + lineOffset, 225, debugShip);
+	}
+
+	//How many ticks have been simulated.
+	unsigned long tick = 0;
+	//Total pairs considered for collision over the battle.
+	CollisionStats totalCollisionStats;
+	//Measures how long the battle took in real time.
+	sf::Clock wallClock;
+
+	//Run the battle until either side loses, or we run out of ticks.
+	while(!battle.isFinished() && tick < maxTicks)
+	{
+		//Periodically move both ships to opposite points on a circle around the centre of the field.
+		if(tick % TICKS_PER_MOVE == 0)
+		{
+			//Angle around the circle of this move order; advanced by an uneven amount, so the ships do not repeat positions.
+			const float angle = (tick / TICKS_PER_MOVE) * 2.4f;
+			const sf::Vector2f offset = sf::Vector2f(std::cos(angle), std::sin(angle)) * 300.f;
+
+			for(unsigned int i = 0; i < battle.getShips(0).size(); ++i)
+			{
+				battle.issueMoveCommand(0, i, centreField - offset + sf::Vector2f(0, SHIP_SPACING * i));
+			}
+
+			for(unsigned int i = 0; i < battle.getShips(1).size(); ++i)
+			{
+				battle.issueMoveCommand(1, i, centreField + offset - sf::Vector2f(0, SHIP_SPACING * i));
+			}
+		}
+
+		//Each ship fires at a ship in the other fleet every tick; turrets ignore the command while they are reloading.
+		for(unsigned int i = 0; i < battle.getShips(0).size(); ++i)
+		{
+			battle.issueFireCommand(0, i, battle.getShips(1)[i % battle.getShips(1).size()]->getPosition(), 1);
+		}
+
+		for(unsigned int i = 0; i < battle.getShips(1).size(); ++i)
+		{
+			battle.issueFireCommand(1, i, battle.getShips(0)[i % battle.getShips(0).size()]->getPosition(), 0);
+		}
+
+		battle.update(TICK_LENGTH);
+		++tick;
+
+		totalCollisionStats.bruteForcePairs += battle.getCollisionStats().bruteForcePairs;
+		totalCollisionStats.candidatePairs += battle.getCollisionStats().candidatePairs;
+	}
+
+	//How long the battle took to simulate.
+	const sf::Time elapsed = wallClock.getElapsedTime();
+
+	std::cout << "Ticks simulated: " << tick << " (" << tick * TICK_LENGTH.asSeconds() << "s of game time)\n";
+	std::cout << "Wall time: " << elapsed.asSeconds() << "s\n";
+	std::cout << "Ticks per second: " << (elapsed.asSeconds() > 0 ? tick / elapsed.asSeconds() : 0) << "\n";
+	std::cout << "Collision pairs per tick without grid: " << static_cast<double>(totalCollisionStats.bruteForcePairs) / tick << "\n";
+	std::cout << "Collision pairs per tick with grid: " << static_cast<double>(totalCollisionStats.candidatePairs) / tick << "\n";
+	std::cout << "Turrets remaining: " << countTurrets(battle, 0) << " vs. " << countTurrets(battle, 1) << "\n";
+	std::cout << "Result: " << (battle.isFinished() ? "finished" : "tick limit reached") << std::endl;
+}
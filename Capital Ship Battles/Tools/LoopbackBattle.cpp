@@ -0,0 +1,299 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Runs two networked battles against each other in one process, without a window, over a LoopbackTransport pair;
+ * so the netcode may be tested, and measured, under latency, jitter, loss, reordering, and a cap on bandwidth, with no second machine.
+ * Each battle is run by its own BattleSession and NetworkManager, as the game runs it, on its own thread at the game's 60 Hz wall-clock pace.
+ * Both players fly a "debug" ship; every few ticks, each alternately moves their ship, or fires on the other.
+ *
+ * Reports:
+ *	Input to effect : How long, in wall time, each order took from being given to being carried out; by the player's own battle,
+ *		and by the peer's. In lockstep, both are the input delay, plus any wait on the peer.
+ *	Late ticks : How far behind their wall-clock time the ticks ran; in lockstep, the time spent waiting on the peer.
+ *	Sync : The tick each battle ended on, and the hash of its state there; in lockstep, they must be the same, with no desync reported.
+ * In lockstep, the tool exits with a failure if the battles did not stay in sync; as it does on an unknown option, or an invalid value.
+ *
+ * Usage: LoopbackBattle [--ticks=count] [--hull=path] [--latency=milliseconds] [--jitter=milliseconds] [--loss=percent]
+ *	[--reorder=percent] [--bandwidth=bytes per second] [--input-delay=ticks] [--order-interval=ticks] [--no-lockstep]
+ */
+#include <algorithm> //For sorting the latencies, and std::max.
+#include <iostream> //For reporting the results.
+#include <memory> //For smart pointers.
+#include <string> //For parsing the command line.
+#include <vector> //For the latencies.
+
+#include "BattleFixtures.hpp" //For the hull, and the debug ship.
+#include "BattleSession.hpp" //For running each battle.
+#include "CommandLine.hpp" //For parsing the values of options.
+#include "CSB_Functions.hpp" //For the game's default tick.
+#include "LoopbackTransport.hpp" //For connecting the battles.
+#include "NetworkManager.hpp" //For networking each battle.
+
+namespace
+{
+	const sf::Time TICK_LENGTH = CSB::tickLength(CSB::DEFAULT_TICK_RATE); //The fixed tick the game runs at.
+	const sf::Time STALL_POLL_INTERVAL = sf::microseconds(250); //How often a battle waiting on its peer checks whether it may carry on.
+	const sf::Time RUN_TIMEOUT = sf::seconds(30); //How long past its wall-clock time a battle may run before it is given up on.
+
+	//One of the two players; their battle, and its networking.
+	struct Peer
+	{
+		LoopbackTransport transport; //This end of the pipe to the other player.
+		NetworkManager network; //Networks the battle over the transport.
+		std::unique_ptr<BattleSimulation> simulation; //The player's battle.
+		std::unique_ptr<BattleSession> session; //Runs the battle's ticks.
+
+		std::vector<sf::Time> ordersGiven; //When each order was given.
+		std::vector<sf::Time> ordersCarriedOut[2]; //When each order was carried out; the player's own, then the other player's.
+		std::vector<sf::Time> lateness; //How far behind its wall-clock time each tick ran.
+		std::uint32_t endTick = 0; //The tick the battle ended on.
+		std::uint64_t endHash = 0; //The hash of the battle's state at the end.
+	};
+
+	//Runs a player's battle at the game's pace until it reaches the last tick, or finishes; giving an order every so often.
+	//	peer : The player.
+	//	ticks : How many ticks to run.
+	//	orderInterval : How many ticks pass between each order.
+	//	clock : The wall clock both players are timed by; started as the battles were.
+	void runBattle(Peer &peer, std::uint32_t ticks, std::uint32_t orderInterval, const sf::Clock &clock)
+	{
+		BattleSimulation &simulation = *peer.simulation;
+		BattleSession &session = *peer.session;
+		//The tick the last order was given at; so an order is only given once for each tick, however long it waits on the peer.
+		std::uint32_t lastOrderTick = UINT32_MAX;
+
+		while(simulation.getTick() < ticks && !simulation.isFinished())
+		{
+			const std::uint32_t tick = simulation.getTick();
+			//When the tick is due, at the game's pace.
+			const sf::Time due = TICK_LENGTH * static_cast<float>(tick);
+
+			if(clock.getElapsedTime() > due + RUN_TIMEOUT) break;
+
+			if(clock.getElapsedTime() < due) sf::sleep(due - clock.getElapsedTime());
+
+			//Alternately move, and fire on the other player's ship; from the start of the tick the order is given at.
+			if(tick % orderInterval == 0 && tick != lastOrderTick)
+			{
+				const std::vector<std::unique_ptr<Ship>> &targets = simulation.getShips(1 - session.getLocalLayer());
+				const sf::Vector2f target = targets.empty() ? sf::Vector2f(2000, 2000) : targets.front()->getPosition();
+				const bool isFiring = (tick / orderInterval) % 2 == 1;
+
+				//A move order, towards a point on a line across the field; so the ships keep moving past each other.
+				const sf::Vector2f moveTarget = sf::Vector2f(1600, 1600) + sf::Vector2f(800, 800) * static_cast<float>((tick / orderInterval) % 5) / 4.f;
+
+				if(isFiring ? session.queueLocalCommand(CommandType::FIRE, target, 1 - session.getLocalLayer())
+					: session.queueLocalCommand(CommandType::MOVE, moveTarget))
+				{
+					peer.ordersGiven.push_back(clock.getElapsedTime());
+				}
+
+				lastOrderTick = tick;
+			}
+
+			//When the tick started; its commands are carried out at its start.
+			const sf::Time started = clock.getElapsedTime();
+
+			//Wait on the peer, if they have not marked the tick done.
+			if(!session.update(TICK_LENGTH))
+			{
+				sf::sleep(STALL_POLL_INTERVAL);
+				continue;
+			}
+
+			peer.lateness.push_back(started - due);
+
+			for(unsigned int i = 0; i < 2; ++i)
+			{
+				while(peer.ordersCarriedOut[i].size() < session.getOrdersApplied(i == 1))
+				{
+					peer.ordersCarriedOut[i].push_back(started);
+				}
+			}
+		}
+
+		peer.endTick = simulation.getTick();
+		peer.endHash = simulation.getStateHash();
+	}
+
+	//Returns the value a fraction of the times are within, in milliseconds.
+	//	times : The times; sorted.
+	//	fraction : The fraction of the times.
+	double percentile(const std::vector<sf::Time> &times, double fraction)
+	{
+		if(times.empty()) return 0;
+
+		return times[std::min(times.size() - 1, static_cast<std::size_t>(fraction * times.size()))].asMicroseconds() / 1000.0;
+	}
+
+	//Prints the median, 99th percentile, and longest, of the times.
+	//	name : What the times are of.
+	//	times : The times.
+	void printTimes(const std::string &name, std::vector<sf::Time> times)
+	{
+		std::sort(times.begin(), times.end());
+
+		std::cout << name << ": p50 " << percentile(times, 0.5) << " ms, p99 " << percentile(times, 0.99) << " ms, max "
+			<< percentile(times, 1) << " ms, over " << times.size() << "\n";
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	//How many ticks each battle runs for; thirty seconds by default.
+	std::uint32_t ticks = 1800;
+	//Where to load the hull from.
+	std::string hullPath = "Assets/hull.png";
+	//How badly the pipe drops, and delays, what is sent each way;
+	//the delays in milliseconds, the loss, and reordering, as percentages, and the bandwidth in bytes per second.
+	unsigned int latency = 20;
+	unsigned int jitter = 5;
+	float lossPercent = 2;
+	float reorderPercent = 1;
+	unsigned int bandwidth = 0;
+	//How many ticks after an order is given it is carried out, in lockstep; enough to cover the latency, and jitter.
+	unsigned int inputDelay = 4;
+	//How many ticks pass between each order a player gives.
+	std::uint32_t orderInterval = 6;
+	//Whether the battles are networked in lockstep.
+	bool isLockstep = true;
+	//Whether every option's value was valid.
+	bool isValid = true;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string option = argv[i];
+
+		if(option.compare(0, 8, "--ticks=") == 0) isValid &= CSB::parseOption(option, 8, ticks);
+		else if(option.compare(0, 7, "--hull=") == 0) hullPath = option.substr(7);
+		else if(option.compare(0, 10, "--latency=") == 0) isValid &= CSB::parseOption(option, 10, latency, 60000u);
+		else if(option.compare(0, 9, "--jitter=") == 0) isValid &= CSB::parseOption(option, 9, jitter, 60000u);
+		else if(option.compare(0, 7, "--loss=") == 0) isValid &= CSB::parseOption(option, 7, lossPercent, 100.f);
+		else if(option.compare(0, 10, "--reorder=") == 0) isValid &= CSB::parseOption(option, 10, reorderPercent, 100.f);
+		else if(option.compare(0, 12, "--bandwidth=") == 0) isValid &= CSB::parseOption(option, 12, bandwidth);
+		else if(option.compare(0, 14, "--input-delay=") == 0) isValid &= CSB::parseOption(option, 14, inputDelay);
+		else if(option.compare(0, 17, "--order-interval=") == 0) isValid &= CSB::parseOption(option, 17, orderInterval);
+		else if(option == "--no-lockstep") isLockstep = false;
+		else
+		{
+			std::cerr << "Unknown option: " << option << std::endl;
+			return 1;
+		}
+	}
+
+	if(!isValid) return 1;
+
+	//At least one tick between orders.
+	orderInterval = std::max<std::uint32_t>(orderInterval, 1);
+	const LinkImpairment impairment = {lossPercent / 100.f, sf::milliseconds(latency), sf::milliseconds(jitter), reorderPercent / 100.f, bandwidth};
+
+	//Image of the hull both ships are built from.
+	sf::Image hullImage;
+	if(!Fixtures::loadHullImage(hullPath, hullImage)) return 1;
+
+	//Collision key of the hull; built once, and shared by both battles.
+	const DamageMask hullKey = Ship::createPristineKey(hullImage);
+	const std::vector<TurretInfo> debugShip = Fixtures::buildDebugShip(hullImage.getSize());
+
+	std::cout << (isLockstep ? "Lockstep, input delay " + std::to_string(inputDelay) + " ticks" : std::string("Without lockstep")) << "; "
+		<< impairment.latency.asMilliseconds() << " ms latency, " << impairment.jitter.asMilliseconds() << " ms jitter, "
+		<< impairment.lossRate * 100 << "% loss, " << impairment.reorderRate * 100 << "% reordered, and "
+		<< (impairment.bandwidth > 0 ? std::to_string(impairment.bandwidth) + " bytes/s" : std::string("unlimited bandwidth")) << " each way\n";
+
+	//The host, then the joining player.
+	Peer peers[2];
+
+	LoopbackTransport::connect(peers[0].transport, peers[1].transport, impairment);
+
+	for(unsigned int i = 0; i < 2; ++i)
+	{
+		Peer &peer = peers[i];
+
+		peer.network.setLockstep(isLockstep, inputDelay);
+		peer.network.useTransport(peer.transport, i == 0);
+		peer.network.setTurretList(debugShip);
+
+		peer.simulation = std::make_unique<BattleSimulation>(hullKey);
+		peer.session = std::make_unique<BattleSession>(*peer.simulation, &peer.network);
+		peer.session->createLocalShip(debugShip);
+		peer.network.setBattle(peer.session.get());
+	}
+
+	//Each player's network thread, and the thread running their battle.
+	std::unique_ptr<sf::Thread> networkThreads[2], battleThreads[2];
+	//The wall clock both players are timed by.
+	sf::Clock clock;
+
+	for(unsigned int i = 0; i < 2; ++i)
+	{
+		Peer &peer = peers[i];
+
+		networkThreads[i] = std::make_unique<sf::Thread>(&NetworkManager::receive, &peer.network);
+		networkThreads[i]->launch();
+		peer.network.sendShip();
+
+		battleThreads[i] = std::make_unique<sf::Thread>([&peer, ticks, orderInterval, &clock]()
+		{
+			runBattle(peer, ticks, orderInterval, clock);
+		});
+		battleThreads[i]->launch();
+	}
+
+	for(auto &thread : battleThreads)
+	{
+		thread->wait();
+	}
+
+	//Both battles are over; closing either end closes the pipe, which ends both network threads.
+	for(unsigned int i = 0; i < 2; ++i)
+	{
+		peers[i].network.closeAllConnections();
+		networkThreads[i]->wait();
+	}
+
+	//How long orders took to be carried out; by the battle of the player giving them, then by the other player's.
+	std::vector<sf::Time> localLatencies, remoteLatencies, lateness;
+	//How many orders were carried out by the battle of the player giving them, but never by the other player's.
+	std::size_t ordersLost = 0;
+
+	for(unsigned int i = 0; i < 2; ++i)
+	{
+		const Peer &peer = peers[i], &other = peers[1 - i];
+
+		for(std::size_t order = 0; order < peer.ordersGiven.size(); ++order)
+		{
+			//Orders given in the last ticks may never be carried out, as the battles end first.
+			if(order < peer.ordersCarriedOut[0].size()) localLatencies.push_back(peer.ordersCarriedOut[0][order] - peer.ordersGiven[order]);
+
+			if(order < other.ordersCarriedOut[1].size())
+			{
+				remoteLatencies.push_back(other.ordersCarriedOut[1][order] - peer.ordersGiven[order]);
+			}
+			else if(order < peer.ordersCarriedOut[0].size())
+			{
+				++ordersLost;
+			}
+		}
+
+		lateness.insert(lateness.end(), peer.lateness.begin(), peer.lateness.end());
+	}
+
+	printTimes("Input to effect, own battle", localLatencies);
+	printTimes("Input to effect, peer's battle", remoteLatencies);
+	printTimes("Late ticks", lateness);
+	std::cout << "Orders not carried out by the peer: " << ordersLost << "\n";
+
+	for(unsigned int i = 0; i < 2; ++i)
+	{
+		std::cout << (i == 0 ? "Host" : "Joining player") << " ended at tick " << peers[i].endTick << ", hash " << std::hex << peers[i].endHash
+			<< std::dec << (peers[i].session->isDesynced() ? "; desync reported" : "") << "\n";
+	}
+
+	const bool isInSync = peers[0].endTick == peers[1].endTick && peers[0].endHash == peers[1].endHash
+		&& !peers[0].session->isDesynced() && !peers[1].session->isDesynced();
+
+	std::cout << (isInSync ? "Battles in sync" : "Battles diverged") << std::endl;
+
+	//Without lockstep, the battles are expected to diverge; they are only required to stay in sync in lockstep.
+	return !isLockstep || isInSync ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Measures how the battle tick scales over worker threads, on a large battle between two fleets of "debug" ships.
+ * The battle is run once with the serial tick, then with a JobSystem of 1 worker, doubling up to every core.
+ * Every run hashes the state of the battle each tick; ship transforms, turrets, projectiles, and finally each ship's damage.
+ * A parallel run whose hash differs from the serial run is reported as a mismatch, as the parallel tick must be bit-identical to it.
+ *
+ * Usage: ParallelTickBenchmark [ticks] [ships per side] [max workers] [hull image path]
+ */
+#include <algorithm> //For std::min, and std::max.
+#include <cmath> //For placing move orders around a circle.
+#include <cstdint> //For the hash.
+#include <cstring> //For hashing the bytes of floats.
+#include <iomanip> //For printing the hash.
+#include <iostream> //For reporting the results.
+#include <memory> //For smart pointers.
+#include <string> //For parsing the command line.
+#include <thread> //For the hardware thread count.
+
+#include "BattleFixtures.hpp" //For the hull, and the debug ship.
+#include "CSB_Functions.hpp" //For the game's default tick.
+#include "BattleSimulation.hpp" //The battle being measured.
+
+namespace
+{
+	const sf::Time TICK_LENGTH = CSB::tickLength(CSB::DEFAULT_TICK_RATE); //The fixed tick the game runs at.
+	const unsigned long TICKS_PER_MOVE = 600; //How many ticks pass between each move order.
+	const float SHIP_SPACING = 150; //Distance between the ships in a fleet; closer than the headless battle, so a large fleet fits the field.
+
+	//Result of a run of the battle.
+	struct RunResult
+	{
+		sf::Time elapsed; //Wall time the ticks took; excludes building, and hashing, the battle.
+		std::uint64_t hash; //Hash of the state of the battle over every tick.
+		unsigned long ticks; //How many ticks were run; fewer than asked if the battle finished.
+	};
+
+	//Mixes the bytes of a value into an FNV-1a hash.
+	//	hash : The hash to mix into.
+	//	value : The value to mix in.
+	template<typename T>
+	void mixHash(std::uint64_t &hash, const T &value)
+	{
+		unsigned char bytes[sizeof(T)];
+		std::memcpy(bytes, &value, sizeof(T));
+
+		for(unsigned char byte : bytes)
+		{
+			hash = (hash ^ byte) * 1099511628211ull;
+		}
+	}
+
+	//Mixes the state of the battle this tick into the hash.
+	//	hash : The hash to mix into.
+	//	battle : The battle being hashed.
+	void hashTick(std::uint64_t &hash, const BattleSimulation &battle)
+	{
+		for(unsigned int layer = 0; layer < 2; ++layer)
+		{
+			mixHash(hash, battle.getShips(layer).size());
+
+			for(const auto &ship : battle.getShips(layer))
+			{
+				const float *matrix = ship->getTickTransform().getMatrix();
+
+				for(int i = 0; i < 16; ++i)
+				{
+					mixHash(hash, matrix[i]);
+				}
+
+				mixHash(hash, ship->getTurretCount());
+			}
+		}
+
+		const ProjectilePool &projectiles = battle.getProjectiles();
+		mixHash(hash, projectiles.size());
+
+		for(std::size_t i = 0; i < projectiles.size(); ++i)
+		{
+			mixHash(hash, projectiles.getPosition(i).x);
+			mixHash(hash, projectiles.getPosition(i).y);
+		}
+	}
+
+	//Runs the battle, and hashes its state every tick.
+	//	hullKey : Pristine key the ships are built from.
+	//	debugShip : The turrets every ship is built with.
+	//	shipsPerSide : How many ships each side starts with.
+	//	ticks : How many ticks to run, unless the battle finishes first.
+	//	jobs : Workers to spread each tick over; nullptr for the serial tick.
+	RunResult runBattle(const DamageMask &hullKey, const std::vector<TurretInfo> &debugShip, unsigned int shipsPerSide, unsigned long ticks,
+		JobSystem *jobs)
+	{
+		BattleSimulation battle(hullKey, jobs);
+
+		//Build both fleets facing each other; each fleet is a line of ships across the diagonal between them, as in the headless battle.
+		const sf::Vector2f centreField = {battle.getBounds().width / 2.f, battle.getBounds().height / 2.f};
+		for(unsigned int i = 0; i < shipsPerSide; ++i)
+		{
+			const sf::Vector2f lineOffset = sf::Vector2f(SHIP_SPACING, -SHIP_SPACING) * (i - (shipsPerSide - 1) / 2.f) / std::sqrt(2.f);
+
+			battle.createShip(0, centreField - sf::Vector2f(200, 200) + lineOffset, 45, debugShip);
+			battle.createShip(1, centreField + sf::Vector2f(200, 200) + lineOffset, 225, debugShip);
+		}
+
+		RunResult result = {sf::Time::Zero, 14695981039346656037ull, 0};
+
+		for(; result.ticks < ticks && !battle.isFinished(); ++result.ticks)
+		{
+			const unsigned long tick = result.ticks;
+
+			//Periodically move both fleets to opposite points on a circle around the centre of the field.
+			if(tick % TICKS_PER_MOVE == 0)
+			{
+				const float angle = (tick / TICKS_PER_MOVE) * 2.4f;
+				const sf::Vector2f offset = sf::Vector2f(std::cos(angle), std::sin(angle)) * 300.f;
+
+				for(unsigned int i = 0; i < battle.getShips(0).size(); ++i)
+				{
+					battle.issueMoveCommand(0, i, centreField - offset + sf::Vector2f(0, SHIP_SPACING * i));
+				}
+
+				for(unsigned int i = 0; i < battle.getShips(1).size(); ++i)
+				{
+					battle.issueMoveCommand(1, i, centreField + offset - sf::Vector2f(0, SHIP_SPACING * i));
+				}
+			}
+
+			//Each ship fires at a ship in the other fleet every tick.
+			for(unsigned int i = 0; i < battle.getShips(0).size(); ++i)
+			{
+				battle.issueFireCommand(0, i, battle.getShips(1)[i % battle.getShips(1).size()]->getPosition(), 1);
+			}
+
+			for(unsigned int i = 0; i < battle.getShips(1).size(); ++i)
+			{
+				battle.issueFireCommand(1, i, battle.getShips(0)[i % battle.getShips(0).size()]->getPosition(), 0);
+			}
+
+			sf::Clock clock;
+			battle.update(TICK_LENGTH);
+			result.elapsed += clock.getElapsedTime();
+
+			hashTick(result.hash, battle);
+		}
+
+		//Finish with the damage of every ship; a hit on a cell no turret is mounted on only shows here.
+		for(unsigned int layer = 0; layer < 2; ++layer)
+		{
+			for(const auto &ship : battle.getShips(layer))
+			{
+				ShipSnapshot snapshot;
+				ship->fillSnapshot(snapshot);
+
+				for(unsigned int y = 0; y < snapshot.damage.getSize().y; ++y)
+				{
+					for(unsigned int x = 0; x < snapshot.damage.getSize().x; ++x)
+					{
+						mixHash(result.hash, snapshot.damage.isSet(x, y));
+					}
+				}
+			}
+		}
+
+		return result;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	//How many ticks each run lasts, unless the battle finishes first.
+	const unsigned long ticks = argc > 1 ? std::stoul(argv[1]) : 3600;
+	//How many ships each side starts with.
+	const unsigned int shipsPerSide = argc > 2 ? std::stoul(argv[2]) : 16;
+	//The most workers to spread the tick over; each run doubles the workers until it is reached.
+	const unsigned int maxWorkers = argc > 3 ? std::stoul(argv[3]) : std::max(std::thread::hardware_concurrency(), 1u);
+	//Where to load the hull from.
+	const std::string hullPath = argc > 4 ? argv[4] : "Assets/hull.png";
+
+	//Image of the hull every ship is built from.
+	sf::Image hullImage;
+	if(!Fixtures::loadHullImage(hullPath, hullImage)) return 1;
+
+	const DamageMask hullKey = Ship::createPristineKey(hullImage);
+	const std::vector<TurretInfo> debugShip = Fixtures::buildDebugShip(hullImage.getSize());
+
+	//The serial tick every parallel run must match.
+	const RunResult serial = runBattle(hullKey, debugShip, shipsPerSide, ticks, nullptr);
+
+	std::cout << "Ships per side: " << shipsPerSide << ", ticks: " << serial.ticks << "\n";
+	std::cout << "Serial: " << serial.elapsed.asMicroseconds() / 1000.0 / serial.ticks << " ms/tick, hash "
+		<< std::hex << serial.hash << std::dec << "\n";
+
+	//Whether every parallel run matched the serial run.
+	bool isIdentical = true;
+
+	//Double the workers each run, finishing on the most workers.
+	for(unsigned int workerCount = 1;; workerCount = std::min(workerCount * 2, maxWorkers))
+	{
+		JobSystem jobs(workerCount);
+		const RunResult parallel = runBattle(hullKey, debugShip, shipsPerSide, ticks, &jobs);
+		const bool isMatch = parallel.hash == serial.hash && parallel.ticks == serial.ticks;
+
+		isIdentical = isIdentical && isMatch;
+
+		std::cout << workerCount << " workers: " << parallel.elapsed.asMicroseconds() / 1000.0 / parallel.ticks << " ms/tick, speed-up "
+			<< serial.elapsed.asSeconds() / parallel.elapsed.asSeconds() << "x, " << (isMatch ? "identical" : "MISMATCH") << "\n";
+
+		if(workerCount == maxWorkers) break;
+	}
+
+	std::cout << std::flush;
+
+	return isIdentical ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Compares the frame time of drawing projectiles one shape at a time, as BattleState used to,
+ * against drawing them as one batched vertex array with the ProjectileRenderer.
+ * Needs a window, as the cost being measured is in the draw calls; vertical sync is disabled so frames are not capped.
+ *
+ * Usage: ProjectileRenderBenchmark [frames per run] [projectile count...]
+ */
+#include <iostream> //For reporting the frame times.
+#include <random> //For scattering the projectiles.
+#include <string> //For parsing the command line.
+
+#include "ProjectileRenderer.hpp" //The batched path.
+
+namespace
+{
+	const sf::FloatRect FIELD = {0, 0, 4000, 4000}; //Area the projectiles are scattered across; the size of a battle.
+
+	//Fills the pool with projectiles scattered across the field, travelling in random directions.
+	//	projectiles : The pool to fill.
+	//	count : How many projectiles to create.
+	void scatterProjectiles(ProjectilePool &projectiles, std::size_t count)
+	{
+		//Fixed seed, so every run draws the same scene.
+		std::mt19937 generator(25565);
+		std::uniform_real_distribution<float> coordinate(0.f, FIELD.width);
+		std::uniform_int_distribution<int> type(0, 2);
+
+		projectiles.clear();
+
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			projectiles.create({static_cast<ProjectileType>(type(generator)), 0,
+				{coordinate(generator), coordinate(generator)}, {coordinate(generator), coordinate(generator)}});
+		}
+	}
+
+	//Draws the projectiles one shape at a time; the path used before the projectiles were batched.
+	//	target : What we will be drawing onto.
+	//	projectiles : The projectiles to draw.
+	void drawPerShape(sf::RenderTarget &target, const ProjectilePool &projectiles)
+	{
+		//Shape that is set up as each projectile in turn, and drawn.
+		sf::RectangleShape projShape;
+
+		for(std::size_t i = 0; i < projectiles.size(); ++i)
+		{
+			//How this type of projectile looks.
+			const ProjectileTypeInfo &typeInfo = getProjectileTypeInfo(projectiles.getProjectileType(i));
+
+			projShape.setSize(typeInfo.size);
+			projShape.setFillColor(typeInfo.colour);
+			projShape.setOrigin(typeInfo.size / 2.f);
+			projShape.setPosition(projectiles.getPosition(i));
+			projShape.setRotation(projectiles.getRotation(i));
+
+			target.draw(projShape);
+		}
+	}
+
+	//Returns the average time taken to draw, and display, a frame with the passed draw function.
+	//	window : The window we are drawing to.
+	//	frames : How many frames to average over.
+	//	drawFrame : Draws the projectiles for a single frame.
+	template<typename DrawFunction>
+	sf::Time timeFrames(sf::RenderWindow &window, unsigned int frames, DrawFunction drawFrame)
+	{
+		sf::Clock clock;
+
+		for(unsigned int frame = 0; frame < frames; ++frame)
+		{
+			window.clear(sf::Color(0, 0, 20));
+			drawFrame();
+			//Display waits for the frame to finish on the GPU, so it is part of the frame time.
+			window.display();
+		}
+
+		return clock.getElapsedTime() / static_cast<sf::Int64>(frames);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	//How many frames each run is averaged over.
+	const unsigned int frames = argc > 1 ? std::stoul(argv[1]) : 300;
+	//How many projectiles are drawn in each run.
+	std::vector<std::size_t> projectileCounts;
+
+	for(int i = 2; i < argc; ++i)
+	{
+		projectileCounts.push_back(std::stoul(argv[i]));
+	}
+
+	if(projectileCounts.empty()) projectileCounts = {100, 1000, 5000, 20000};
+
+	sf::RenderWindow window(sf::VideoMode(800, 600), "Projectile Render Benchmark");
+	//We want the cost of the frame, not the refresh rate.
+	window.setVerticalSyncEnabled(false);
+	//Show the whole field, as a fully zoomed-out battle does.
+	window.setView(sf::View(FIELD));
+
+	ProjectilePool projectiles;
+	ProjectileRenderer renderer;
+
+	std::cout << "Projectiles\tPer-shape (ms/frame)\tBatched (ms/frame)\tSpeed-up\n";
+
+	for(std::size_t count : projectileCounts)
+	{
+		scatterProjectiles(projectiles, count);
+
+		const sf::Time perShapeTime = timeFrames(window, frames, [&]()
+		{
+			drawPerShape(window, projectiles);
+		});
+
+		//The batch is rebuilt every frame, as BattleState does; so its cost is included.
+		const sf::Time batchedTime = timeFrames(window, frames, [&]()
+		{
+			renderer.update(projectiles);
+			window.draw(renderer);
+		});
+
+		std::cout << count << "\t\t" << perShapeTime.asMicroseconds() / 1000.f << "\t\t\t" << batchedTime.asMicroseconds() / 1000.f
+			<< "\t\t\t" << (batchedTime.asMicroseconds() > 0 ? perShapeTime / batchedTime : 0.f) << "x\n";
+	}
+}
@@ -0,0 +1,261 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Loads a dedicated server with many matches at once, from bot players that join it as the game does; to find how many matches per core
+ * a machine keeps up with. Each bot is run by its own NetworkManager and BattleSession, on threads of its own, at the game's 60 Hz pace;
+ * it joins the server on the game's port, waits to be paired, and plays until its battle reaches the last tick.
+ * Both players fly a "debug" ship; every few ticks, each alternately moves their ship, or fires on the other. Each bot gives its orders
+ * at its own offset, so no two matches play the same battle.
+ *
+ * Reports:
+ *	Late ticks : How far behind their wall-clock time the bots' ticks ran; the time spent waiting on the other player, through the server.
+ *		If the server cannot keep up, the frames it relays are held up, and this grows.
+ *	Sync : How many bots ended at the same tick, and hash, as another bot; the two players of every match must, with no desync reported.
+ * The tool exits with a failure if any match did not stay in sync, or on an unknown option, or an invalid value. The server must have room for every match, or the bots past it wait.
+ *
+ * Usage: ServerLoadBenchmark [--server=address] [--matches=count] [--ticks=count] [--hull=path] [--order-interval=ticks]
+ */
+#include <algorithm> //For sorting the latencies, and the end states, and std::max.
+#include <iostream> //For reporting the results.
+#include <memory> //For smart pointers.
+#include <string> //For parsing the command line.
+#include <utility> //For std::pair.
+#include <vector> //For the bots.
+
+#include "BattleFixtures.hpp" //For the hull, and the debug ship.
+#include "BattleSession.hpp" //For running each battle.
+#include "CommandLine.hpp" //For parsing the values of options.
+#include "CSB_Functions.hpp" //For the game's default tick.
+#include "NetworkManager.hpp" //For joining the server.
+
+namespace
+{
+	const sf::Time TICK_LENGTH = CSB::tickLength(CSB::DEFAULT_TICK_RATE); //The fixed tick the game runs at.
+	const sf::Time STALL_POLL_INTERVAL = sf::microseconds(250); //How often a battle waiting on its peer checks whether it may carry on.
+	const sf::Time RUN_TIMEOUT = sf::seconds(30); //How long past its wall-clock time a battle may run before it is given up on.
+
+	//One of the bot players; their battle, and its networking.
+	struct Bot
+	{
+		NetworkManager network; //Joins the server, and networks the battle.
+		std::unique_ptr<BattleSimulation> simulation; //The bot's battle.
+		std::unique_ptr<BattleSession> session; //Runs the battle's ticks.
+
+		bool isJoined = false; //Whether the bot was put in a match.
+		std::vector<sf::Time> lateness; //How far behind its wall-clock time each tick ran.
+		std::uint32_t endTick = 0; //The tick the battle ended on.
+		std::uint64_t endHash = 0; //The hash of the battle's state at the end.
+	};
+
+	//Joins the server, waits to be paired, and plays the battle at the game's pace until it reaches the last tick, or finishes.
+	//	bot : The bot.
+	//	index : Number of the bot; offsets when it gives its orders.
+	//	address : The address of the server.
+	//	hullKey : Pristine collision key of the hull the ships are built from.
+	//	ship : The build list of the bot's ship.
+	//	ticks : How many ticks to run.
+	//	orderInterval : How many ticks pass between each order.
+	void runBot(Bot &bot, unsigned int index, const std::string &address, const DamageMask &hullKey, const std::vector<TurretInfo> &ship,
+		std::uint32_t ticks, std::uint32_t orderInterval)
+	{
+		bot.network.setDedicatedServer(true);
+		bot.network.setTurretList(ship);
+
+		if(!bot.network.joinServer(address)) return;
+
+		bot.isJoined = true;
+
+		//The server has decided who plays as the host, and the lockstep settings; so the battle can only be set up now.
+		bot.simulation = std::make_unique<BattleSimulation>(hullKey);
+		bot.session = std::make_unique<BattleSession>(*bot.simulation, &bot.network);
+		bot.session->createLocalShip(ship);
+		bot.network.setBattle(bot.session.get());
+
+		BattleSimulation &simulation = *bot.simulation;
+		BattleSession &session = *bot.session;
+
+		sf::Thread networkThread(&NetworkManager::receive, &bot.network);
+		networkThread.launch();
+		bot.network.sendShip();
+
+		//The wall clock the bot is timed by; started as the battle was.
+		sf::Clock clock;
+		//The tick the last order was given at; so an order is only given once for each tick, however long it waits on the peer.
+		std::uint32_t lastOrderTick = UINT32_MAX;
+
+		while(simulation.getTick() < ticks && !simulation.isFinished())
+		{
+			const std::uint32_t tick = simulation.getTick();
+			//When the tick is due, at the game's pace.
+			const sf::Time due = TICK_LENGTH * static_cast<float>(tick);
+
+			if(clock.getElapsedTime() > due + RUN_TIMEOUT) break;
+
+			if(clock.getElapsedTime() < due) sf::sleep(due - clock.getElapsedTime());
+
+			//Alternately move, and fire on the other player's ship; from the start of the tick the order is given at.
+			if((tick + index) % orderInterval == 0 && tick != lastOrderTick)
+			{
+				//How many orders the bot has given.
+				const std::uint32_t order = (tick + index) / orderInterval;
+				const std::vector<std::unique_ptr<Ship>> &targets = simulation.getShips(1 - session.getLocalLayer());
+				const sf::Vector2f target = targets.empty() ? sf::Vector2f(2000, 2000) : targets.front()->getPosition();
+
+				//A move order, towards a point on a line across the field; so the ships keep moving past each other.
+				const sf::Vector2f moveTarget = sf::Vector2f(1600, 1600) + sf::Vector2f(800, 800) * static_cast<float>(order % 5) / 4.f;
+
+				if(order % 2 == 1) session.queueLocalCommand(CommandType::FIRE, target, 1 - session.getLocalLayer());
+				else session.queueLocalCommand(CommandType::MOVE, moveTarget);
+
+				lastOrderTick = tick;
+			}
+
+			//When the tick started.
+			const sf::Time started = clock.getElapsedTime();
+
+			//Wait on the peer, if they have not marked the tick done.
+			if(!session.update(TICK_LENGTH))
+			{
+				sf::sleep(STALL_POLL_INTERVAL);
+				continue;
+			}
+
+			bot.lateness.push_back(started - due);
+		}
+
+		bot.endTick = simulation.getTick();
+		bot.endHash = simulation.getStateHash();
+
+		//Leaving ends the match on the server; the other player has already been sent every command for the ticks they have left.
+		bot.network.closeAllConnections();
+		networkThread.wait();
+	}
+
+	//Returns the value a fraction of the times are within, in milliseconds.
+	//	times : The times; sorted.
+	//	fraction : The fraction of the times.
+	double percentile(const std::vector<sf::Time> &times, double fraction)
+	{
+		if(times.empty()) return 0;
+
+		return times[std::min(times.size() - 1, static_cast<std::size_t>(fraction * times.size()))].asMicroseconds() / 1000.0;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	//The address of the server.
+	std::string address = "127.0.0.1";
+	//How many matches to play at once.
+	unsigned int matchCount = 16;
+	//How many ticks each battle runs for; thirty seconds by default.
+	std::uint32_t ticks = 1800;
+	//Where to load the hull from; the server must use the same hull.
+	std::string hullPath = "Assets/hull.png";
+	//How many ticks pass between each order a bot gives.
+	std::uint32_t orderInterval = 6;
+	//Whether every option's value was valid.
+	bool isValid = true;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string option = argv[i];
+
+		if(option.compare(0, 9, "--server=") == 0) address = option.substr(9);
+		else if(option.compare(0, 10, "--matches=") == 0) isValid &= CSB::parseOption(option, 10, matchCount);
+		else if(option.compare(0, 8, "--ticks=") == 0) isValid &= CSB::parseOption(option, 8, ticks);
+		else if(option.compare(0, 7, "--hull=") == 0) hullPath = option.substr(7);
+		else if(option.compare(0, 17, "--order-interval=") == 0) isValid &= CSB::parseOption(option, 17, orderInterval);
+		else
+		{
+			std::cerr << "Unknown option: " << option << std::endl;
+			return 1;
+		}
+	}
+
+	if(!isValid) return 1;
+
+	//At least one tick between orders.
+	orderInterval = std::max<std::uint32_t>(orderInterval, 1);
+
+	//Image of the hull every ship is built from.
+	sf::Image hullImage;
+	if(!Fixtures::loadHullImage(hullPath, hullImage)) return 1;
+
+	//Collision key of the hull; built once, and shared by every battle.
+	const DamageMask hullKey = Ship::createPristineKey(hullImage);
+	const std::vector<TurretInfo> debugShip = Fixtures::buildDebugShip(hullImage.getSize());
+
+	std::cout << matchCount << " matches of " << ticks << " ticks, on " << address << std::endl;
+
+	//Two bots to every match.
+	std::vector<std::unique_ptr<Bot>> bots;
+	std::vector<std::unique_ptr<sf::Thread>> threads;
+
+	for(unsigned int i = 0; i < matchCount * 2; ++i)
+	{
+		bots.push_back(std::make_unique<Bot>());
+
+		Bot &bot = *bots.back();
+
+		threads.push_back(std::make_unique<sf::Thread>([&bot, i, &address, &hullKey, &debugShip, ticks, orderInterval]()
+		{
+			runBot(bot, i, address, hullKey, debugShip, ticks, orderInterval);
+		}));
+		threads.back()->launch();
+	}
+
+	for(auto &thread : threads)
+	{
+		thread->wait();
+	}
+
+	//How far behind their time the bots' ticks ran.
+	std::vector<sf::Time> lateness;
+	//The tick, and hash, each bot that joined ended on; the two players of a match end on the same.
+	std::vector<std::pair<std::uint32_t, std::uint64_t>> endStates;
+	//How many bots joined, and how many reported a desync.
+	std::size_t joined = 0, desynced = 0;
+
+	for(const auto &bot : bots)
+	{
+		if(!bot->isJoined) continue;
+
+		++joined;
+
+		if(bot->session->isDesynced()) ++desynced;
+
+		lateness.insert(lateness.end(), bot->lateness.begin(), bot->lateness.end());
+		endStates.emplace_back(bot->endTick, bot->endHash);
+	}
+
+	std::sort(lateness.begin(), lateness.end());
+	std::sort(endStates.begin(), endStates.end());
+
+	//How many bots ended on the same tick, and hash, as another bot; every match played a battle of its own, so only its players match.
+	std::size_t paired = 0;
+
+	for(std::size_t i = 0; i + 1 < endStates.size();)
+	{
+		if(endStates[i] == endStates[i + 1])
+		{
+			paired += 2;
+			i += 2;
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	std::cout << "Late ticks: p50 " << percentile(lateness, 0.5) << " ms, p99 " << percentile(lateness, 0.99) << " ms, max "
+		<< percentile(lateness, 1) << " ms, over " << lateness.size() << "\n";
+	std::cout << joined << " of " << bots.size() << " bots joined; " << paired << " ended in sync with their match, " << desynced
+		<< " reported a desync\n";
+
+	const bool isInSync = joined == bots.size() && paired == joined && desynced == 0;
+
+	std::cout << (isInSync ? "Every match in sync" : "Matches diverged") << std::endl;
+
+	return isInSync ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Measures the transform inversion work removed by caching a ship's transforms once per tick, on a fully loaded "debug" ship.
+ * Each tick the ship turns, every turret aims at a target, and a number of projectiles are tested against the ship;
+ * each projectile test converts the start and end of the projectile's path to the ship's pixels, as firstPixelHit does.
+ * The per-query path inverts the transform for every conversion, as the ship and turrets used to; the cached path uses the ship's tick inverse.
+ *
+ * Usage: TransformBenchmark [ticks] [projectiles tested per tick] [hull image path]
+ */
+#include <iostream> //For reporting the results.
+#include <string> //For parsing the command line.
+
+#include "BattleFixtures.hpp" //For the hull, and the debug ship.
+#include "Ship.hpp" //The ship being measured.
+
+namespace
+{
+	//Runs the ship for the passed amount of ticks, converting points to the ship's pixels with the passed function.
+	//	ship : The ship being measured; turned a little every tick, so its transform always changes.
+	//	ticks : How many ticks to run.
+	//	projectilesPerTick : How many projectiles are tested against the ship each tick.
+	//	toPixel : Converts a global point to the ship's pixels.
+	//Returns the time taken, and a checksum of the points; so the work can not be optimised away.
+	template<typename ToPixelFunction>
+	std::pair<sf::Time, float> runTicks(Ship &ship, unsigned long ticks, unsigned int projectilesPerTick, ToPixelFunction toPixel)
+	{
+		//Sum of every converted point.
+		float checksum = 0;
+		sf::Clock clock;
+
+		for(unsigned long tick = 0; tick < ticks; ++tick)
+		{
+			ship.rotate(0.5f);
+			ship.updateTickTransforms();
+
+			//Every turret converts its target to the ship's local co-ordinates to aim.
+			for(std::size_t turret = 0; turret < ship.getTurretCount(); ++turret)
+			{
+				checksum += toPixel(ship, sf::Vector2f(2000.f, 2000.f + turret)).x;
+			}
+
+			//Each projectile converts the start, and end, of its path.
+			for(unsigned int projectile = 0; projectile < projectilesPerTick; ++projectile)
+			{
+				const sf::Vector2f endPosition = ship.getPosition() + sf::Vector2f(static_cast<float>(projectile % 64), 0);
+
+				checksum += toPixel(ship, endPosition - sf::Vector2f(16.f, 0)).x;
+				checksum += toPixel(ship, endPosition).y;
+			}
+		}
+
+		return {clock.getElapsedTime(), checksum};
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	//How many ticks each run lasts.
+	const unsigned long ticks = argc > 1 ? std::stoul(argv[1]) : 100000;
+	//How many projectiles are tested against the ship each tick.
+	const unsigned int projectilesPerTick = argc > 2 ? std::stoul(argv[2]) : 64;
+	//Where to load the hull from.
+	const std::string hullPath = argc > 3 ? argv[3] : "Assets/hull.png";
+
+	//Image of the hull the ship is built from.
+	sf::Image hullImage;
+	if(!Fixtures::loadHullImage(hullPath, hullImage)) return 1;
+
+	//A fully loaded ship, without textures, so it never touches the GPU.
+	const DamageMask hullKey = Ship::createPristineKey(hullImage);
+	Ship ship({2000, 2000}, 0, Fixtures::buildDebugShip(hullImage.getSize()), hullKey);
+
+	//Inverts the ship's transform for every conversion; as the ship and turrets did before caching.
+	const auto perQuery = runTicks(ship, ticks, projectilesPerTick, [](const Ship &ship, const sf::Vector2f &point)
+	{
+		return ship.getTransform().getInverse().transformPoint(point);
+	});
+
+	//Uses the inverse the ship cached for this tick.
+	const auto cached = runTicks(ship, ticks, projectilesPerTick, [](const Ship &ship, const sf::Vector2f &point)
+	{
+		return ship.getTickInverseTransform().transformPoint(point);
+	});
+
+	//Inversions done each tick; the cached path only inverts when the ship updates.
+	const std::size_t perQueryInversions = ship.getTurretCount() + 2 * projectilesPerTick;
+
+	std::cout << "Turrets: " << ship.getTurretCount() << ", projectiles tested per tick: " << projectilesPerTick << "\n";
+	std::cout << "Inversions per tick: " << perQueryInversions << " per-query, 1 cached\n";
+	std::cout << "Per-query: " << perQuery.first.asMicroseconds() * 1000.0 / ticks << " ns/tick\n";
+	std::cout << "Cached: " << cached.first.asMicroseconds() * 1000.0 / ticks << " ns/tick\n";
+	std::cout << "Checksums: " << perQuery.second << " / " << cached.second << std::endl;
+}
@@ -0,0 +1,112 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Measures contention on the turret locks; N fully loaded "debug" ships are each updated, and snapshotted, on their own thread.
+ * With a lock per ship the threads never wait on each other; the shared run also takes one process-wide mutex around each ship's work,
+ * as every ship did when the turret mutex was global. The ships are only moved, so no projectiles are fired.
+ *
+ * Usage: TurretLockBenchmark [ticks] [max threads] [hull image path]
+ */
+#include <algorithm> //For std::min, and std::max.
+#include <iostream> //For reporting the results.
+#include <string> //For parsing the command line.
+#include <thread> //For the hardware thread count.
+
+#include "BattleFixtures.hpp" //For the hull, and the debug ship.
+#include "CSB_Functions.hpp" //For the game's default tick.
+#include "Ship.hpp" //The ships being measured.
+
+namespace
+{
+	//Runs one ship per thread for the passed amount of ticks; each tick the ship is updated, and a render snapshot taken of it.
+	//	hullKey : Pristine key the ships are built from.
+	//	turretList : The turrets every ship is built with.
+	//	threadCount : How many ships, and threads, to run.
+	//	ticks : How many ticks each ship is run for.
+	//	sharedMutex : Mutex every thread locks around each ship's work; nullptr to rely on the ships' own locks.
+	//Returns the wall time taken for every thread to finish.
+	sf::Time runThreads(const DamageMask &hullKey, const std::vector<TurretInfo> &turretList, unsigned int threadCount,
+		unsigned long ticks, sf::Mutex *sharedMutex)
+	{
+		std::vector<std::unique_ptr<Ship>> ships;
+		std::vector<std::unique_ptr<sf::Thread>> threads;
+
+		for(unsigned int i = 0; i < threadCount; ++i)
+		{
+			ships.push_back(std::make_unique<Ship>(sf::Vector2f(2000.f, 2000.f), 0.f, turretList, hullKey));
+			//Send the ship towards a distant point; it turns, then moves, so its transform changes every tick.
+			ships.back()->moveCommand({2000.f, 1000000.f});
+		}
+
+		for(auto &ship : ships)
+		{
+			threads.push_back(std::make_unique<sf::Thread>([&ship, ticks, sharedMutex]()
+			{
+				//The snapshot the ship is copied into each tick; reused, as it would be by the triple buffer.
+				ShipSnapshot snapshot;
+
+				for(unsigned long tick = 0; tick < ticks; ++tick)
+				{
+					if(sharedMutex) sharedMutex->lock();
+
+					ship->update(CSB::tickLength(CSB::DEFAULT_TICK_RATE));
+					ship->fillSnapshot(snapshot);
+
+					if(sharedMutex) sharedMutex->unlock();
+				}
+			}));
+		}
+
+		sf::Clock clock;
+
+		for(auto &thread : threads)
+		{
+			thread->launch();
+		}
+
+		for(auto &thread : threads)
+		{
+			thread->wait();
+		}
+
+		return clock.getElapsedTime();
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	//How many ticks each ship is run for.
+	const unsigned long ticks = argc > 1 ? std::stoul(argv[1]) : 20000;
+	//The most threads to run at once; each run doubles the threads until it is reached.
+	const unsigned int maxThreads = argc > 2 ? std::stoul(argv[2]) : std::max(std::thread::hardware_concurrency(), 1u);
+	//Where to load the hull from.
+	const std::string hullPath = argc > 3 ? argv[3] : "Assets/hull.png";
+
+	//Image of the hull every ship is built from.
+	sf::Image hullImage;
+	if(!Fixtures::loadHullImage(hullPath, hullImage)) return 1;
+
+	const DamageMask hullKey = Ship::createPristineKey(hullImage);
+	const std::vector<TurretInfo> turretList = Fixtures::buildDebugShip(hullImage.getSize());
+	//Stands in for the old process-wide turret mutex.
+	sf::Mutex sharedMutex;
+
+	std::cout << "Turrets per ship: " << turretList.size() << ", ticks per ship: " << ticks << "\n";
+
+	//Double the threads each run, finishing on the most threads.
+	for(unsigned int threadCount = 1;; threadCount = std::min(threadCount * 2, maxThreads))
+	{
+		const sf::Time shared = runThreads(hullKey, turretList, threadCount, ticks, &sharedMutex);
+		const sf::Time perShip = runThreads(hullKey, turretList, threadCount, ticks, nullptr);
+
+		//Ship ticks completed per second, across every thread.
+		const double shipTicks = static_cast<double>(ticks) * threadCount;
+
+		std::cout << threadCount << " threads: shared lock " << shipTicks / shared.asSeconds() << " ship ticks/s, "
+			<< "per-ship locks " << shipTicks / perShip.asSeconds() << " ship ticks/s\n";
+
+		if(threadCount == maxThreads) break;
+	}
+
+	std::cout << std::flush;
+}
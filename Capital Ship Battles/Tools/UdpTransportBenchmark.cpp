@@ -0,0 +1,233 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Checks, and times, the UDP transport's reliability layer over real UDP sockets on loopback, with loss and latency injected on send.
+ * Two peers send each other a handshake, then a frame of input every tick, as a lockstep battle does.
+ * The frames are sent twice over; once on the redundant stream, as the battle sends them, and once on the reliable stream,
+ * which only resends after a timeout, as TCP does; so the tail latency of the two may be compared over the same link.
+ * Every message must arrive whole, once, and in order; the tool exits with a failure otherwise.
+ *
+ * Usage: UdpTransportBenchmark [ticks] [loss percent] [latency milliseconds] [jitter milliseconds]
+ */
+#include <algorithm> //For sorting the latencies.
+#include <iostream> //For reporting the results.
+#include <string> //For parsing the command line.
+#include <vector> //For the latencies.
+
+#include <SFML/Network.hpp> //For the sockets.
+
+#include "CSB_Functions.hpp" //For the game's default tick.
+#include "UdpChannel.hpp" //The layer being checked.
+
+namespace
+{
+	const sf::Time TICK_INTERVAL = CSB::tickLength(CSB::DEFAULT_TICK_RATE); //How often each peer sends a frame; the game's default tick rate.
+	const sf::Time DRAIN_TIMEOUT = sf::seconds(5); //How long the peers are given to deliver everything, after the last tick.
+	const std::size_t UDP_HEADER_SIZE = 28; //Bytes of the IP, and UDP, headers of every datagram; counted in the bandwidth.
+
+	//One end of the link; a socket, with the channel, and the impairment, of what it sends.
+	struct Peer
+	{
+		sf::UdpSocket socket; //The peer's socket, on loopback.
+		UdpChannel channel; //The reliability layer.
+		ImpairedLink link; //Drops, and delays, what the peer sends.
+
+		std::vector<std::uint8_t> handshake; //The handshake received; empty until it arrives.
+		std::uint64_t framesReceived = 0; //How many frames have been received; also the tick of the next frame expected.
+		std::vector<sf::Time> latencies; //How long each frame took to arrive, from the tick it was sent.
+		bool isInOrder = true; //Whether every message arrived whole, once, and in order.
+
+		std::size_t bytesSent = 0; //Bytes of every datagram sent, with its headers.
+		std::size_t datagramsSent = 0; //How many datagrams were sent.
+	};
+
+	//Sends whatever the peer's channel has due, and lets through whatever the link has due.
+	//	peer : The peer sending.
+	//	port : The port of the other peer.
+	//	now : The current time.
+	void sendDue(Peer &peer, unsigned short port, const sf::Time &now)
+	{
+		std::vector<std::uint8_t> datagram;
+
+		if(peer.channel.writeDatagram(now, datagram))
+		{
+			//Counted as sent even if the link drops it; the bandwidth is what the peer sends.
+			peer.bytesSent += datagram.size() + UDP_HEADER_SIZE;
+			++peer.datagramsSent;
+
+			peer.link.send(std::move(datagram), now);
+		}
+
+		while(peer.link.takeDue(now, datagram))
+		{
+			peer.socket.send(datagram.data(), datagram.size(), sf::IpAddress::LocalHost, port);
+		}
+	}
+
+	//Reads every datagram waiting on the peer's socket, and checks every message they deliver.
+	//	peer : The peer receiving.
+	//	now : The current time.
+	//	isRedundant : Whether frames are sent on the redundant stream; otherwise, the reliable stream.
+	//	sendTimes : When each tick's frame was sent.
+	void receiveAll(Peer &peer, const sf::Time &now, bool isRedundant, const std::vector<sf::Time> &sendTimes)
+	{
+		std::vector<std::uint8_t> buffer(sf::UdpSocket::MaxDatagramSize), message;
+		std::size_t received;
+		sf::IpAddress address;
+		unsigned short port;
+
+		while(peer.socket.receive(buffer.data(), buffer.size(), received, address, port) == sf::Socket::Done)
+		{
+			if(!peer.channel.readDatagram(buffer.data(), received, now)) peer.isInOrder = false;
+		}
+
+		//The handshake is always the first message on the reliable stream.
+		if(peer.handshake.empty() && peer.channel.takeReliable(message)) peer.handshake = message;
+
+		while(isRedundant ? peer.channel.takeRedundant(message) : peer.channel.takeReliable(message))
+		{
+			WireReader reader(message.data(), message.size());
+			const std::uint64_t tick = reader.readVarint();
+
+			reader.readVarint();
+
+			if(!reader.isValid() || !reader.isAtEnd() || tick != peer.framesReceived)
+			{
+				peer.isInOrder = false;
+				continue;
+			}
+
+			peer.latencies.push_back(now - sendTimes[peer.framesReceived++]);
+		}
+	}
+
+	//Returns the latency a fraction of the frames arrived within.
+	//	latencies : How long each frame took to arrive; sorted.
+	//	fraction : The fraction of the frames.
+	double percentile(const std::vector<sf::Time> &latencies, double fraction)
+	{
+		if(latencies.empty()) return 0;
+
+		return latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(fraction * latencies.size()))].asMicroseconds() / 1000.0;
+	}
+
+	//Sends a handshake, and a frame each tick, both ways between two peers; then reports, and checks, what arrived.
+	//	ticks : How many ticks to send a frame for.
+	//	impairment : How badly the link drops, and delays, datagrams each way.
+	//	isRedundant : Whether frames are sent on the redundant stream; otherwise, the reliable stream.
+	//Returns whether everything arrived whole, once, and in order.
+	bool run(unsigned int ticks, const LinkImpairment &impairment, bool isRedundant)
+	{
+		Peer peers[2];
+
+		for(unsigned int i = 0; i < 2; ++i)
+		{
+			if(peers[i].socket.bind(sf::Socket::AnyPort, sf::IpAddress::LocalHost) != sf::Socket::Done)
+			{
+				std::cout << "Could not bind a socket on loopback\n";
+				return false;
+			}
+
+			peers[i].socket.setBlocking(false);
+			//The same seeds for both runs; so both see the same losses, and delays, for the datagrams they send.
+			peers[i].link = ImpairedLink(i + 1);
+			peers[i].link.setImpairment(impairment);
+		}
+
+		//A handshake the size of a ship of 16 turrets.
+		const std::vector<std::uint8_t> handshake(85, 0x5a);
+		//When each tick's frame was sent; the same for both peers.
+		std::vector<sf::Time> sendTimes;
+
+		sf::Clock clock;
+
+		for(Peer &peer : peers)
+		{
+			peer.channel.sendReliable(handshake);
+		}
+
+		//Send a frame each tick, then keep going until everything has arrived, and been acknowledged; or the peers give up.
+		while(true)
+		{
+			const sf::Time now = clock.getElapsedTime();
+
+			if(sendTimes.size() < ticks && now >= TICK_INTERVAL * static_cast<float>(sendTimes.size()))
+			{
+				//The frame of a lockstep tick with no commands; its tick, and no messages.
+				WireWriter frame;
+				frame.writeVarint(sendTimes.size());
+				frame.writeVarint(0);
+
+				sendTimes.push_back(now);
+
+				for(Peer &peer : peers)
+				{
+					isRedundant ? peer.channel.sendRedundant(frame.getBytes()) : peer.channel.sendReliable(frame.getBytes());
+				}
+			}
+
+			for(unsigned int i = 0; i < 2; ++i)
+			{
+				sendDue(peers[i], peers[1 - i].socket.getLocalPort(), now);
+				receiveAll(peers[i], now, isRedundant, sendTimes);
+			}
+
+			const bool isDone = sendTimes.size() == ticks && peers[0].framesReceived == ticks && peers[1].framesReceived == ticks
+				&& peers[0].channel.isAcknowledged() && peers[1].channel.isAcknowledged();
+
+			if(isDone || now > TICK_INTERVAL * static_cast<float>(ticks) + DRAIN_TIMEOUT) break;
+
+			sf::sleep(sf::milliseconds(1));
+		}
+
+		bool isCorrect = true;
+		std::vector<sf::Time> latencies;
+		std::size_t bytesSent = 0, datagramsSent = 0;
+
+		for(Peer &peer : peers)
+		{
+			isCorrect &= peer.isInOrder && peer.handshake == handshake && peer.framesReceived == ticks;
+			latencies.insert(latencies.end(), peer.latencies.begin(), peer.latencies.end());
+			bytesSent += peer.bytesSent;
+			datagramsSent += peer.datagramsSent;
+		}
+
+		std::sort(latencies.begin(), latencies.end());
+
+		std::cout << (isRedundant ? "Redundant" : "Resend on timeout") << ": latency p50 " << percentile(latencies, 0.5)
+			<< " ms, p99 " << percentile(latencies, 0.99) << " ms, max " << percentile(latencies, 1)
+			<< " ms; " << static_cast<double>(bytesSent) / (2 * ticks) << " bytes, and " << static_cast<double>(datagramsSent) / (2 * ticks)
+			<< " datagrams, per tick each way; round trip " << peers[0].channel.getRoundTrip().asMicroseconds() / 1000.0 << " ms; "
+			<< (isCorrect ? "all delivered in order" : "DELIVERY FAILED") << "\n";
+
+		return isCorrect;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	//How many ticks a frame is sent for, and how badly the link is impaired.
+	const unsigned int ticks = argc > 1 ? std::stoul(argv[1]) : 360;
+	LinkImpairment impairment;
+	impairment.lossRate = (argc > 2 ? std::stof(argv[2]) : 5.f) / 100.f;
+	impairment.latency = sf::milliseconds(argc > 3 ? std::stoi(argv[3]) : 20);
+	impairment.jitter = sf::milliseconds(argc > 4 ? std::stoi(argv[4]) : 5);
+
+	std::cout << ticks << " ticks at " << impairment.lossRate * 100 << "% loss, " << impairment.latency.asMilliseconds() << " ms latency, and "
+		<< impairment.jitter.asMilliseconds() << " ms jitter each way\n";
+
+	//Whether every check passed.
+	bool isCorrect = true;
+
+	//A malformed datagram must be ignored whole; here, a message that claims more bytes than the datagram holds.
+	UdpChannel channel;
+	const std::uint8_t malformed[] = {0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x10, 0x01};
+	isCorrect &= !channel.readDatagram(malformed, sizeof(malformed), sf::Time::Zero);
+
+	isCorrect &= run(ticks, impairment, true);
+	isCorrect &= run(ticks, impairment, false);
+
+	std::cout << (isCorrect ? "All checks passed" : "CHECKS FAILED") << std::endl;
+
+	return isCorrect ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+/*
+ * Author: George Mostyn-Parry
+ *
+ * Times the wire format packets are sent between peers in; the golden bytes, and round trips, are checked by Tests/WireFormatTest.
+ * Encoding and decoding random commands are timed, and the size of each compared against the packet the first format sent.
+ *
+ * Usage: WireFormatBenchmark [packets]
+ */
+#include <cstdint> //For the decoded ships.
+#include <iostream> //For reporting the results.
+#include <random> //For the commands timed.
+#include <string> //For parsing the command line.
+#include <vector> //For the encoded commands.
+
+#include <SFML/System.hpp> //For timing.
+
+#include "BattleFixtures.hpp" //For the debug ship.
+#include "WireFormat.hpp" //The format being timed.
+
+int main(int argc, char *argv[])
+{
+	//How many commands are encoded, and decoded, for the timing.
+	const unsigned long packets = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+	//Random commands to time; quantised, as the sender does.
+	std::mt19937 random(20190301);
+	std::uniform_real_distribution<float> field(0, 4000);
+	std::vector<BattleCommand> commands(1024);
+
+	for(auto &command : commands)
+	{
+		command.shipID = random() % 4;
+		command.position = Wire::quantiseFieldPosition({field(random), field(random)});
+	}
+
+	//Encode each command once; the decode is timed on these.
+	std::vector<std::vector<std::uint8_t>> encoded;
+
+	WireWriter writer;
+
+	for(const auto &command : commands)
+	{
+		writer.clear();
+		writer.writeCommand(command);
+		encoded.push_back(writer.getBytes());
+	}
+
+	//Bytes of every message encoded, with its type; summed so the loops are not optimised away.
+	std::size_t encodedBytes = 0;
+
+	sf::Clock clock;
+
+	for(unsigned long i = 0; i < packets; ++i)
+	{
+		writer.clear();
+		writer.writeCommand(commands[i % commands.size()]);
+		encodedBytes += writer.getBytes().size() + 1;
+	}
+
+	const sf::Time encodeTime = clock.restart();
+
+	//Ship of every command decoded; summed so the loop is not optimised away.
+	std::uint64_t decodedShips = 0;
+
+	for(unsigned long i = 0; i < packets; ++i)
+	{
+		const std::vector<std::uint8_t> &bytes = encoded[i % commands.size()];
+		WireReader reader(bytes.data(), bytes.size());
+		BattleCommand decoded;
+		reader.readCommand(decoded);
+		decodedShips += decoded.shipID;
+	}
+
+	const sf::Time decodeTime = clock.getElapsedTime();
+
+	//The build state's debug ship on a 128 pixel hull; the most turrets the hull fits.
+	BattleCommand ship;
+	ship.type = CommandType::CREATE_SHIP;
+	ship.position = {1800, 1800};
+	ship.angle = 45;
+	ship.turrets = Fixtures::buildDebugShip({128, 128});
+
+	writer.clear();
+	writer.writeCommand(ship);
+
+	//Bytes of the ship encoded, with its type and version; the settings sent before it are left out, as both formats send them.
+	const std::size_t shipBytes = writer.getBytes().size() + 2;
+
+	std::cout << "Command encode: " << encodeTime.asMicroseconds() * 1000.0 / packets << " ns, decode: "
+		<< decodeTime.asMicroseconds() * 1000.0 / packets << " ns (ship sum " << decodedShips << ")\n";
+
+	//The first format sent a packet per command, of a type byte, 32 bit tick and ship, and 32 bit floats;
+	//and for a ship, a 32 bit count, and a byte and two floats per turret. A frame adds its header once per tick, however many commands it holds.
+	std::cout << "Move, or fire, command: " << static_cast<double>(encodedBytes) / packets << " bytes, and about 3 per frame, previously 17\n";
+	std::cout << "Ship of " << ship.turrets.size() << " turrets: " << shipBytes << " bytes, previously " << 1 + 12 + 4 + ship.turrets.size() * 9
+		<< std::endl;
+}